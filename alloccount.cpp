@@ -0,0 +1,76 @@
+#include "alloccount.h"
+#include <SDL2/SDL.h>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t allocations = 0;
+
+SDL_malloc_func sdlMalloc = nullptr;
+SDL_calloc_func sdlCalloc = nullptr;
+SDL_realloc_func sdlRealloc = nullptr;
+SDL_free_func sdlFree = nullptr;
+
+void* SDLCALL countedMalloc(size_t size) {
+    allocations++;
+    return sdlMalloc(size);
+}
+
+void* SDLCALL countedCalloc(size_t count, size_t size) {
+    allocations++;
+    return sdlCalloc(count, size);
+}
+
+void* SDLCALL countedRealloc(void* memory, size_t size) {
+    allocations++;
+    return sdlRealloc(memory, size);
+}
+
+void SDLCALL forwardFree(void* memory) {
+    sdlFree(memory);
+}
+
+void* allocate(size_t size) {
+    allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+}
+
+uint64_t threadAllocationCount() {
+    return allocations;
+}
+
+void installSdlAllocationHook() {
+    if (sdlMalloc) return;
+    SDL_GetMemoryFunctions(&sdlMalloc, &sdlCalloc, &sdlRealloc, &sdlFree);
+    SDL_SetMemoryFunctions(countedMalloc, countedCalloc, countedRealloc, forwardFree);
+}
+
+void* operator new(size_t size) {
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size) {
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { std::free(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { std::free(p); }
@@ -0,0 +1,15 @@
+#ifndef ALLOCCOUNT_H
+#define ALLOCCOUNT_H
+
+#include <cstdint>
+
+// Heap allocations made by the calling thread so far: every global operator
+// new, plus SDL_malloc/calloc/realloc once installSdlAllocationHook() has
+// run. Frees are not counted. Diff two readings around a frame to see
+// whether it touched the allocator.
+uint64_t threadAllocationCount();
+
+// Must run before SDL_Init so every SDL allocation goes through the hook.
+void installSdlAllocationHook();
+
+#endif
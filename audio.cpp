@@ -0,0 +1,259 @@
+#include "audio.h"
+#include "config.h"
+#include <iostream>
+#include <algorithm>
+#include <vector>
+#include <cstdlib>
+
+namespace {
+
+bool isOneShot(SoundType type) {
+    return type != SoundType::WarningStart && type != SoundType::WarningStop && type != SoundType::StopAll;
+}
+
+}
+
+int audioChunkSizeFor(AudioLatencyMode mode) {
+    switch (mode) {
+        case AudioLatencyMode::Low: return AUDIO_CHUNK_SIZE_LOW;
+        case AudioLatencyMode::Lowest: return AUDIO_CHUNK_SIZE_LOWEST;
+        default: return AUDIO_CHUNK_SIZE;
+    }
+}
+
+const char* audioLatencyName(AudioLatencyMode mode) {
+    switch (mode) {
+        case AudioLatencyMode::Low: return "Low";
+        case AudioLatencyMode::Lowest: return "Lowest";
+        default: return "Standard";
+    }
+}
+
+AudioDevice::AudioDevice()
+    : opened(false), currentMode(AudioLatencyMode::Standard),
+      frequency(AUDIO_FREQUENCY), outputChannels(AUDIO_CHANNELS), format(MIX_DEFAULT_FORMAT),
+      lateThreshold(0), windowStart(0),
+      lastCallback(0), lateCallbacks(0), totalLateCallbacks(0),
+      probeArmed(false), probeFound(false), probeMixedAt(0), probeFrameOffset(0),
+      callbackCount(0), mixBuffers(0), mixTicksTotal(0), mixTicksWorst(0), tickMask(0) {}
+
+AudioDevice::~AudioDevice() {
+    close();
+}
+
+bool AudioDevice::open(AudioLatencyMode requested) {
+    close();
+
+    AudioLatencyMode tryMode = requested;
+    while (true) {
+        if (Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, AUDIO_CHANNELS, audioChunkSizeFor(tryMode)) == 0) break;
+        std::cerr << "Mix_OpenAudio failed with " << audioChunkSizeFor(tryMode) << " frame buffer: " << Mix_GetError() << std::endl;
+        if (tryMode == AudioLatencyMode::Standard) return false;
+        tryMode = static_cast<AudioLatencyMode>(static_cast<int>(tryMode) - 1);
+    }
+
+    opened = true;
+    currentMode = tryMode;
+    Mix_QuerySpec(&frequency, &format, &outputChannels);
+    Mix_AllocateChannels(AUDIO_MIX_CHANNELS);
+    if (format != AUDIO_S16SYS) std::cerr << "Audio device is not 16-bit, game sounds are disabled." << std::endl;
+
+    // The device asks for one buffer per period; a gap of several periods
+    // means it played out everything it had and went silent in between.
+    Uint64 periodTicks = SDL_GetPerformanceFrequency() * audioChunkSizeFor(currentMode) / std::max(frequency, 1);
+    lateThreshold = static_cast<Uint64>(periodTicks * AUDIO_LATE_CALLBACK_FACTOR);
+    lastCallback = 0;
+    lateCallbacks = 0;
+    windowStart = SDL_GetTicks();
+    soundQueue.clear();
+    mixer.reset();
+    tickMask = 0;
+    resetMixStats();
+    Mix_SetPostMix(postMix, this);
+
+    std::cout << "Audio opened: " << frequency << " Hz, " << audioChunkSizeFor(currentMode) << " frames ("
+              << bufferMs() << " ms)" << std::endl;
+    return true;
+}
+
+void AudioDevice::close() {
+    if (!opened) return;
+    Mix_SetPostMix(nullptr, nullptr);
+    Mix_CloseAudio();
+    opened = false;
+
+    AudioMixStats stats = mixStats();
+    if (stats.buffers > 0) {
+        std::cout << "Sound mixer: " << stats.buffers << " buffers, avg " << stats.averageUs << " us, worst "
+                  << stats.worstUs << " us of " << stats.budgetUs << " us, peak " << stats.peakVoices << " voices, "
+                  << stats.stolenVoices << " stolen, " << stats.droppedSounds << " dropped" << std::endl;
+    }
+}
+
+double AudioDevice::bufferMs() const {
+    return 1000.0 * audioChunkSizeFor(currentMode) / std::max(frequency, 1);
+}
+
+bool AudioDevice::fallBackIfUnderrunning() {
+    if (!opened) return false;
+
+    Uint32 now = SDL_GetTicks();
+    if (now - windowStart < AUDIO_UNDERRUN_WINDOW_MS) {
+        if (lateCallbacks.load() < AUDIO_UNDERRUN_LIMIT) return false;
+    } else {
+        windowStart = now;
+        if (lateCallbacks.exchange(0) < AUDIO_UNDERRUN_LIMIT) return false;
+    }
+    if (currentMode == AudioLatencyMode::Standard) {
+        lateCallbacks = 0;
+        return false;
+    }
+
+    AudioLatencyMode larger = static_cast<AudioLatencyMode>(static_cast<int>(currentMode) - 1);
+    std::cerr << "Audio underruns with " << chunkSize() << " frame buffer, falling back to "
+              << audioChunkSizeFor(larger) << std::endl;
+    return open(larger);
+}
+
+void AudioDevice::post(SoundType type, Mix_Chunk* chunk) {
+    if (!opened) return;
+    if (isOneShot(type)) {
+        if (!chunk) return;
+        uint32_t bit = 1u << static_cast<int>(type);
+        if (tickMask & bit) return;
+        tickMask |= bit;
+    }
+    soundQueue.push(SoundEvent{type, chunk});
+}
+
+void AudioDevice::endTick() {
+    tickMask = 0;
+}
+
+AudioMixStats AudioDevice::mixStats() const {
+    AudioMixStats stats = {};
+    double tickUs = 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+    stats.buffers = static_cast<int>(mixBuffers.load());
+    if (stats.buffers > 0) stats.averageUs = mixTicksTotal.load() * tickUs / stats.buffers;
+    stats.worstUs = mixTicksWorst.load() * tickUs;
+    stats.budgetUs = bufferMs() * 1000.0;
+    stats.peakVoices = mixer.peakVoices();
+    stats.stolenVoices = mixer.stolenVoices();
+    stats.droppedSounds = mixer.droppedSounds();
+    return stats;
+}
+
+void AudioDevice::resetMixStats() {
+    mixBuffers = 0;
+    mixTicksTotal = 0;
+    mixTicksWorst = 0;
+}
+
+bool AudioDevice::waitForCallbacks(Uint32 count) {
+    Uint32 target = callbackCount.load() + count;
+    Uint32 deadline = SDL_GetTicks() + AUDIO_PROBE_TIMEOUT_MS;
+    while (static_cast<int32_t>(callbackCount.load() - target) < 0) {
+        if (SDL_GetTicks() >= deadline) return false;
+        SDL_Delay(1);
+    }
+    return true;
+}
+
+void SDLCALL AudioDevice::postMix(void* userdata, Uint8* stream, int len) {
+    AudioDevice* self = static_cast<AudioDevice*>(userdata);
+    Uint64 now = SDL_GetPerformanceCounter();
+
+    Uint64 previous = self->lastCallback.exchange(now);
+    if (previous != 0 && now - previous > self->lateThreshold) {
+        self->lateCallbacks++;
+        self->totalLateCallbacks++;
+    }
+
+    if (self->format != AUDIO_S16SYS) {
+        self->callbackCount++;
+        return;
+    }
+
+    Sint16* samples = reinterpret_cast<Sint16*>(stream);
+    int count = len / static_cast<int>(sizeof(Sint16));
+    SoundEvent event;
+    while (self->soundQueue.pop(event)) self->mixer.play(event);
+    self->mixer.mix(samples, count);
+
+    Uint64 spent = SDL_GetPerformanceCounter() - now;
+    self->mixBuffers++;
+    self->mixTicksTotal += spent;
+    if (spent > self->mixTicksWorst.load()) self->mixTicksWorst = spent;
+    self->callbackCount++;
+
+    if (!self->probeArmed.load()) return;
+    for (int i = 0; i < count; ++i) {
+        if (std::abs(samples[i]) >= AUDIO_PROBE_THRESHOLD) {
+            self->probeFrameOffset = i / std::max(self->outputChannels, 1);
+            self->probeMixedAt = now;
+            self->probeArmed = false;
+            self->probeFound = true;
+            return;
+        }
+    }
+}
+
+// Queues a short full-scale pulse the way game sounds are queued, on an
+// otherwise silent mixer, and times how long it takes to show up in the
+// output stream. The post-mix hook runs when the buffer is handed to the
+// device, so the reported figure adds the offset of the pulse within that
+// buffer plus one buffer of device queueing.
+bool AudioDevice::measureLatency(int trials, AudioLatencyStats& stats) {
+    stats = AudioLatencyStats{trials, 0, 0.0, 0.0, 0.0};
+    if (!opened || format != AUDIO_S16SYS) {
+        std::cerr << "Latency probe needs an open 16-bit device." << std::endl;
+        return false;
+    }
+
+    std::vector<Sint16> pulse(static_cast<size_t>(AUDIO_PROBE_FRAMES) * outputChannels, 32000);
+    Mix_Chunk* probe = Mix_QuickLoad_RAW(reinterpret_cast<Uint8*>(pulse.data()), static_cast<Uint32>(pulse.size() * sizeof(Sint16)));
+    if (!probe) {
+        std::cerr << "Mix_QuickLoad_RAW failed: " << Mix_GetError() << std::endl;
+        return false;
+    }
+
+    Mix_HaltMusic();
+    Mix_HaltChannel(-1);
+    soundQueue.push(SoundEvent{SoundType::StopAll, nullptr});
+    waitForCallbacks(2);
+    int savedVolume = mixer.getMasterVolume();
+    mixer.setMasterVolume(MIX_MAX_VOLUME);
+
+    double frequencyTicks = static_cast<double>(SDL_GetPerformanceFrequency());
+    double total = 0.0;
+    Uint32 period = static_cast<Uint32>(bufferMs()) + 1;
+    for (int i = 0; i < trials; ++i) {
+        // Stagger the requests so they land at different points of the period.
+        SDL_Delay(period + static_cast<Uint32>(i * 7) % period);
+
+        probeFound = false;
+        probeArmed = true;
+        Uint64 requested = SDL_GetPerformanceCounter();
+        soundQueue.push(SoundEvent{SoundType::GameOver, probe});
+
+        Uint32 deadline = SDL_GetTicks() + AUDIO_PROBE_TIMEOUT_MS;
+        while (!probeFound.load() && SDL_GetTicks() < deadline) SDL_Delay(1);
+        probeArmed = false;
+        if (!probeFound.load()) continue;
+
+        double ms = (probeMixedAt.load() - requested) * 1000.0 / frequencyTicks
+                  + probeFrameOffset.load() * 1000.0 / frequency + bufferMs();
+        stats.minMs = stats.detected == 0 ? ms : std::min(stats.minMs, ms);
+        stats.maxMs = std::max(stats.maxMs, ms);
+        total += ms;
+        stats.detected++;
+    }
+    if (stats.detected > 0) stats.averageMs = total / stats.detected;
+
+    // The mixer may still point into the pulse until it has seen the stop.
+    soundQueue.push(SoundEvent{SoundType::StopAll, nullptr});
+    waitForCallbacks(2);
+    Mix_FreeChunk(probe);
+    mixer.setMasterVolume(savedVolume);
+    return stats.detected > 0;
+}
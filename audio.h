@@ -0,0 +1,104 @@
+#ifndef AUDIO_H
+#define AUDIO_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include "config.h"
+#include "soundqueue.h"
+#include "mixer.h"
+
+enum class AudioLatencyMode { Standard = 0, Low = 1, Lowest = 2 };
+
+int audioChunkSizeFor(AudioLatencyMode mode);
+const char* audioLatencyName(AudioLatencyMode mode);
+
+struct AudioLatencyStats {
+    int trials;
+    int detected;
+    double averageMs;
+    double minMs;
+    double maxMs;
+};
+
+struct AudioMixStats {
+    int buffers;
+    double averageUs;
+    double worstUs;
+    double budgetUs;
+    int peakVoices;
+    int stolenVoices;
+    int droppedSounds;
+};
+
+// Owns the SDL_mixer device. The post-mix hook watches how regularly the
+// device asks for data; when callbacks keep arriving later than the buffer
+// lasts the output has run dry, and fallBackIfUnderrunning() reopens the
+// device one buffer size up. The same hook is used by measureLatency() to
+// timestamp the first mixed sample of a probe chunk.
+//
+// Game sounds do not go through SDL_mixer channels: post() puts them on a
+// lock-free queue which the audio callback drains into the SoundMixer before
+// mixing, so the simulation never waits on the mixer's audio lock. One-shot
+// sounds of the same type are only queued once per tick.
+class AudioDevice {
+public:
+    AudioDevice();
+    ~AudioDevice();
+
+    AudioDevice(const AudioDevice&) = delete;
+    AudioDevice& operator=(const AudioDevice&) = delete;
+
+    bool open(AudioLatencyMode requested);
+    void close();
+    bool isOpen() const { return opened; }
+
+    AudioLatencyMode mode() const { return currentMode; }
+    int chunkSize() const { return audioChunkSizeFor(currentMode); }
+    double bufferMs() const;
+
+    bool fallBackIfUnderrunning();
+    int underrunCount() const { return totalLateCallbacks.load(); }
+
+    bool measureLatency(int trials, AudioLatencyStats& stats);
+
+    void post(SoundType type, Mix_Chunk* chunk = nullptr);
+    void endTick();
+    void setEffectsVolume(int volume) { mixer.setMasterVolume(volume); }
+
+    AudioMixStats mixStats() const;
+    void resetMixStats();
+
+private:
+    static void SDLCALL postMix(void* userdata, Uint8* stream, int len);
+
+    bool waitForCallbacks(Uint32 count);
+
+    bool opened;
+    AudioLatencyMode currentMode;
+    int frequency;
+    int outputChannels;
+    Uint16 format;
+    Uint64 lateThreshold;
+    Uint32 windowStart;
+
+    std::atomic<Uint64> lastCallback;
+    std::atomic<int> lateCallbacks;
+    std::atomic<int> totalLateCallbacks;
+
+    std::atomic<bool> probeArmed;
+    std::atomic<bool> probeFound;
+    std::atomic<Uint64> probeMixedAt;
+    std::atomic<int> probeFrameOffset;
+
+    std::atomic<Uint32> callbackCount;
+    std::atomic<Uint32> mixBuffers;
+    std::atomic<Uint64> mixTicksTotal;
+    std::atomic<Uint64> mixTicksWorst;
+
+    SoundQueue soundQueue;
+    SoundMixer mixer;
+    uint32_t tickMask;
+};
+
+#endif
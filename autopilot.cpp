@@ -0,0 +1,136 @@
+#include "autopilot.h"
+#include "game.h"
+#include "fastmath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Shortest signed turn from one angle to another, in (-PI, PI].
+float turnBetween(float from, float to) {
+    float d = wrapAngle(to - from);
+    return d > PI ? d - 2.0f * PI : d;
+}
+
+float secondsUntil(Uint32 time, Uint32 now) {
+    return static_cast<float>(static_cast<int32_t>(time - now)) / 1000.0f;
+}
+
+}
+
+Autopilot::Autopilot(const AutopilotSkill& s)
+    : skill(s), noise(0.0f, 1.0f), oldest(0), pending(0), current{0, true, 0.0f} {
+    threats.reserve(2 * MISSILE_POOL_CAPACITY + SHARK_POOL_CAPACITY + SHARK_BULLET_POOL_CAPACITY);
+    decisions.resize(AUTOPILOT_DECISION_CAPACITY);
+}
+
+void Autopilot::reset(Uint32 seed) {
+    rng.seed(seed);
+    noise.reset();
+    oldest = 0;
+    pending = 0;
+    current = Decision{0, true, 0.0f};
+}
+
+// Missiles are checked against the shield from bandTime until they leave
+// the band, bullets when their path crosses it, sharks for as long as they
+// circle inside it, so an arrival already under way counts as due now.
+void Autopilot::collectThreats(const Game& game) {
+    threats.clear();
+    Uint32 now = game.getElapsedTime();
+    float cx = static_cast<float>(TRAJECTORY_CENTER.x), cy = static_cast<float>(TRAJECTORY_CENTER.y);
+    auto add = [&](float angle, float seconds) {
+        if (seconds <= AUTOPILOT_HORIZON_S) threats.push_back(Threat{wrapAngle(angle), std::max(seconds, 0.0f)});
+    };
+
+    for (const EntityPool<Target>* missiles : {&game.getMissiles(), &game.getFastMissiles()}) {
+        for (const Target& t : *missiles) {
+            if (static_cast<int32_t>(now - t.bandExitTime) > 0) continue;
+            add(fastAtan2(t.originY - cy, t.originX - cx), secondsUntil(t.bandTime, now));
+        }
+    }
+
+    float bulletRadius = std::sqrt(SHARK_BULLET_COLLISION_RADIUS_SQ);
+    for (const SharkBullet& sb : game.getSharkBullets()) {
+        float dx = sb.x - cx, dy = sb.y - cy;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        float speed = std::sqrt(sb.dx * sb.dx + sb.dy * sb.dy);
+        if (speed <= 0.0f || distance < TRAJECTORY_RADIUS - bulletRadius) continue;
+        add(fastAtan2(dy, dx), (distance - (TRAJECTORY_RADIUS + bulletRadius)) / speed);
+    }
+
+    float sharkReach = TRAJECTORY_RADIUS + std::sqrt(SHARK_COLLISION_RADIUS_SQ);
+    for (const SpaceShark& ss : game.getSpaceSharks()) {
+        float seconds = ss.radius > sharkReach ? (ss.radius - sharkReach) / -SHARK_SPIRAL_SPEED : 0.0f;
+        add(fastAtan2(ss.dirY, ss.dirX) + ss.angularSpeed * seconds, seconds);
+    }
+
+    if (threats.size() > AUTOPILOT_MAX_THREATS) {
+        std::nth_element(threats.begin(), threats.begin() + AUTOPILOT_MAX_THREATS, threats.end(),
+                         [](const Threat& a, const Threat& b) { return a.seconds < b.seconds; });
+        threats.resize(AUTOPILOT_MAX_THREATS);
+    }
+}
+
+// Candidate aims put each arrival at the middle or either end of the arc,
+// plus staying put. An arrival counts for an aim the arc covers if the
+// turn there is done before it lands, or if the arc covers it already and
+// so keeps covering it on the way. Ties go to the shorter turn.
+bool Autopilot::chooseAim(float centre, float turnRate, float& aim) const {
+    const float reach = SHIELD_ARC_ANGLE / 2.0f - AUTOPILOT_EDGE_MARGIN;
+    float bestScore = 0.0f, bestTurn = 0.0f;
+    auto consider = [&](float option) {
+        float turn = std::fabs(turnBetween(centre, option));
+        float turnSeconds = turn / turnRate;
+        float score = 0.0f;
+        for (const Threat& t : threats) {
+            if (std::fabs(turnBetween(option, t.angle)) > reach) continue;
+            if (turnSeconds <= t.seconds || std::fabs(turnBetween(centre, t.angle)) <= reach) {
+                score += AUTOPILOT_URGENCY_S / (t.seconds + AUTOPILOT_URGENCY_S);
+            }
+        }
+        if (score > bestScore || (score > 0.0f && score == bestScore && turn < bestTurn)) {
+            bestScore = score;
+            bestTurn = turn;
+            aim = option;
+        }
+    };
+    consider(centre);
+    for (const Threat& t : threats) {
+        consider(t.angle);
+        consider(t.angle - reach);
+        consider(t.angle + reach);
+    }
+    return bestScore > 0.0f;
+}
+
+// Each tick's decision is queued and only acted on once reactionMs old;
+// steering toward the aim uses where the shield is now.
+int Autopilot::decide(const Game& game, float deltaTime) {
+    Uint32 now = game.getElapsedTime();
+    float centre = wrapAngle(game.getShieldAngle() + SHIELD_ARC_ANGLE / 2.0f);
+    float turnRate = game.getShieldTurnRate();
+
+    collectThreats(game);
+    Decision fresh = {now, true, 0.0f};
+    if (turnRate > 0.0f && chooseAim(centre, turnRate, fresh.aim)) {
+        fresh.hold = false;
+        if (skill.aimNoise > 0.0f) fresh.aim += skill.aimNoise * noise(rng);
+    }
+    if (pending == decisions.size()) {
+        oldest = (oldest + 1) % decisions.size();
+        --pending;
+    }
+    decisions[(oldest + pending) % decisions.size()] = fresh;
+    ++pending;
+    while (pending > 0 && now - decisions[oldest].time >= skill.reactionMs) {
+        current = decisions[oldest];
+        oldest = (oldest + 1) % decisions.size();
+        --pending;
+    }
+
+    if (current.hold) return 0;
+    float turn = turnBetween(centre, current.aim);
+    if (std::fabs(turn) < 0.5f * turnRate * deltaTime) return 0;
+    return turn > 0.0f ? 1 : -1;
+}
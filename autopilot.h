@@ -0,0 +1,57 @@
+#ifndef AUTOPILOT_H
+#define AUTOPILOT_H
+
+#include <SDL2/SDL.h>
+#include <random>
+#include <vector>
+#include "config.h"
+
+class Game;
+
+struct AutopilotSkill {
+    // How old the picture is that each decision is acted on.
+    Uint32 reactionMs = AUTOPILOT_REACTION_MS;
+    // Standard deviation of the aim, in radians.
+    float aimNoise = AUTOPILOT_AIM_NOISE;
+};
+
+// Plays by turning the shield. Every missile, fast missile and shark
+// bullet flies straight at the ring centre, so it meets the shield band at
+// the angle it came from, at a time known from its speed; a shark meets it
+// where its spiral brings it down to the band. The bot aims the arc where
+// it covers the most arrivals, weighting sooner ones higher, among the
+// aims it can still reach in time. A few dozen arrivals at most are
+// weighed per tick and nothing allocates after construction.
+class Autopilot {
+public:
+    explicit Autopilot(const AutopilotSkill& skill = AutopilotSkill());
+
+    // Forgets earlier decisions; the same seed replays the same aim noise.
+    void reset(Uint32 seed);
+    // The turn to hold for the coming tick, as for Game::setShieldTurn.
+    int decide(const Game& game, float deltaTime);
+
+private:
+    struct Threat {
+        float angle;
+        float seconds;
+    };
+    struct Decision {
+        Uint32 time;
+        bool hold;
+        float aim;
+    };
+
+    void collectThreats(const Game& game);
+    bool chooseAim(float centre, float turnRate, float& aim) const;
+
+    AutopilotSkill skill;
+    std::mt19937 rng;
+    std::normal_distribution<float> noise;
+    std::vector<Threat> threats;
+    std::vector<Decision> decisions;
+    size_t oldest, pending;
+    Decision current;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "batchenv.h"
+#include "game.h"
+#include "config.h"
+#include "jobsystem.h"
+#include "wavescript.h"
+#include <algorithm>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+struct SpaceShieldEnv {
+    std::vector<std::unique_ptr<Game>> games;
+    // Episode k of game i plays seed + i + k * count.
+    std::vector<Uint32> nextSeed;
+    std::unique_ptr<JobSystem> jobs;
+    WaveScript script;
+    float deltaTime;
+};
+
+namespace {
+
+void startEpisode(SpaceShieldEnv& env, size_t i) {
+    Game& game = *env.games[i];
+    game.reset();
+    game.setWaveScript(env.script);
+    game.startGame(env.nextSeed[i]);
+    env.nextSeed[i] += static_cast<Uint32>(env.games.size());
+}
+
+void observe(const SpaceShieldEnv& env, size_t i, bool done, const SpaceShieldObservations& out) {
+    const Game& game = *env.games[i];
+    if (out.shieldAngle) out.shieldAngle[i] = wrapAngle(game.getShieldAngle());
+    if (out.lives) out.lives[i] = static_cast<float>(game.getLivesLeft());
+    if (out.score) out.score[i] = static_cast<float>(game.getScore());
+    if (out.done) out.done[i] = done ? 1.0f : 0.0f;
+    if (!out.entityCount && !out.entityKind && !out.entityX && !out.entityY) return;
+
+    size_t base = i * SPACESHIELD_ENV_MAX_ENTITIES, n = 0;
+    float cx = static_cast<float>(TRAJECTORY_CENTER.x), cy = static_cast<float>(TRAJECTORY_CENTER.y);
+    auto put = [&](int kind, float x, float y) {
+        if (n == SPACESHIELD_ENV_MAX_ENTITIES) return;
+        if (out.entityKind) out.entityKind[base + n] = static_cast<float>(kind);
+        if (out.entityX) out.entityX[base + n] = x - cx;
+        if (out.entityY) out.entityY[base + n] = y - cy;
+        ++n;
+    };
+    Uint32 now = game.getElapsedTime();
+    float x, y;
+    for (const Target& t : game.getMissiles()) {
+        targetPosition(t, now, x, y);
+        put(SPACESHIELD_ENTITY_MISSILE, x, y);
+    }
+    for (const Target& t : game.getFastMissiles()) {
+        targetPosition(t, now, x, y);
+        put(SPACESHIELD_ENTITY_FAST_MISSILE, x, y);
+    }
+    for (const SpaceShark& ss : game.getSpaceSharks()) put(SPACESHIELD_ENTITY_SHARK, ss.x, ss.y);
+    for (const SharkBullet& sb : game.getSharkBullets()) put(SPACESHIELD_ENTITY_SHARK_BULLET, sb.x, sb.y);
+    if (out.entityCount) out.entityCount[i] = static_cast<float>(n);
+    for (size_t slot = n; slot < SPACESHIELD_ENV_MAX_ENTITIES; ++slot) {
+        if (out.entityKind) out.entityKind[base + slot] = 0.0f;
+        if (out.entityX) out.entityX[base + slot] = 0.0f;
+        if (out.entityY) out.entityY[base + slot] = 0.0f;
+    }
+}
+
+template <typename Body>
+void forEachGame(SpaceShieldEnv& env, Body&& body) {
+    if (env.jobs) env.jobs->parallelFor(env.games.size(), BATCH_ENV_GRAIN, body);
+    else body(0, env.games.size());
+}
+
+}
+
+SpaceShieldEnv* spaceshield_env_create(int count, unsigned int seed, float tickMs, int threads, const char* waveScript) {
+    if (count <= 0 || !(tickMs > 0.0f) || threads < 0) return nullptr;
+    std::unique_ptr<SpaceShieldEnv> env(new SpaceShieldEnv);
+    if (!env->script.load(waveScript ? waveScript : WAVE_SCRIPT_FILE) && waveScript) {
+        std::cerr << "spaceshield_env_create: wave script " << waveScript << " could not be used" << std::endl;
+        return nullptr;
+    }
+    env->deltaTime = tickMs / 1000.0f;
+    for (int i = 0; i < count; ++i) {
+        env->games.emplace_back(new Game(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr));
+        env->nextSeed.push_back(seed + static_cast<Uint32>(i));
+    }
+    for (size_t i = 0; i < env->games.size(); ++i) startEpisode(*env, i);
+    if (threads != 1) env->jobs.reset(new JobSystem(threads > 1 ? threads - 1 : 0));
+    return env.release();
+}
+
+void spaceshield_env_destroy(SpaceShieldEnv* env) {
+    delete env;
+}
+
+int spaceshield_env_count(const SpaceShieldEnv* env) {
+    return env ? static_cast<int>(env->games.size()) : 0;
+}
+
+void spaceshield_env_reset(SpaceShieldEnv* env, const SpaceShieldObservations* out) {
+    if (!env) return;
+    forEachGame(*env, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            startEpisode(*env, i);
+            if (out) observe(*env, i, false, *out);
+        }
+    });
+}
+
+void spaceshield_env_step(SpaceShieldEnv* env, const int* actions, const SpaceShieldObservations* out) {
+    if (!env) return;
+    forEachGame(*env, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            Game& game = *env->games[i];
+            game.setShieldTurn(actions ? actions[i] : 0);
+            game.update(env->deltaTime);
+            bool done = game.isGameOver();
+            if (done) startEpisode(*env, i);
+            if (out) observe(*env, i, done, *out);
+        }
+    });
+}
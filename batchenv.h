@@ -0,0 +1,70 @@
+#ifndef BATCHENV_H
+#define BATCHENV_H
+
+/* C interface for stepping many headless games in lockstep, e.g. to train
+ * agents. Build it as a shared library from every source but main.cpp.
+ *
+ * Each game plays by the normal rules with a fresh seed per episode. A
+ * step applies one shield action per game, advances all of them by the
+ * tick given at creation, spread over the cores, and writes observations
+ * into the caller's buffers. A game that ends is restarted straight away
+ * and flagged in done, so its observation is already of the new episode.
+ * Nothing is allocated after creation. */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define SPACESHIELD_API __declspec(dllexport)
+#else
+#define SPACESHIELD_API __attribute__((visibility("default")))
+#endif
+
+/* Entity slots reported per game; beyond this the rest are left out. */
+#define SPACESHIELD_ENV_MAX_ENTITIES 64
+
+/* Values of entityKind. */
+#define SPACESHIELD_ENTITY_NONE 0
+#define SPACESHIELD_ENTITY_MISSILE 1
+#define SPACESHIELD_ENTITY_FAST_MISSILE 2
+#define SPACESHIELD_ENTITY_SHARK 3
+#define SPACESHIELD_ENTITY_SHARK_BULLET 4
+
+/* Struct of arrays, one element per game unless noted. Any pointer may be
+ * null to skip that field. The entity arrays hold SPACESHIELD_ENV_MAX_ENTITIES
+ * slots per game, game i's starting at i * SPACESHIELD_ENV_MAX_ENTITIES;
+ * unused slots are zero. */
+typedef struct SpaceShieldObservations {
+    float* shieldAngle; /* where the arc starts, radians in [0, 2*PI) */
+    float* lives;
+    float* score;
+    float* done;        /* 1 if the previous episode ended in this step */
+    float* entityCount;
+    float* entityKind;
+    float* entityX;     /* pixels from the ring centre */
+    float* entityY;
+} SpaceShieldObservations;
+
+typedef struct SpaceShieldEnv SpaceShieldEnv;
+
+/* threads: 0 for one per core, 1 to step on the calling thread only.
+ * waveScript: null for the game's own. Returns null on bad arguments or
+ * an unreadable wave script. */
+SPACESHIELD_API SpaceShieldEnv* spaceshield_env_create(int count, unsigned int seed, float tickMs, int threads, const char* waveScript);
+SPACESHIELD_API void spaceshield_env_destroy(SpaceShieldEnv* env);
+SPACESHIELD_API int spaceshield_env_count(const SpaceShieldEnv* env);
+
+/* Starts a new episode in every game; create has already started the
+ * first. */
+SPACESHIELD_API void spaceshield_env_reset(SpaceShieldEnv* env, const SpaceShieldObservations* out);
+
+/* actions[i] turns game i's shield for the tick: -1 as the A key, 1 as D,
+ * 0 to hold. */
+SPACESHIELD_API void spaceshield_env_step(SpaceShieldEnv* env, const int* actions, const SpaceShieldObservations* out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
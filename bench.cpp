@@ -0,0 +1,767 @@
+#include "bench.h"
+#include "game.h"
+#include "config.h"
+#include "audio.h"
+#include "mixer.h"
+#include "latency.h"
+#include "fastmath.h"
+#include "alloccount.h"
+#include "polargrid.h"
+#include "sweep.h"
+#include "spritemask.h"
+#include "jobsystem.h"
+#include "batchenv.h"
+#include "wavescript.h"
+#include <cmath>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <iostream>
+#include <iomanip>
+
+namespace {
+
+constexpr float BENCH_TICK = 1.0f / 60.0f;
+
+// One LCG for every benchmark's made-up input, so runs are repeatable and do
+// not depend on the standard library's generators.
+struct BenchRandom {
+    explicit BenchRandom(Uint32 seed) : state(seed) {}
+    Uint32 next() {
+        state = state * 1664525u + 1013904223u;
+        return state;
+    }
+    // Uniform in [0, 1).
+    float unit() { return static_cast<float>(next() >> 8) / 16777216.0f; }
+
+    Uint32 state;
+};
+
+double toMicros(Uint64 ticks) {
+    return static_cast<double>(ticks) * 1e6 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+// Benchmarks play in practice mode so they never touch the run log or the
+// highscores; runBenchmark points autosaves at BENCH_SNAPSHOT_FILE so the
+// resume snapshot is left alone too.
+void startBenchGame(Game& game) {
+    game.reset();
+    game.setPracticeMode(true);
+    game.setVolume(0);
+    game.startGame();
+}
+
+int benchRewind(Game& game) {
+    const int ticks = 60 * 60;
+    startBenchGame(game);
+
+    // In practice mode every update() ends by recording a rewind frame.
+    double totalUpdate = 0.0, worstUpdate = 0.0;
+    for (int i = 0; i < ticks; ++i) {
+        Uint64 begin = SDL_GetPerformanceCounter();
+        game.update(BENCH_TICK);
+        double elapsed = toMicros(SDL_GetPerformanceCounter() - begin);
+        totalUpdate += elapsed;
+        worstUpdate = std::max(worstUpdate, elapsed);
+        if (game.isGameOver()) startBenchGame(game);
+    }
+
+    size_t frames = game.rewindFrameCount();
+    size_t bytes = game.rewindBytesUsed();
+
+    double totalRestore = 0.0, worstRestore = 0.0;
+    size_t restored = 0;
+    while (true) {
+        Uint64 begin = SDL_GetPerformanceCounter();
+        bool ok = game.rewindOneFrame();
+        double elapsed = toMicros(SDL_GetPerformanceCounter() - begin);
+        if (!ok) break;
+        totalRestore += elapsed;
+        worstRestore = std::max(worstRestore, elapsed);
+        restored++;
+    }
+
+    const int captures = REWIND_MAX_FRAMES;
+    double totalCapture = 0.0, worstCapture = 0.0;
+    for (int i = 0; i < captures; ++i) {
+        Uint64 begin = SDL_GetPerformanceCounter();
+        game.recordRewindFrame();
+        double elapsed = toMicros(SDL_GetPerformanceCounter() - begin);
+        totalCapture += elapsed;
+        worstCapture = std::max(worstCapture, elapsed);
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "rewind: " << ticks << " ticks" << std::endl;
+    std::cout << "  update   avg " << totalUpdate / ticks << " us, worst " << worstUpdate << " us" << std::endl;
+    std::cout << "  capture  avg " << totalCapture / captures << " us, worst " << worstCapture << " us" << std::endl;
+    std::cout << "  restore  avg " << (restored ? totalRestore / restored : 0.0) << " us, worst " << worstRestore << " us" << std::endl;
+    std::cout << "  history  " << frames << " frames (" << frames * BENCH_TICK << " s) in " << bytes / 1024.0
+              << " KB, " << (frames ? static_cast<double>(bytes) / frames : 0.0) << " bytes/frame" << std::endl;
+    game.reset();
+    return 0;
+}
+
+int benchAudio(AudioDevice& audio) {
+    const int trials = 40;
+    const char* driver = SDL_GetCurrentAudioDriver();
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "audio: " << trials << " probes per buffer size, driver " << (driver ? driver : "?") << std::endl;
+
+    AudioLatencyMode modes[] = {AudioLatencyMode::Standard, AudioLatencyMode::Low, AudioLatencyMode::Lowest};
+    for (AudioLatencyMode mode : modes) {
+        if (!audio.open(mode) || audio.mode() != mode) {
+            std::cout << "  " << audioLatencyName(mode) << ": device refused " << audioChunkSizeFor(mode) << " frames" << std::endl;
+            continue;
+        }
+        AudioLatencyStats stats;
+        int underrunsBefore = audio.underrunCount();
+        if (!audio.measureLatency(trials, stats)) {
+            std::cout << "  " << audioLatencyName(mode) << ": probe never reached the output" << std::endl;
+            continue;
+        }
+        std::cout << "  " << std::setw(8) << audioLatencyName(mode) << " " << std::setw(4) << audio.chunkSize() << " frames: "
+                  << "avg " << stats.averageMs << " ms, min " << stats.minMs << " ms, max " << stats.maxMs << " ms, "
+                  << stats.detected << "/" << stats.trials << " detected, "
+                  << audio.underrunCount() - underrunsBefore << " late callbacks" << std::endl;
+    }
+    audio.open(AudioLatencyMode::Standard);
+    return 0;
+}
+
+// Mixes a one-second hit sound into 512-frame stereo buffers with an
+// increasing number of simultaneous voices, without touching the device.
+int benchMixer() {
+    const int frames = AUDIO_CHUNK_SIZE_LOW;
+    const int samples = frames * AUDIO_CHANNELS;
+    const int buffers = 2000;
+    const double budgetUs = 1e6 * frames / AUDIO_FREQUENCY;
+
+    std::vector<Sint16> pcm(static_cast<size_t>(AUDIO_FREQUENCY) * AUDIO_CHANNELS);
+    BenchRandom random(12345);
+    for (Sint16& s : pcm) s = static_cast<Sint16>(static_cast<int>(random.next() >> 16) - 32768) / 4;
+    Mix_Chunk hit = {0, reinterpret_cast<Uint8*>(pcm.data()), static_cast<Uint32>(pcm.size() * sizeof(Sint16)), MIX_MAX_VOLUME};
+    std::vector<Sint16> out(samples);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "mixer: " << buffers << " buffers of " << frames << " frames, budget " << budgetUs << " us" << std::endl;
+    const int voiceCounts[] = {1, 8, 16, 32, SOUND_MIXER_VOICES};
+    for (int voices : voiceCounts) {
+        SoundMixer mixer;
+        double total = 0.0, worst = 0.0;
+        for (int i = 0; i < buffers; ++i) {
+            while (mixer.activeVoices() < voices) {
+                mixer.play(SoundEvent{SoundType::ShieldHit, &hit});
+                mixer.mix(out.data(), 0);
+            }
+            std::fill(out.begin(), out.end(), 0);
+            Uint64 begin = SDL_GetPerformanceCounter();
+            mixer.mix(out.data(), samples);
+            double elapsed = toMicros(SDL_GetPerformanceCounter() - begin);
+            total += elapsed;
+            worst = std::max(worst, elapsed);
+        }
+        std::cout << "  " << std::setw(2) << voices << " voices: avg " << total / buffers << " us, worst " << worst
+                  << " us (" << 100.0 * total / buffers / budgetUs << "% of buffer)" << std::endl;
+    }
+    return 0;
+}
+
+// Times libm against fastmath over the same inputs and reports the worst
+// error of the fast versions against a double-precision reference.
+int benchTrig() {
+    const size_t count = 4096;
+    const int rounds = 500;
+    std::vector<float> angles(count), wide(count), ys(count), xs(count);
+    std::vector<float> s(count), c(count), out(count);
+    BenchRandom random(12345);
+    for (size_t i = 0; i < count; ++i) {
+        angles[i] = (random.unit() * 2.0f - 1.0f) * 4.0f * PI;
+        wide[i] = (random.unit() * 2.0f - 1.0f) * 1000.0f;
+        ys[i] = (random.unit() * 2.0f - 1.0f) * 400.0f;
+        xs[i] = (random.unit() * 2.0f - 1.0f) * 400.0f;
+    }
+
+    volatile float sink = 0.0f;
+    auto timeIt = [&](const char* label, auto&& body) {
+        Uint64 begin = SDL_GetPerformanceCounter();
+        for (int r = 0; r < rounds; ++r) body();
+        double ns = toMicros(SDL_GetPerformanceCounter() - begin) * 1000.0 / (static_cast<double>(rounds) * count);
+        std::cout << "  " << std::left << std::setw(20) << label << std::right << std::setw(7) << ns << " ns/call" << std::endl;
+        sink = sink + s[count / 2] + c[count / 2] + out[count / 2];
+    };
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "trig: " << rounds << " rounds of " << count << " inputs" << std::endl;
+    timeIt("sin + cos", [&] { for (size_t i = 0; i < count; ++i) { s[i] = std::sin(angles[i]); c[i] = std::cos(angles[i]); } });
+    timeIt("fastSinCos", [&] { for (size_t i = 0; i < count; ++i) fastSinCos(angles[i], s[i], c[i]); });
+    timeIt("fastSinCosBatch", [&] { fastSinCosBatch(angles.data(), s.data(), c.data(), count); });
+    timeIt("atan2", [&] { for (size_t i = 0; i < count; ++i) out[i] = std::atan2(ys[i], xs[i]); });
+    timeIt("fastAtan2", [&] { for (size_t i = 0; i < count; ++i) out[i] = fastAtan2(ys[i], xs[i]); });
+    timeIt("fastAtan2Batch", [&] { fastAtan2Batch(ys.data(), xs.data(), out.data(), count); });
+    timeIt("fmod wrap", [&] {
+        for (size_t i = 0; i < count; ++i) {
+            float a = std::fmod(wide[i], 2.0f * PI);
+            out[i] = a < 0 ? a + 2.0f * PI : a;
+        }
+    });
+    timeIt("wrapAngle", [&] { for (size_t i = 0; i < count; ++i) out[i] = wrapAngle(wide[i]); });
+
+    double sinCosError = 0.0, batchError = 0.0, atanError = 0.0, atanBatchError = 0.0;
+    fastSinCosBatch(wide.data(), s.data(), c.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        float fs, fc;
+        fastSinCos(wide[i], fs, fc);
+        double a = wide[i];
+        sinCosError = std::max({sinCosError, std::fabs(fs - std::sin(a)), std::fabs(fc - std::cos(a))});
+        batchError = std::max({batchError, std::fabs(s[i] - std::sin(a)), std::fabs(c[i] - std::cos(a))});
+    }
+    fastAtan2Batch(ys.data(), xs.data(), out.data(), count);
+    for (size_t i = 0; i < count; ++i) {
+        double reference = std::atan2(static_cast<double>(ys[i]), static_cast<double>(xs[i]));
+        atanError = std::max(atanError, std::fabs(fastAtan2(ys[i], xs[i]) - reference));
+        atanBatchError = std::max(atanBatchError, std::fabs(out[i] - reference));
+    }
+    std::cout << std::scientific << std::setprecision(2);
+    std::cout << "  max error, |angle| < 1000: sin/cos " << sinCosError << ", batch " << batchError << std::endl;
+    std::cout << "  max error, atan2: " << atanError << " rad, batch " << atanBatchError << " rad" << std::endl;
+    (void)sink;
+    return 0;
+}
+
+// Plays an invulnerable practice run long enough for every enemy type to
+// have come and gone, then the same run out of practice mode so autosaves
+// happen, and fails if any frame after each warm-up touches the heap.
+int benchAlloc(Game& game) {
+    const int warmup = 60 * 300;
+    const int ticks = 60 * 600;
+    const int saveWarmup = 60 * 30;
+    startBenchGame(game);
+    game.setInvulnerable(true);
+
+    int dirtyFrames = 0;
+    uint64_t total = 0, worst = 0;
+    auto play = [&](int frames, bool measure) {
+        for (int i = 0; i < frames; ++i) {
+            uint64_t before = threadAllocationCount();
+            game.update(BENCH_TICK);
+            game.render();
+            uint64_t made = threadAllocationCount() - before;
+            if (!measure) continue;
+            if (made > 0) {
+                if (dirtyFrames == 0) std::cout << "  first allocating frame: " << game.getElapsedTime() << " ms" << std::endl;
+                dirtyFrames++;
+            }
+            total += made;
+            worst = std::max(worst, made);
+        }
+    };
+
+    play(warmup, false);
+    play(ticks / 2, true);
+    game.setPracticeMode(false);
+    play(saveWarmup, false);
+    play(ticks / 2, true);
+
+    std::cout << "alloc: " << ticks / 2 << " practice and " << ticks / 2 << " autosaving frames after warm-up" << std::endl;
+    std::cout << "  " << dirtyFrames << " frames allocated, " << total << " allocations, worst frame " << worst << std::endl;
+    game.setInvulnerable(false);
+    game.reset();
+    return dirtyFrames == 0 ? 0 : 1;
+}
+
+// Moves N shark bullets about the screen and resolves them against the
+// shield each round both ways the game can: keeping them filed in a
+// PolarGrid and sweep-testing what an arc query returns, or scanning every
+// one for the band and sweep-testing those. Both costs include their
+// upkeep; the smallest N at which the grid comes out ahead is what
+// POLAR_GRID_MIN_ENTITIES should be. Fails if the grid misses a hit the
+// scan finds.
+int benchGrid() {
+    const int sizes[] = {25, 50, 100, 200, 400, 800, 1600, 3200, 6400, 12800};
+    const int rounds = 200;
+    const float step = DEFAULT_MISSILE_SPEED * SHARK_BULLET_SPEED_MULTIPLIER * BENCH_TICK;
+    const float reach = std::sqrt(SHARK_BULLET_COLLISION_RADIUS_SQ);
+    const float cx = static_cast<float>(TRAJECTORY_CENTER.x), cy = static_cast<float>(TRAJECTORY_CENTER.y);
+    const float inner = TRAJECTORY_RADIUS - reach, outer = TRAJECTORY_RADIUS + reach;
+    const float spread = std::asin(step / inner);
+    const float scanMinSq = (inner - step) * (inner - step), scanMaxSq = (outer + step) * (outer + step);
+    BenchRandom random(777);
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "grid: " << POLAR_GRID_RINGS << " rings x " << POLAR_GRID_SECTORS << " sectors, " << rounds
+              << " rounds, POLAR_GRID_MIN_ENTITIES " << POLAR_GRID_MIN_ENTITIES << std::endl;
+    int missed = 0, gridAhead = 0;
+    for (int n : sizes) {
+        std::vector<float> xs(n), ys(n), dxs(n), dys(n);
+        for (int i = 0; i < n; ++i) {
+            xs[i] = random.unit() * SCREEN_WIDTH;
+            ys[i] = random.unit() * SCREEN_HEIGHT;
+            float heading = random.unit() * 2.0f * PI;
+            dxs[i] = std::cos(heading) * step;
+            dys[i] = std::sin(heading) * step;
+        }
+        auto handle = [](int i) { return EntityHandle{(1u << 16) | static_cast<uint32_t>(i)}; };
+        PolarGrid grid(cx, cy, 1);
+        grid.reserve(n);
+        for (int i = 0; i < n; ++i) grid.update(0, handle(i), xs[i], ys[i]);
+        std::vector<PolarGridHit> hits;
+        hits.reserve(n);
+        std::vector<int> foundInRound(n, -1);
+
+        Uint64 gridTicks = 0, scanTicks = 0;
+        size_t gridCandidates = 0, scanCandidates = 0, exact = 0;
+        for (int r = 0; r < rounds; ++r) {
+            for (int i = 0; i < n; ++i) {
+                xs[i] += dxs[i];
+                ys[i] += dys[i];
+                if (xs[i] < 0.0f) xs[i] += SCREEN_WIDTH; else if (xs[i] >= SCREEN_WIDTH) xs[i] -= SCREEN_WIDTH;
+                if (ys[i] < 0.0f) ys[i] += SCREEN_HEIGHT; else if (ys[i] >= SCREEN_HEIGHT) ys[i] -= SCREEN_HEIGHT;
+            }
+            float start = random.unit() * 2.0f * PI;
+            auto sweep = [&](int i) {
+                float t;
+                return sweepArcBand(xs[i] - dxs[i], ys[i] - dys[i], xs[i], ys[i], cx, cy, inner, outer, start, SHIELD_ARC_ANGLE, t);
+            };
+
+            Uint64 begin = SDL_GetPerformanceCounter();
+            for (int i = 0; i < n; ++i) grid.update(0, handle(i), xs[i], ys[i]);
+            hits.clear();
+            grid.queryArc(start - spread, SHIELD_ARC_ANGLE + 2.0f * spread, inner - step, outer + step, hits);
+            for (const PolarGridHit& hit : hits) {
+                int i = static_cast<int>(hit.handle.slot());
+                if (sweep(i)) foundInRound[i] = r;
+            }
+            gridTicks += SDL_GetPerformanceCounter() - begin;
+            gridCandidates += hits.size();
+
+            begin = SDL_GetPerformanceCounter();
+            size_t direct = 0;
+            for (int i = 0; i < n; ++i) {
+                float dx = xs[i] - cx, dy = ys[i] - cy;
+                float distSq = dx * dx + dy * dy;
+                if (distSq < scanMinSq || distSq > scanMaxSq) continue;
+                scanCandidates++;
+                if (!sweep(i)) continue;
+                direct++;
+                if (foundInRound[i] != r) missed++;
+            }
+            scanTicks += SDL_GetPerformanceCounter() - begin;
+            exact += direct;
+        }
+        double gridUs = toMicros(gridTicks) / rounds, scanUs = toMicros(scanTicks) / rounds;
+        if (gridUs < scanUs && gridAhead == 0) gridAhead = n;
+        if (gridUs >= scanUs) gridAhead = 0;
+        std::cout << "  n=" << std::setw(5) << n
+                  << "  grid " << std::setw(8) << gridUs << " us (" << std::setw(7) << static_cast<double>(gridCandidates) / rounds << " tested)"
+                  << "  scan " << std::setw(8) << scanUs << " us (" << std::setw(7) << static_cast<double>(scanCandidates) / rounds << " tested)"
+                  << "  " << static_cast<double>(exact) / rounds << " hits" << std::endl;
+    }
+    if (gridAhead > 0) std::cout << "  grid ahead from n=" << gridAhead << std::endl;
+    else std::cout << "  grid not ahead at any size" << std::endl;
+    std::cout << "  missed: " << missed << std::endl;
+    return missed == 0 ? 0 : 1;
+}
+
+// Throws random fast-missile-speed segments at the shield band and the ship at
+// several tick lengths and checks the swept tests against sampling each
+// path finely with the point tests. Counts the paths a point test at the
+// tick's end would have let through, and fails on any the sweep misses.
+int benchSweep() {
+    const int ticksPerSecond[] = {60, 20, 5, 1};
+    const int paths = 20000;
+    const int samples = 512;
+    const float speed = DEFAULT_MISSILE_SPEED * 2.0f * FAST_MISSILE_SPEED_MULTIPLIER;
+    const float cx = static_cast<float>(TRAJECTORY_CENTER.x), cy = static_cast<float>(TRAJECTORY_CENTER.y);
+    const float radius = std::sqrt(SHARK_BULLET_COLLISION_RADIUS_SQ);
+    const float inner = TRAJECTORY_RADIUS - radius, outer = TRAJECTORY_RADIUS + radius;
+    const SDL_Rect& ship = PLAYER_CHITBOX;
+    BenchRandom random(4242);
+    auto inBand = [&](float x, float y, float start) {
+        float dx = x - cx, dy = y - cy;
+        float distSq = dx * dx + dy * dy;
+        if (distSq < inner * inner || distSq > outer * outer) return false;
+        float a = wrapAngle(fastAtan2(dy, dx)), s0 = wrapAngle(start), s1 = wrapAngle(start + SHIELD_ARC_ANGLE);
+        return s0 <= s1 ? (a >= s0 && a <= s1) : (a >= s0 || a <= s1);
+    };
+    auto inShip = [&](float x, float y) {
+        return x > ship.x && x < ship.x + ship.w && y > ship.y && y < ship.y + ship.h;
+    };
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "sweep: " << paths << " paths per tick rate at " << speed << " px/s" << std::endl;
+    int missed = 0;
+    for (int rate : ticksPerSecond) {
+        float length = speed / rate;
+        std::vector<float> path(paths * 5);
+        for (int i = 0; i < paths; ++i) {
+            float angle = random.unit() * 2.0f * PI, heading = random.unit() * 2.0f * PI, r = random.unit() * (outer + length);
+            float* p = &path[i * 5];
+            p[0] = cx + r * std::cos(angle);
+            p[1] = cy + r * std::sin(angle);
+            p[2] = p[0] + length * std::cos(heading);
+            p[3] = p[1] + length * std::sin(heading);
+            p[4] = random.unit() * 2.0f * PI;
+        }
+
+        int bandHits = 0, shipHits = 0, tunnelled = 0, extra = 0;
+        volatile float sink = 0.0f;
+        Uint64 begin = SDL_GetPerformanceCounter();
+        for (int i = 0; i < paths; ++i) {
+            const float* p = &path[i * 5];
+            float t = 0.0f;
+            if (sweepArcBand(p[0], p[1], p[2], p[3], cx, cy, inner, outer, p[4], SHIELD_ARC_ANGLE, t)) sink = sink + t;
+            if (sweepRect(p[0], p[1], p[2], p[3], ship.x, ship.y, ship.x + ship.w, ship.y + ship.h, t)) sink = sink + t;
+        }
+        double perPath = toMicros(SDL_GetPerformanceCounter() - begin) * 1000.0 / paths;
+
+        for (int i = 0; i < paths; ++i) {
+            const float* p = &path[i * 5];
+            float bandT = 0.0f, shipT = 0.0f;
+            bool band = sweepArcBand(p[0], p[1], p[2], p[3], cx, cy, inner, outer, p[4], SHIELD_ARC_ANGLE, bandT);
+            bool hull = sweepRect(p[0], p[1], p[2], p[3], ship.x, ship.y, ship.x + ship.w, ship.y + ship.h, shipT);
+            bool sampledBand = false, sampledShip = false;
+            for (int k = 0; k <= samples; ++k) {
+                float f = static_cast<float>(k) / samples;
+                float x = p[0] + (p[2] - p[0]) * f, y = p[1] + (p[3] - p[1]) * f;
+                sampledBand = sampledBand || inBand(x, y, p[4]);
+                sampledShip = sampledShip || inShip(x, y);
+            }
+            bandHits += sampledBand;
+            shipHits += sampledShip;
+            if ((sampledBand && !inBand(p[2], p[3], p[4])) || (sampledShip && !inShip(p[2], p[3]))) tunnelled++;
+            if ((sampledBand && !band) || (sampledShip && !hull)) missed++;
+            if ((band && !sampledBand) || (hull && !sampledShip)) extra++;
+        }
+        (void)sink;
+        std::cout << "  " << std::setw(2) << rate << " Hz (" << std::setw(6) << length << " px/tick)"
+                  << "  band " << std::setw(5) << bandHits << "  ship " << std::setw(5) << shipHits
+                  << "  end-point test misses " << std::setw(5) << tunnelled
+                  << "  sweep-only " << std::setw(3) << extra
+                  << "  " << std::setw(6) << perPath << " ns/path" << std::endl;
+    }
+    std::cout << "  missed: " << missed << std::endl;
+    return missed == 0 ? 0 : 1;
+}
+
+// Drops sharks at random spots and headings around the ship and times the
+// hitbox test against the mask test, checking the masks against a
+// pixel-by-pixel overlap and counting hitbox hits the sprites never touch.
+int benchMask() {
+    const int placements = 200000;
+    SpriteMask ship;
+    RotatedSpriteMask shark;
+    if (!loadSpriteMask(IMG_SPACESHIP, PLAYER_CHITBOX.w, PLAYER_CHITBOX.h, ship) ||
+        !shark.load(IMG_SPACE_SHARK, SHARK_WIDTH, SHARK_HEIGHT, SHARK_CENTER)) {
+        std::cerr << "mask: sprites not available" << std::endl;
+        return 1;
+    }
+    BenchRandom random(99);
+    std::vector<int> xs(placements), ys(placements);
+    std::vector<float> headings(placements);
+    for (int i = 0; i < placements; ++i) {
+        xs[i] = TRAJECTORY_CENTER.x + static_cast<int>((random.unit() * 2.0f - 1.0f) * 80.0f);
+        ys[i] = TRAJECTORY_CENTER.y + static_cast<int>((random.unit() * 2.0f - 1.0f) * 100.0f);
+        headings[i] = random.unit() * 2.0f * PI;
+    }
+
+    int rectHits = 0, maskHits = 0;
+    Uint64 begin = SDL_GetPerformanceCounter();
+    for (int i = 0; i < placements; ++i) {
+        SDL_Rect sharkRect = {xs[i] - SHARK_CENTER.x, ys[i] - SHARK_CENTER.y, SHARK_WIDTH, SHARK_HEIGHT};
+        rectHits += SDL_HasIntersection(&sharkRect, &PLAYER_CHITBOX) ? 1 : 0;
+    }
+    double rectNs = toMicros(SDL_GetPerformanceCounter() - begin) * 1000.0 / placements;
+    begin = SDL_GetPerformanceCounter();
+    for (int i = 0; i < placements; ++i) {
+        maskHits += ship.overlaps(PLAYER_CHITBOX.x, PLAYER_CHITBOX.y, shark.at(headings[i]), xs[i], ys[i]) ? 1 : 0;
+    }
+    double maskNs = toMicros(SDL_GetPerformanceCounter() - begin) * 1000.0 / placements;
+
+    int wrong = 0;
+    for (int i = 0; i < placements; i += 20) {
+        const SpriteMask& m = shark.at(headings[i]);
+        int left = xs[i] + m.offsetX(), top = ys[i] + m.offsetY();
+        bool touching = false;
+        for (int row = 0; row < m.height() && !touching; ++row) {
+            for (int column = 0; column < m.width() && !touching; ++column) {
+                touching = m.isSet(column, row) && ship.isSet(left + column - PLAYER_CHITBOX.x - ship.offsetX(),
+                                                             top + row - PLAYER_CHITBOX.y - ship.offsetY());
+            }
+        }
+        if (touching != ship.overlaps(PLAYER_CHITBOX.x, PLAYER_CHITBOX.y, m, xs[i], ys[i])) wrong++;
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "mask: " << placements << " shark placements around the ship" << std::endl;
+    std::cout << "  hitbox " << std::setw(6) << rectNs << " ns/test, " << rectHits << " hits" << std::endl;
+    std::cout << "  mask   " << std::setw(6) << maskNs << " ns/test, " << maskHits << " hits" << std::endl;
+    std::cout << "  disagreements with the per-pixel check: " << wrong << std::endl;
+    return wrong == 0 ? 0 : 1;
+}
+
+// Floods an invulnerable practice run with sharks, then plays the same
+// stretch twice from one snapshot, on the game thread alone and with a
+// job system, and fails unless both end in byte-identical state.
+int benchJobs(Game& game) {
+    const size_t sharks = 20000;
+    const int ticks = 60 * 5;
+    JobSystem jobs(std::max(3u, std::thread::hardware_concurrency()));
+    startBenchGame(game);
+    game.setInvulnerable(true);
+    game.addStressSharks(sharks);
+    for (int i = 0; i < 60; ++i) game.update(BENCH_TICK);
+
+    std::string start, alone, shared;
+    if (!game.captureSnapshot(start)) {
+        std::cerr << "jobs: could not capture the starting state" << std::endl;
+        return 1;
+    }
+    auto play = [&](JobSystem* system, std::string& out) {
+        if (!game.restoreSnapshot(start.data(), start.size())) return -1.0;
+        game.setJobSystem(system);
+        Uint64 begin = SDL_GetPerformanceCounter();
+        for (int i = 0; i < ticks; ++i) game.update(BENCH_TICK);
+        double avg = toMicros(SDL_GetPerformanceCounter() - begin) / ticks;
+        game.captureSnapshot(out);
+        return avg;
+    };
+    double aloneUs = play(nullptr, alone);
+    double sharedUs = play(&jobs, shared);
+    game.setJobSystem(nullptr);
+    if (aloneUs < 0.0 || sharedUs < 0.0) {
+        std::cerr << "jobs: could not restore the starting state" << std::endl;
+        return 1;
+    }
+
+    std::cout << std::fixed << std::setprecision(1);
+    std::cout << "jobs: " << sharks << " sharks, " << ticks << " ticks, " << jobs.workerCount() << " workers on "
+              << std::thread::hardware_concurrency() << " cores" << std::endl;
+    std::cout << "  game thread  " << std::setw(9) << aloneUs << " us/tick" << std::endl;
+    std::cout << "  job system   " << std::setw(9) << sharedUs << " us/tick" << std::endl;
+    std::cout << "  state " << (alone == shared ? "identical" : "DIFFERS") << " (" << alone.size() << " bytes)" << std::endl;
+    game.setInvulnerable(false);
+    game.reset();
+    return alone == shared ? 0 : 1;
+}
+
+// Steps a batch of headless games through the C interface the way a
+// training loop would, with random actions and every observation field
+// requested; once on this thread alone, counting allocations, then on all
+// cores.
+int benchEnv() {
+    const int count = 512;
+    const int steps = 60 * 40;
+    const size_t slots = static_cast<size_t>(count) * SPACESHIELD_ENV_MAX_ENTITIES;
+    std::vector<float> angle(count), lives(count), score(count), done(count), entities(count);
+    std::vector<float> kind(slots), x(slots), y(slots);
+    std::vector<int> actions(count);
+    SpaceShieldObservations out = {angle.data(), lives.data(), score.data(), done.data(), entities.data(), kind.data(), x.data(), y.data()};
+
+    std::cout << "env: " << count << " games, " << steps << " steps of " << SIMULATE_TICK_MS << " ms" << std::endl;
+    int status = 0;
+    for (int threads : {1, 0}) {
+        SpaceShieldEnv* env = spaceshield_env_create(count, 1, SIMULATE_TICK_MS, threads, nullptr);
+        if (!env) {
+            std::cerr << "env: could not create the games" << std::endl;
+            return 1;
+        }
+        BenchRandom random(2024);
+        int episodes = 0;
+        uint64_t allocations = 0;
+        Uint64 begin = SDL_GetPerformanceCounter();
+        for (int step = 0; step < steps; ++step) {
+            for (int& action : actions) {
+                action = static_cast<int>(random.next() >> 30) % 3 - 1;
+            }
+            uint64_t before = threadAllocationCount();
+            spaceshield_env_step(env, actions.data(), &out);
+            allocations += threadAllocationCount() - before;
+            for (float d : done) episodes += d != 0.0f;
+        }
+        double seconds = toMicros(SDL_GetPerformanceCounter() - begin) / 1e6;
+        spaceshield_env_destroy(env);
+
+        std::cout << std::fixed << std::setprecision(0);
+        std::cout << "  " << (threads == 1 ? "one thread" : "all cores ") << "  " << std::setw(10) << count * steps / seconds
+                  << " steps/s, " << episodes << " episodes ended";
+        if (threads == 1) {
+            std::cout << ", " << allocations << " allocations";
+            if (allocations > 0) status = 1;
+        }
+        std::cout << std::endl;
+    }
+    return status;
+}
+
+// Combined end-state checksum of the fixed-point runs below. It changes
+// with the rules, and only then; a build that prints anything else has
+// drifted.
+constexpr uint32_t FIXED_BENCH_CHECKSUM = 0xe051ff72u;
+
+// Plays fixed-point runs of the built-in waves (not data/, which may be
+// edited) with the shield turned by an integer script, printing each run's
+// end-state checksum, then the same runs in float for comparison. Fails if
+// the combined checksum is not FIXED_BENCH_CHECKSUM, or if a run restored
+// from a snapshot half way does not end in the same state.
+int benchFixed() {
+    const int runs = 16;
+    const int ticks = 60 * 180;
+    const float dt = SIMULATE_TICK_MS / 1000.0f;
+    WaveScript script;
+    Game game(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+    game.setWaveScript(script);
+    auto turn = [](Uint32 seed, int tick) {
+        Uint32 h = (seed * 2654435761u) ^ (static_cast<Uint32>(tick / 20) * 40503u);
+        return static_cast<int>((h * 2246822519u) >> 30) % 3 - 1;
+    };
+    auto play = [&](Uint32 seed, int from, int to) {
+        for (int i = from; i < to && !game.isGameOver(); ++i) {
+            game.setShieldTurn(turn(seed, i));
+            game.update(dt);
+        }
+    };
+
+    std::cout << "fixed: " << runs << " runs of up to " << ticks / 60 << " s at " << SIMULATE_TICK_MS << " ms" << std::endl;
+    std::cout << std::hex << std::setfill('0');
+    uint32_t combined = 2166136261u;
+    int status = 0;
+    double fixedUs = 0.0, floatUs = 0.0;
+    long fixedTicks = 0, floatTicks = 0;
+    for (bool fixedPoint : {true, false}) {
+        game.setFixedPoint(fixedPoint);
+        for (Uint32 seed = 1; seed <= runs; ++seed) {
+            game.reset();
+            game.startGame(seed);
+            std::string half;
+            Uint64 begin = SDL_GetPerformanceCounter();
+            play(seed, 0, ticks / 2);
+            bool saved = game.captureSnapshot(half);
+            play(seed, ticks / 2, ticks);
+            double us = toMicros(SDL_GetPerformanceCounter() - begin);
+            long played = game.getElapsedTime() / SIMULATE_TICK_MS;
+            uint32_t checksum = game.stateChecksum();
+            if (!fixedPoint) {
+                floatUs += us;
+                floatTicks += played;
+                continue;
+            }
+            fixedUs += us;
+            fixedTicks += played;
+
+            bool repeats = !saved || (game.restoreSnapshot(half.data(), half.size()) && (play(seed, ticks / 2, ticks), game.stateChecksum() == checksum));
+            if (!repeats) status = 1;
+            std::cout << "  seed " << std::dec << std::setw(2) << std::setfill(' ') << seed << std::hex << std::setfill('0')
+                      << "  " << std::setw(8) << checksum << (repeats ? "" : "  DIFFERS after restore") << std::endl;
+            for (int i = 0; i < 4; ++i) combined = (combined ^ ((checksum >> (8 * i)) & 0xffu)) * 16777619u;
+        }
+    }
+    std::cout << "  combined " << std::setw(8) << combined;
+    if (combined == FIXED_BENCH_CHECKSUM) std::cout << " as expected";
+    else std::cout << ", expected " << std::setw(8) << FIXED_BENCH_CHECKSUM;
+    std::cout << std::dec << std::setfill(' ') << std::endl;
+    if (combined != FIXED_BENCH_CHECKSUM) status = 1;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "  fixed point  " << std::setw(7) << fixedUs / std::max(fixedTicks, 1L) << " us/tick" << std::endl;
+    std::cout << "  float        " << std::setw(7) << floatUs / std::max(floatTicks, 1L) << " us/tick" << std::endl;
+    return status;
+}
+
+// Injects synthetic D presses at random points of a paced 60 Hz frame and
+// reads the arc back from the offscreen renderer until it has moved.
+int benchLatency(Game& game) {
+    const int trials = 100;
+    const Uint32 frameMs = 16;
+    const float dt = frameMs / 1000.0f;
+    const int maxFrames = 10;
+
+    LatencyTracker& tracker = game.latencyTracker();
+    startBenchGame(game);
+    tracker.setEnabled(true);
+    tracker.clear();
+    tracker.setReadback(true);
+
+    Uint32 nextFrame = SDL_GetTicks();
+    auto runFrame = [&]() {
+        Uint32 now = SDL_GetTicks();
+        if (nextFrame > now) SDL_Delay(nextFrame - now);
+        nextFrame = std::max(nextFrame, now) + frameMs;
+        SDL_Event e;
+        while (SDL_PollEvent(&e)) game.handleInput(e);
+        game.update(dt);
+        if (game.isGameOver()) startBenchGame(game);
+        game.render();
+    };
+    auto pushKey = [](Uint32 type) {
+        SDL_Event e;
+        SDL_zero(e);
+        e.type = type;
+        e.key.timestamp = SDL_GetTicks();
+        e.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+        e.key.keysym.scancode = SDL_SCANCODE_D;
+        e.key.keysym.sym = SDLK_d;
+        SDL_PushEvent(&e);
+    };
+
+    LatencyHistogram photon;
+    int missed = 0;
+    BenchRandom random(2024);
+    for (int i = 0; i < trials; ++i) {
+        for (int k = 0; k < 3; ++k) runFrame();
+        if (!tracker.arcVisible()) {
+            missed++;
+            continue;
+        }
+        float baseline = tracker.arcAngle();
+
+        Uint32 now = SDL_GetTicks();
+        Uint32 jitter = random.next() >> 16;
+        if (nextFrame > now) SDL_Delay(jitter % (nextFrame - now));
+        Uint64 injected = SDL_GetPerformanceCounter();
+        pushKey(SDL_KEYDOWN);
+
+        bool seen = false;
+        for (int f = 0; f < maxFrames && !seen; ++f) {
+            runFrame();
+            if (tracker.arcVisible() && std::fabs(std::remainder(tracker.arcAngle() - baseline, 2.0 * PI)) > LATENCY_ARC_EPSILON) {
+                photon.add(toMicros(SDL_GetPerformanceCounter() - injected) / 1000.0);
+                seen = true;
+            }
+        }
+        if (!seen) missed++;
+        pushKey(SDL_KEYUP);
+        runFrame();
+    }
+
+    std::cout << "latency: " << trials << " synthetic presses, " << frameMs << " ms frames, "
+              << missed << " not seen within " << maxFrames << " frames" << std::endl;
+    photon.print(std::cout, "  injected -> arc moved on screen");
+    tracker.report(std::cout);
+
+    tracker.setReadback(false);
+    tracker.setEnabled(false);
+    game.reset();
+    return 0;
+}
+
+}
+
+int runBenchmark(const std::string& name, Game& game, AudioDevice& audio) {
+    game.setSnapshotPath(BENCH_SNAPSHOT_FILE);
+    if (name == "rewind") return benchRewind(game);
+    if (name == "audio") return benchAudio(audio);
+    if (name == "mixer") return benchMixer();
+    if (name == "latency") return benchLatency(game);
+    if (name == "trig") return benchTrig();
+    if (name == "alloc") return benchAlloc(game);
+    if (name == "grid") return benchGrid();
+    if (name == "sweep") return benchSweep();
+    if (name == "mask") return benchMask();
+    if (name == "jobs") return benchJobs(game);
+    if (name == "env") return benchEnv();
+    if (name == "fixed") return benchFixed();
+
+    std::cerr << "Unknown benchmark: " << name << std::endl;
+    std::cerr << "Available: rewind, audio, mixer, latency, trig, alloc, grid, sweep, mask, jobs, env, fixed" << std::endl;
+    return 1;
+}
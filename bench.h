@@ -0,0 +1,13 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+
+class Game;
+class AudioDevice;
+
+// Micro-benchmarks run with "spaceshield --bench <name>" against a hidden
+// window. Results are printed to stdout; the return value is the exit code.
+int runBenchmark(const std::string& name, Game& game, AudioDevice& audio);
+
+#endif
@@ -11,8 +11,14 @@ const std::string WINDOW_TITLE = "Space Shield";
 const std::string FONT_PATH = "fonts/OpenSans-Regular.ttf";
 const std::string PLAYER_DATA_DIR = "playerdata";
 const std::string PLAYER_DATA_FILE = PLAYER_DATA_DIR + "/playerdata";
+const std::string RUN_LOG_FILE = PLAYER_DATA_DIR + "/runs.log";
+const std::string RUN_INDEX_FILE = PLAYER_DATA_DIR + "/runs.idx";
+const std::string SNAPSHOT_FILE = PLAYER_DATA_DIR + "/resume.snap";
+const std::string BENCH_SNAPSHOT_FILE = PLAYER_DATA_DIR + "/bench.snap";
 const std::string IMAGE_DIR = "images";
 const std::string SOUND_DIR = "sounds";
+const std::string DATA_DIR = "data";
+const std::string WAVE_SCRIPT_FILE = DATA_DIR + "/waves.txt";
 
 const std::string IMG_SPACESHIP = IMAGE_DIR + "/mspaceship.png";
 const std::string IMG_MISSILE = IMAGE_DIR + "/missile.png";
@@ -38,9 +44,20 @@ const std::string BGM_GAME = SOUND_DIR + "/game_music.ogg";
 constexpr int AUDIO_FREQUENCY = 44100;
 constexpr int AUDIO_CHANNELS = 2;
 constexpr int AUDIO_CHUNK_SIZE = 2048;
+constexpr int AUDIO_CHUNK_SIZE_LOW = 512;
+constexpr int AUDIO_CHUNK_SIZE_LOWEST = 256;
+constexpr int AUDIO_MIX_CHANNELS = 8;
+constexpr float AUDIO_LATE_CALLBACK_FACTOR = 2.0f;
+constexpr int AUDIO_UNDERRUN_LIMIT = 3;
+constexpr Uint32 AUDIO_UNDERRUN_WINDOW_MS = 5000;
+constexpr int AUDIO_PROBE_FRAMES = 64;
+constexpr int AUDIO_PROBE_THRESHOLD = 16000;
+constexpr Uint32 AUDIO_PROBE_TIMEOUT_MS = 1000;
 constexpr int DEFAULT_VOLUME = 100;
 constexpr int CHANNEL_SFX = -1;
-constexpr int CHANNEL_WARNING = 1;
+constexpr size_t SOUND_QUEUE_CAPACITY = 64;
+constexpr int SOUND_MIXER_VOICES = 48;
+constexpr int SOUND_MIXER_BLOCK = 1024;
 
 constexpr int FONT_SIZE_SMALL = 18;
 constexpr int FONT_SIZE_NORMAL = 24;
@@ -68,6 +85,10 @@ constexpr int TRAJECTORY_RADIUS = 60;
 constexpr float SHIELD_ARC_ANGLE = 2.0f * PI / 3.0f;
 constexpr float INITIAL_SHIELD_START_ANGLE = -PI / 10.3f;
 constexpr float SHIELD_ROTATION_SPEED_FACTOR = 2.0f * PI;
+constexpr size_t SHIELD_KEY_QUEUE_CAPACITY = 32;
+constexpr int LATENCY_BUCKETS = 100;
+constexpr double LATENCY_BUCKET_MS = 1.0;
+constexpr float LATENCY_ARC_EPSILON = 0.01f;
 constexpr float DEFAULT_SENSITIVITY = 50.0f;
 constexpr float MIN_SENSITIVITY_MULTIPLIER = 0.75f;
 constexpr float MAX_SENSITIVITY_MULTIPLIER = 1.25f;
@@ -135,6 +156,42 @@ constexpr int WAVE_START_FAST_MISSILE = 9;
 constexpr int WAVE_INTERVAL_FAST_MISSILE = 3;
 constexpr int WAVE_START_SHARK = 15;
 constexpr int WAVE_INTERVAL_SHARK = 15;
+constexpr int WAVE_TIMELINE_BATCH = 32;
+constexpr uint32_t WAVE_TIMELINE_MAX_EVENTS = 1u << 20;
+// A batch of the built-in curve: each wave's start, both specials and its missiles.
+constexpr size_t WAVE_TIMELINE_RESERVE_EVENTS = WAVE_TIMELINE_BATCH * (MAX_MISSILE_COUNT + 3);
+constexpr int POLAR_GRID_SECTORS = 64;
+constexpr int POLAR_GRID_RINGS = 40;
+constexpr float POLAR_GRID_RING_WIDTH = 16.0f;
+// Sharks plus bullets from which the contact passes use the PolarGrid rather
+// than scanning the pools. --bench grid times both; the scan has come out
+// ahead at every size it tries, up to 12800, so this is set past them.
+constexpr size_t POLAR_GRID_MIN_ENTITIES = 1u << 16;
+constexpr int SPRITE_MASK_ANGLES = 64;
+constexpr Uint8 SPRITE_MASK_ALPHA_THRESHOLD = 128;
+constexpr size_t JOB_QUEUE_CAPACITY = 64;
+constexpr size_t JOB_CHUNKS_PER_THREAD = 4;
+// Entity loops smaller than two of these stay on the game thread.
+constexpr size_t JOB_ENTITY_GRAIN = 256;
+constexpr size_t SIMULATE_RUNS = 1000;
+// Runs still alive after this much game time are cut off and marked censored.
+constexpr float SIMULATE_MAX_SECONDS = 1800.0f;
+constexpr float SIMULATE_TICK_MS = 1000.0f / 60.0f;
+constexpr size_t BATCH_ENV_GRAIN = 16;
+// Fixed-point bullets are tested at least this often along their path.
+constexpr int FIXED_SWEEP_STEP_PX = 4;
+constexpr Uint32 AUTOPILOT_REACTION_MS = 150;
+constexpr float AUTOPILOT_AIM_NOISE = 0.05f;
+// Only arrivals this close are planned for, at most the most urgent few.
+constexpr float AUTOPILOT_HORIZON_S = 3.0f;
+constexpr size_t AUTOPILOT_MAX_THREATS = 32;
+// Aim this far inside the arc's ends, in radians.
+constexpr float AUTOPILOT_EDGE_MARGIN = 0.1f;
+// An arrival this many seconds away counts half as much as one due now.
+constexpr float AUTOPILOT_URGENCY_S = 0.25f;
+constexpr size_t AUTOPILOT_DECISION_CAPACITY = 256;
+constexpr int TIMER_WHEEL_LEVELS = 4;
+constexpr int TIMER_WHEEL_SLOT_BITS = 6;
 
 const SDL_Rect PAUSE_BUTTON_RECT = {SCREEN_WIDTH - 50, 10, 40, 40};
 constexpr int BUTTON_WIDTH = 200;
@@ -152,14 +209,19 @@ const SDL_Rect VOLUME_SLIDER_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 420, BU
 const SDL_Rect VOLUME_KNOB_RECT = { VOLUME_SLIDER_RECT.x + (DEFAULT_VOLUME * VOLUME_SLIDER_RECT.w / 100) - 5, 415, 10, 20 };
 
 const SDL_Rect PLAY_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 250, BUTTON_WIDTH, BUTTON_HEIGHT };
-const SDL_Rect HIGHSCORE_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 320, BUTTON_WIDTH, BUTTON_HEIGHT };
-const SDL_Rect SETTINGS_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 390, BUTTON_WIDTH, BUTTON_HEIGHT };
-const SDL_Rect EXIT_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 460, BUTTON_WIDTH, BUTTON_HEIGHT };
+const SDL_Rect PRACTICE_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 310, BUTTON_WIDTH, BUTTON_HEIGHT };
+const SDL_Rect HIGHSCORE_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 370, BUTTON_WIDTH, BUTTON_HEIGHT };
+const SDL_Rect SETTINGS_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 430, BUTTON_WIDTH, BUTTON_HEIGHT };
+const SDL_Rect EXIT_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 490, BUTTON_WIDTH, BUTTON_HEIGHT };
 const SDL_Rect BACK_BUTTON_RECT = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 500, BUTTON_WIDTH, BUTTON_HEIGHT };
 
 constexpr int HIGHSCORE_TITLE_Y_MENU = 100;
 constexpr int HIGHSCORE_LIST_Y = 200;
 constexpr int MAX_HIGHSCORES_DISPLAY = 5;
+constexpr size_t RUN_LOG_COMPACT_THRESHOLD = 8192;
+constexpr size_t RUN_LOG_KEEP_TOP = 1024;
+constexpr size_t RUN_LOG_KEEP_RECENT = 4096;
+constexpr int64_t LEADERBOARD_PERIOD_SECONDS = 7 * 24 * 60 * 60;
 constexpr int SETTINGS_TITLE_Y = 100;
 const SDL_Rect VOLUME_SLIDER_RECT_SETTINGS = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 280, BUTTON_WIDTH, 10 };
 const SDL_Rect VOLUME_KNOB_RECT_SETTINGS = { VOLUME_SLIDER_RECT_SETTINGS.x + (DEFAULT_VOLUME * VOLUME_SLIDER_RECT_SETTINGS.w / 100) - 5, 275, 10, 20 };
@@ -167,6 +229,26 @@ const int VOLUME_LABEL_Y_SETTINGS = VOLUME_SLIDER_RECT_SETTINGS.y - 40;
 const SDL_Rect SENSITIVITY_SLIDER_RECT_SETTINGS = { (SCREEN_WIDTH - BUTTON_WIDTH) / 2, 380, BUTTON_WIDTH, 10 };
 const SDL_Rect SENSITIVITY_KNOB_RECT_SETTINGS = { SENSITIVITY_SLIDER_RECT_SETTINGS.x + (int)(DEFAULT_SENSITIVITY * SENSITIVITY_SLIDER_RECT_SETTINGS.w / 100.0f) - 5, 375, 10, 20 };
 const int SENSITIVITY_LABEL_Y_SETTINGS = SENSITIVITY_SLIDER_RECT_SETTINGS.y - 40;
+const SDL_Rect AUDIO_MODE_BUTTON_RECT_SETTINGS = { (SCREEN_WIDTH - 320) / 2, 425, 320, BUTTON_HEIGHT };
+
+constexpr Uint32 SNAPSHOT_INTERVAL = 3000;
+constexpr size_t SNAPSHOT_RESERVE_BYTES = 64 * 1024;
+// Room for full entity pools, each shark holding two timers.
+constexpr uint32_t SNAPSHOT_MAX_ENTITIES = 1u << 17;
+
+// Entity lists are reserved to these sizes up front so play never grows
+// them; they are well above anything the built-in waves put on screen.
+constexpr size_t MISSILE_POOL_CAPACITY = 64;
+constexpr size_t SHARK_POOL_CAPACITY = 16;
+constexpr size_t SHARK_BULLET_POOL_CAPACITY = 64;
+constexpr size_t ALLY_POOL_CAPACITY = 8;
+constexpr size_t HEAL_ITEM_POOL_CAPACITY = 8;
+constexpr size_t TIMER_POOL_CAPACITY = 128;
+
+constexpr size_t REWIND_BUFFER_BYTES = 384 * 1024;
+constexpr size_t REWIND_MAX_FRAMES = 600;
+constexpr int REWIND_KEYFRAME_INTERVAL = 30;
+constexpr int PRACTICE_LABEL_Y = 20;
 
 constexpr int INGAME_SCORE_TEXT_PADDING_X = 15;
 constexpr int INGAME_SCORE_TEXT_Y = 40;
@@ -1,5 +1,6 @@
 #include "enemy.h"
 #include "config.h"
+#include "fastmath.h"
 #include <cmath>
 #include <SDL2/SDL_image.h>
 #include <algorithm>
@@ -65,31 +66,34 @@ Enemy::~Enemy() {
     if (sharkBulletTexture) SDL_DestroyTexture(sharkBulletTexture);
 }
 
-void Enemy::renderTarget(const Target& t) {
-    if (t.active && missileTexture) {
-        double angle = atan2(t.dy, t.dx) * 180.0 / PI;
-        SDL_Rect missileRect = {(int)t.x - MISSILE_CENTER.x, (int)t.y - MISSILE_CENTER.y, MISSILE_WIDTH, MISSILE_HEIGHT};
+void Enemy::renderTarget(const Target& t, Uint32 gameTime) {
+    if (missileTexture) {
+        float x, y;
+        targetPosition(t, gameTime, x, y);
+        double angle = fastAtan2(t.dy, t.dx) * 180.0 / PI;
+        SDL_Rect missileRect = {(int)x - MISSILE_CENTER.x, (int)y - MISSILE_CENTER.y, MISSILE_WIDTH, MISSILE_HEIGHT};
         SDL_RenderCopyEx(renderer, missileTexture, NULL, &missileRect, angle, &MISSILE_CENTER, SDL_FLIP_NONE);
     }
 }
 
-void Enemy::renderFastMissile(const Target& fm) {
-    if (fm.active && fastMissileTexture) {
-        double angle = atan2(fm.dy, fm.dx) * 180.0 / PI;
-        SDL_Rect missileRect = {(int)fm.x - FAST_MISSILE_CENTER.x, (int)fm.y - FAST_MISSILE_CENTER.y, FAST_MISSILE_WIDTH, FAST_MISSILE_HEIGHT};
+void Enemy::renderFastMissile(const Target& fm, Uint32 gameTime) {
+    if (fastMissileTexture) {
+        float x, y;
+        targetPosition(fm, gameTime, x, y);
+        double angle = fastAtan2(fm.dy, fm.dx) * 180.0 / PI;
+        SDL_Rect missileRect = {(int)x - FAST_MISSILE_CENTER.x, (int)y - FAST_MISSILE_CENTER.y, FAST_MISSILE_WIDTH, FAST_MISSILE_HEIGHT};
         SDL_RenderCopyEx(renderer, fastMissileTexture, NULL, &missileRect, angle, &FAST_MISSILE_CENTER, SDL_FLIP_NONE);
     }
 }
 
-void Enemy::renderWarning(float warningX, float warningY, Uint32 warningStartTime, Uint32 gameStartTime, Uint32 totalPausedTime) {
+void Enemy::renderWarning(float warningX, float warningY, Uint32 warningStartTime, Uint32 gameTime) {
     if (warningTexture) {
-        Uint32 currentTime = SDL_GetTicks();
         Uint32 elapsedTime = 0;
-        if (currentTime > gameStartTime + totalPausedTime + warningStartTime) {
-             elapsedTime = currentTime - gameStartTime - totalPausedTime - warningStartTime;
+        if (gameTime > warningStartTime) {
+             elapsedTime = gameTime - warningStartTime;
         }
 
-        float alpha = WARNING_ALPHA_MIN + WARNING_ALPHA_RANGE * sin(WARNING_ALPHA_FREQ * elapsedTime);
+        float alpha = WARNING_ALPHA_MIN + WARNING_ALPHA_RANGE * fastSin(WARNING_ALPHA_FREQ * elapsedTime);
         alpha = std::max(0.0f, std::min(255.0f, alpha));
         SDL_SetTextureAlphaMod(warningTexture, static_cast<Uint8>(alpha));
 
@@ -101,20 +105,16 @@ void Enemy::renderWarning(float warningX, float warningY, Uint32 warningStartTim
 }
 
 void Enemy::renderSpaceShark(const SpaceShark& ss) {
-    if (ss.active && spaceSharkTexture) {
-        float dr_dt = SHARK_SPIRAL_SPEED;
-        float dx = dr_dt * cos(ss.angle) - ss.radius * sin(ss.angle) * ss.angularSpeed;
-        float dy = dr_dt * sin(ss.angle) + ss.radius * cos(ss.angle) * ss.angularSpeed;
-
-        double angle = atan2(dy, dx) * 180.0 / PI;
+    if (spaceSharkTexture) {
+        double angle = sharkHeading(ss) * 180.0 / PI;
         SDL_Rect sharkRect = {(int)ss.x - SHARK_CENTER.x, (int)ss.y - SHARK_CENTER.y, SHARK_WIDTH, SHARK_HEIGHT};
         SDL_RenderCopyEx(renderer, spaceSharkTexture, NULL, &sharkRect, angle, &SHARK_CENTER, SDL_FLIP_NONE);
     }
 }
 
 void Enemy::renderSharkBullet(const SharkBullet& sb) {
-    if (sb.active && sharkBulletTexture) {
-        double angle = atan2(sb.dy, sb.dx) * 180.0 / PI;
+    if (sharkBulletTexture) {
+        double angle = fastAtan2(sb.dy, sb.dx) * 180.0 / PI;
         SDL_Rect bulletRect = {(int)sb.x - SHARK_BULLET_CENTER.x, (int)sb.y - SHARK_BULLET_CENTER.y, SHARK_BULLET_WIDTH, SHARK_BULLET_HEIGHT};
         SDL_RenderCopyEx(renderer, sharkBulletTexture, NULL, &bulletRect, angle, &SHARK_BULLET_CENTER, SDL_FLIP_NONE);
     }
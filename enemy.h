@@ -3,27 +3,70 @@
 
 #include <SDL2/SDL.h>
 #include "config.h"
+#include "fastmath.h"
+#include "fixedpoint.h"
 
+// Missiles fly in a straight line from where they spawned, so they keep
+// that point and their velocity and are only placed when something needs
+// the position. The times are game milliseconds, worked out at launch.
+// bearing, from the ring centre to the origin, is only kept in fixed-point
+// runs; there the floats are set once at launch for drawing.
 struct Target {
-    float x, y;
+    float originX, originY;
     float dx, dy;
-    bool active;
+    BinaryAngle bearing;
+    Uint32 spawnTime;
+    Uint32 bandTime;
+    Uint32 bandExitTime;
+    Uint32 hitTime;
+    bool reachedBand;
 };
 
+inline void targetPosition(const Target& t, Uint32 gameTime, float& x, float& y) {
+    float age = static_cast<float>(gameTime - t.spawnTime) / 1000.0f;
+    x = t.originX + t.dx * age;
+    y = t.originY + t.dy * age;
+}
+
+// Sharks spiral in from spawn: the radius shrinks linearly down to
+// SHARK_MIN_RADIUS and the angle turns at angularSpeed. (dirX, dirY) is the
+// unit vector from the ring centre at dirTime; Game turns it each tick by
+// complex multiplication rather than calling cos/sin per shark.
+// In fixed-point runs the spiral comes from startBearing and turnRate
+// (binary angle per second) instead, and the floats are copies of it.
 struct SpaceShark {
     float x, y;
     float radius;
-    float angle;
+    float startRadius;
+    float startAngle;
     float angularSpeed;
+    float dirX, dirY;
+    Uint32 dirTime;
     Uint32 spawnTime;
-    Uint32 lastBulletTime;
-    bool active;
+    BinaryAngle startBearing;
+    int32_t turnRate;
+    Fixed fixedX, fixedY;
 };
 
+inline float sharkRadius(const SpaceShark& ss, Uint32 gameTime) {
+    float r = ss.startRadius + SHARK_SPIRAL_SPEED * static_cast<float>(gameTime - ss.spawnTime) / 1000.0f;
+    return r < SHARK_MIN_RADIUS ? SHARK_MIN_RADIUS : r;
+}
+
+// Direction of travel along the spiral, which is how the sprite is drawn.
+inline float sharkHeading(const SpaceShark& ss) {
+    float dr_dt = ss.radius > SHARK_MIN_RADIUS ? SHARK_SPIRAL_SPEED : 0.0f;
+    float dx = dr_dt * ss.dirX - ss.radius * ss.dirY * ss.angularSpeed;
+    float dy = dr_dt * ss.dirY + ss.radius * ss.dirX * ss.angularSpeed;
+    return fastAtan2(dy, dx);
+}
+
+// The fixed fields are the state in fixed-point runs, the floats otherwise.
 struct SharkBullet {
     float x, y;
     float dx, dy;
-    bool active;
+    Fixed fixedX, fixedY;
+    Fixed fixedDx, fixedDy;
 };
 
 class Enemy {
@@ -38,9 +81,9 @@ public:
     Enemy(SDL_Renderer* r, SDL_Texture* mt);
     ~Enemy();
 
-    void renderTarget(const Target& t);
-    void renderFastMissile(const Target& fm);
-    void renderWarning(float warningX, float warningY, Uint32 warningStartTime, Uint32 gameStartTime, Uint32 totalPausedTime);
+    void renderTarget(const Target& t, Uint32 gameTime);
+    void renderFastMissile(const Target& fm, Uint32 gameTime);
+    void renderWarning(float warningX, float warningY, Uint32 warningStartTime, Uint32 gameTime);
     void renderSpaceShark(const SpaceShark& ss);
     void renderSharkBullet(const SharkBullet& sb);
 };
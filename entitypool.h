@@ -0,0 +1,155 @@
+#ifndef ENTITYPOOL_H
+#define ENTITYPOOL_H
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "snapshot.h"
+
+// Stable reference to a pooled entity: the slot in the low 16 bits and the
+// slot's generation in the high 16. Destroying an entity bumps the
+// generation of its slot, so old handles stop resolving instead of pointing
+// at whatever reuses it. Generation 0 is never issued; a zero handle is null.
+struct EntityHandle {
+    uint32_t value;
+
+    bool isNull() const { return value == 0; }
+    uint32_t slot() const { return value & 0xFFFFu; }
+    uint32_t generation() const { return value >> 16; }
+    bool operator==(EntityHandle other) const { return value == other.value; }
+    bool operator!=(EntityHandle other) const { return value != other.value; }
+};
+
+constexpr EntityHandle NULL_ENTITY = {0};
+
+// Entities of one archetype, packed densely for the update and render loops
+// and addressed from anywhere else only through handles. create() reuses
+// freed slots and destroy() moves the last entity into the hole, so both are
+// O(1) and nothing is compacted per frame; dense order is therefore not
+// creation order. Loops that destroy while iterating use destroyAt(i) and
+// revisit index i.
+template <typename T>
+class EntityPool {
+public:
+    static constexpr uint32_t MAX_SLOTS = 0xFFFFu;
+
+    void reserve(size_t capacity) {
+        items.reserve(capacity);
+        owners.reserve(capacity);
+        slots.reserve(capacity);
+    }
+
+    // Returns NULL_ENTITY once all MAX_SLOTS are live.
+    EntityHandle create(const T& value) {
+        uint32_t slot = freeHead;
+        if (slot == NO_SLOT) {
+            if (slots.size() >= MAX_SLOTS) return NULL_ENTITY;
+            slot = static_cast<uint32_t>(slots.size());
+            slots.push_back(Slot{1, 0});
+        } else {
+            freeHead = slots[slot].index;
+        }
+        slots[slot].index = static_cast<uint16_t>(items.size());
+        items.push_back(value);
+        owners.push_back(static_cast<uint16_t>(slot));
+        return EntityHandle{(static_cast<uint32_t>(slots[slot].generation) << 16) | slot};
+    }
+
+    bool destroy(EntityHandle handle) {
+        if (!resolves(handle)) return false;
+        destroyAt(slots[handle.slot()].index);
+        return true;
+    }
+
+    void destroyAt(size_t index) {
+        uint32_t slot = owners[index];
+        size_t last = items.size() - 1;
+        if (index != last) {
+            items[index] = items[last];
+            owners[index] = owners[last];
+            slots[owners[index]].index = static_cast<uint16_t>(index);
+        }
+        items.pop_back();
+        owners.pop_back();
+
+        Slot& freed = slots[slot];
+        freed.generation = freed.generation == 0xFFFFu ? 1 : freed.generation + 1;
+        freed.index = static_cast<uint16_t>(freeHead);
+        freeHead = slot;
+    }
+
+    T* get(EntityHandle handle) { return resolves(handle) ? &items[slots[handle.slot()].index] : nullptr; }
+    const T* get(EntityHandle handle) const { return resolves(handle) ? &items[slots[handle.slot()].index] : nullptr; }
+
+    EntityHandle handleAt(size_t index) const {
+        uint32_t slot = owners[index];
+        return EntityHandle{(static_cast<uint32_t>(slots[slot].generation) << 16) | slot};
+    }
+
+    size_t size() const { return items.size(); }
+    bool empty() const { return items.empty(); }
+    T& operator[](size_t index) { return items[index]; }
+    const T& operator[](size_t index) const { return items[index]; }
+    T* begin() { return items.data(); }
+    T* end() { return items.data() + items.size(); }
+    const T* begin() const { return items.data(); }
+    const T* end() const { return items.data() + items.size(); }
+
+    // Forgets generations too, so a fresh run hands out the same handles as
+    // the last one did; only call it when no handle outlives the pool's
+    // contents.
+    void clear() {
+        items.clear();
+        owners.clear();
+        slots.clear();
+        freeHead = NO_SLOT;
+    }
+
+    void save(SnapshotWriter& writer) const {
+        writer.put(freeHead);
+        writer.putVector(slots);
+        writer.putVector(owners);
+        writer.putVector(items);
+    }
+
+    // Rejects anything whose slots and dense entries do not point at each
+    // other, so a corrupt snapshot cannot make get() read out of bounds.
+    bool load(SnapshotReader& reader, uint32_t maxCount) {
+        reader.get(freeHead);
+        reader.getVector(slots, maxCount);
+        reader.getVector(owners, maxCount);
+        reader.getVector(items, maxCount);
+        if (!reader.ok() || owners.size() != items.size() || slots.size() > MAX_SLOTS) return false;
+        for (size_t i = 0; i < owners.size(); ++i) {
+            if (owners[i] >= slots.size() || slots[owners[i]].index != i || slots[owners[i]].generation == 0) return false;
+        }
+        size_t freeCount = 0;
+        for (uint32_t slot = freeHead; slot != NO_SLOT; slot = slots[slot].index) {
+            if (slot >= slots.size() || ++freeCount > slots.size()) return false;
+        }
+        return freeCount + items.size() == slots.size();
+    }
+
+private:
+    static constexpr uint32_t NO_SLOT = 0xFFFFu;
+
+    // While live, index is the entity's position in items; while free it
+    // links to the next free slot.
+    struct Slot {
+        uint16_t generation;
+        uint16_t index;
+    };
+
+    bool resolves(EntityHandle handle) const {
+        uint32_t slot = handle.slot();
+        return !handle.isNull() && slot < slots.size() && slots[slot].generation == handle.generation() &&
+               slots[slot].index < items.size() && owners[slots[slot].index] == slot;
+    }
+
+    std::vector<T> items;
+    std::vector<uint16_t> owners;
+    std::vector<Slot> slots;
+    uint32_t freeHead = NO_SLOT;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "fastmath.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+constexpr float FM_PI = 3.14159265358979323846f;
+constexpr float HALF_PI = 1.57079632679489661923f;
+constexpr float TWO_PI = 6.28318530717958647692f;
+constexpr float INV_TWO_PI = 0.15915494309189533577f;
+constexpr float TWO_OVER_PI = 0.63661977236758134308f;
+
+// pi/2 split so that j * PIO2_HI and j * PIO2_MID are exact for the
+// quadrant counts gameplay angles produce (Cody-Waite reduction).
+constexpr float PIO2_HI = 1.5703125f;
+constexpr float PIO2_MID = 4.837512969970703125e-4f;
+constexpr float PIO2_LO = 7.54978995489188216e-8f;
+// Adding and subtracting 1.5 * 2^23 rounds to the nearest integer for
+// |x| < 2^22 without a libm call.
+constexpr float ROUND_MAGIC = 12582912.0f;
+
+// Minimax fits on [-pi/4, pi/4] (Cephes sinf/cosf).
+constexpr float SIN_C1 = -1.6666654611e-1f;
+constexpr float SIN_C2 = 8.3321608736e-3f;
+constexpr float SIN_C3 = -1.9515295891e-4f;
+constexpr float COS_C1 = 4.166664568298827e-2f;
+constexpr float COS_C2 = -1.388731625493765e-3f;
+constexpr float COS_C3 = 2.443315711809948e-5f;
+
+// Odd minimax fit of atan on [0, 1].
+constexpr float ATAN_C1 = 0.99997726f;
+constexpr float ATAN_C3 = -0.33262347f;
+constexpr float ATAN_C5 = 0.19354346f;
+constexpr float ATAN_C7 = -0.11643287f;
+constexpr float ATAN_C9 = 0.05265332f;
+constexpr float ATAN_C11 = -0.01172120f;
+
+float flipSign(float value, uint32_t signBit) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    bits ^= signBit;
+    std::memcpy(&value, &bits, sizeof(bits));
+    return value;
+}
+
+// Angle reduced to [-pi/4, pi/4] plus its quadrant; the polynomials then
+// give sin and cos of the reduced angle, swapped and negated per quadrant.
+void sinCosReduced(float angle, float& s, float& c) {
+    float jf = (angle * TWO_OVER_PI + ROUND_MAGIC) - ROUND_MAGIC;
+    int j = static_cast<int>(jf);
+    float x = ((angle - jf * PIO2_HI) - jf * PIO2_MID) - jf * PIO2_LO;
+    float z = x * x;
+    float sinX = x + x * z * (SIN_C1 + z * (SIN_C2 + z * SIN_C3));
+    float cosX = 1.0f - 0.5f * z + z * z * (COS_C1 + z * (COS_C2 + z * COS_C3));
+
+    uint32_t q = static_cast<uint32_t>(j);
+    bool swap = (q & 1) != 0;
+    s = flipSign(swap ? cosX : sinX, (q & 2u) << 30);
+    c = flipSign(swap ? sinX : cosX, ((q + 1) & 2u) << 30);
+}
+
+}
+
+float wrapAngle(float angle) {
+    float wrapped = angle - TWO_PI * std::floor(angle * INV_TWO_PI);
+    if (wrapped >= TWO_PI) wrapped -= TWO_PI;
+    if (wrapped < 0.0f) wrapped = 0.0f;
+    return wrapped;
+}
+
+float fastSin(float angle) {
+    float s, c;
+    sinCosReduced(angle, s, c);
+    return s;
+}
+
+float fastCos(float angle) {
+    float s, c;
+    sinCosReduced(angle, s, c);
+    return c;
+}
+
+void fastSinCos(float angle, float& s, float& c) {
+    sinCosReduced(angle, s, c);
+}
+
+float fastAtan2(float y, float x) {
+    float ax = std::fabs(x), ay = std::fabs(y);
+    float larger = ax > ay ? ax : ay;
+    float smaller = ax > ay ? ay : ax;
+    if (larger == 0.0f) return 0.0f;
+    float t = smaller / larger;
+    float t2 = t * t;
+    float r = t * (ATAN_C1 + t2 * (ATAN_C3 + t2 * (ATAN_C5 + t2 * (ATAN_C7 + t2 * (ATAN_C9 + t2 * ATAN_C11)))));
+    if (ay > ax) r = HALF_PI - r;
+    if (x < 0.0f) r = FM_PI - r;
+    if (y < 0.0f) r = -r;
+    return r;
+}
+
+#if defined(__SSE2__)
+
+namespace {
+
+inline __m128 blend(__m128 mask, __m128 a, __m128 b) {
+    return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+}
+
+void fastSinCosBatch(const float* angles, float* s, float* c, size_t count) {
+    const __m128i one = _mm_set1_epi32(1);
+    const __m128i two = _mm_set1_epi32(2);
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 a = _mm_loadu_ps(angles + i);
+        __m128i j = _mm_cvtps_epi32(_mm_mul_ps(a, _mm_set1_ps(TWO_OVER_PI)));
+        __m128 jf = _mm_cvtepi32_ps(j);
+        __m128 x = _mm_sub_ps(a, _mm_mul_ps(jf, _mm_set1_ps(PIO2_HI)));
+        x = _mm_sub_ps(x, _mm_mul_ps(jf, _mm_set1_ps(PIO2_MID)));
+        x = _mm_sub_ps(x, _mm_mul_ps(jf, _mm_set1_ps(PIO2_LO)));
+        __m128 z = _mm_mul_ps(x, x);
+
+        __m128 sp = _mm_add_ps(_mm_set1_ps(SIN_C2), _mm_mul_ps(z, _mm_set1_ps(SIN_C3)));
+        sp = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(z, sp));
+        __m128 sinX = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, z), sp));
+
+        __m128 cp = _mm_add_ps(_mm_set1_ps(COS_C2), _mm_mul_ps(z, _mm_set1_ps(COS_C3)));
+        cp = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(z, cp));
+        __m128 cosX = _mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), z));
+        cosX = _mm_add_ps(cosX, _mm_mul_ps(_mm_mul_ps(z, z), cp));
+
+        __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(j, one), one));
+        __m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(j, two), 30));
+        __m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(j, one), two), 30));
+        _mm_storeu_ps(s + i, _mm_xor_ps(blend(swap, cosX, sinX), sinSign));
+        _mm_storeu_ps(c + i, _mm_xor_ps(blend(swap, sinX, cosX), cosSign));
+    }
+    for (; i < count; ++i) sinCosReduced(angles[i], s[i], c[i]);
+}
+
+void fastAtan2Batch(const float* y, const float* x, float* out, size_t count) {
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128 vy = _mm_loadu_ps(y + i);
+        __m128 vx = _mm_loadu_ps(x + i);
+        __m128 ax = _mm_andnot_ps(signMask, vx);
+        __m128 ay = _mm_andnot_ps(signMask, vy);
+        __m128 larger = _mm_max_ps(ax, ay);
+        __m128 smaller = _mm_min_ps(ax, ay);
+        __m128 nonZero = _mm_cmpgt_ps(larger, zero);
+        __m128 t = _mm_and_ps(nonZero, _mm_div_ps(smaller, blend(nonZero, larger, _mm_set1_ps(1.0f))));
+        __m128 t2 = _mm_mul_ps(t, t);
+
+        __m128 p = _mm_add_ps(_mm_set1_ps(ATAN_C9), _mm_mul_ps(t2, _mm_set1_ps(ATAN_C11)));
+        p = _mm_add_ps(_mm_set1_ps(ATAN_C7), _mm_mul_ps(t2, p));
+        p = _mm_add_ps(_mm_set1_ps(ATAN_C5), _mm_mul_ps(t2, p));
+        p = _mm_add_ps(_mm_set1_ps(ATAN_C3), _mm_mul_ps(t2, p));
+        p = _mm_add_ps(_mm_set1_ps(ATAN_C1), _mm_mul_ps(t2, p));
+        __m128 r = _mm_mul_ps(t, p);
+
+        r = blend(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(HALF_PI), r), r);
+        r = blend(_mm_cmplt_ps(vx, zero), _mm_sub_ps(_mm_set1_ps(FM_PI), r), r);
+        r = blend(_mm_cmplt_ps(vy, zero), _mm_xor_ps(r, signMask), r);
+        _mm_storeu_ps(out + i, _mm_and_ps(nonZero, r));
+    }
+    for (; i < count; ++i) out[i] = fastAtan2(y[i], x[i]);
+}
+
+#else
+
+void fastSinCosBatch(const float* angles, float* s, float* c, size_t count) {
+    for (size_t i = 0; i < count; ++i) sinCosReduced(angles[i], s[i], c[i]);
+}
+
+void fastAtan2Batch(const float* y, const float* x, float* out, size_t count) {
+    for (size_t i = 0; i < count; ++i) out[i] = fastAtan2(y[i], x[i]);
+}
+
+#endif
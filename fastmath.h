@@ -0,0 +1,27 @@
+#ifndef FASTMATH_H
+#define FASTMATH_H
+
+#include <cstddef>
+
+// Polynomial stand-ins for libm in gameplay and drawing code. Measured
+// bounds (--bench trig prints them):
+//   fastSin/fastCos  |error| < 2e-7 for |angle| < 1000 rad, growing
+//                    linearly with |angle| past that; meaningless beyond
+//                    |angle| = 6e6
+//   fastAtan2        |error| < 2e-6 rad; 0 for (0, 0)
+//   wrapAngle        result in [0, 2*PI), off by at most one float ulp of
+//                    the input
+// At the 300 px a shark spawns from the ring centre, 2e-6 rad is 0.0006 px.
+// The *Batch variants give the same results four at a time with SSE2, and
+// fall back to the scalar versions elsewhere.
+
+float wrapAngle(float angle);
+float fastSin(float angle);
+float fastCos(float angle);
+void fastSinCos(float angle, float& s, float& c);
+float fastAtan2(float y, float x);
+
+void fastSinCosBatch(const float* angles, float* s, float* c, size_t count);
+void fastAtan2Batch(const float* y, const float* x, float* out, size_t count);
+
+#endif
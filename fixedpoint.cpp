@@ -0,0 +1,86 @@
+#include "fixedpoint.h"
+
+namespace {
+
+constexpr int CORDIC_STEPS = 30;
+
+// atan(2^-i) as a binary angle.
+constexpr BinaryAngle CORDIC_ANGLES[CORDIC_STEPS] = {
+    536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+    2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+    10430, 5215, 2608, 1304, 652, 326, 163, 81,
+    41, 20, 10, 5, 3, 1
+};
+
+// 1 / the CORDIC gain over CORDIC_STEPS, in Q2.30.
+constexpr int32_t CORDIC_START = 652032874;
+
+constexpr BinaryAngle QUARTER_TURN = 1u << 30;
+constexpr BinaryAngle HALF_TURN = 1u << 31;
+
+}
+
+float binaryAngleToRadians(BinaryAngle angle) {
+    return static_cast<float>(angle) * (2.0f * 3.14159265358979323846f / 4294967296.0f);
+}
+
+// Rotation mode works within a quarter turn either side of zero, so the
+// other half is folded over and the result negated.
+void fixedSinCos(BinaryAngle angle, int32_t& s, int32_t& c) {
+    bool flip = angle - QUARTER_TURN < HALF_TURN;
+    int32_t z = static_cast<int32_t>(flip ? angle + HALF_TURN : angle);
+    int32_t x = CORDIC_START, y = 0;
+    for (int i = 0; i < CORDIC_STEPS; ++i) {
+        int32_t dx = x >> i, dy = y >> i;
+        if (z >= 0) {
+            x -= dy; y += dx;
+            z -= static_cast<int32_t>(CORDIC_ANGLES[i]);
+        } else {
+            x += dy; y -= dx;
+            z += static_cast<int32_t>(CORDIC_ANGLES[i]);
+        }
+    }
+    c = flip ? -x : x;
+    s = flip ? -y : y;
+}
+
+// Vectoring mode: turns (x, y) onto the positive x axis and adds up the
+// turns. The vector is scaled to about 2^40 first so the shifts keep their
+// precision, with room left for the 1.65x CORDIC gain.
+BinaryAngle fixedAtan2(int64_t y, int64_t x) {
+    if (x == 0 && y == 0) return 0;
+    BinaryAngle angle = 0;
+    if (x < 0) {
+        x = -x; y = -y;
+        angle = HALF_TURN;
+    }
+    const int64_t low = int64_t(1) << 40, high = int64_t(1) << 41;
+    while (x < low && y < low && y > -low) { x *= 2; y *= 2; }
+    while (x >= high || y >= high || y <= -high) { x /= 2; y /= 2; }
+    for (int i = 0; i < CORDIC_STEPS; ++i) {
+        int64_t dx = x >> i, dy = y >> i;
+        if (y > 0) {
+            x += dy; y -= dx;
+            angle += CORDIC_ANGLES[i];
+        } else {
+            x -= dy; y += dx;
+            angle -= CORDIC_ANGLES[i];
+        }
+    }
+    return angle;
+}
+
+uint64_t isqrt(uint64_t v) {
+    uint64_t root = 0, bit = uint64_t(1) << 62;
+    while (bit > v) bit >>= 2;
+    while (bit) {
+        if (v >= root + bit) {
+            v -= root + bit;
+            root = (root >> 1) + bit;
+        } else {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
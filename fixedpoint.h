@@ -0,0 +1,61 @@
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <cstdint>
+#include <random>
+
+// Integer maths for the fixed-point simulation mode (Game::setFixedPoint).
+// Lengths are Q16.16 pixels and speeds Q16.16 pixels per second. Angles are
+// binary: 2^32 is a full turn, so they wrap on overflow and an arc test is
+// one unsigned subtraction. Nothing here does floating point at run time,
+// so every compiler, optimisation level and CPU gets the same bits.
+
+typedef int32_t Fixed;
+typedef uint32_t BinaryAngle;
+
+constexpr int FIXED_SHIFT = 16;
+constexpr Fixed FIXED_ONE = 1 << FIXED_SHIFT;
+// fixedSinCos results are scaled by 2^FIXED_UNIT_SHIFT.
+constexpr int FIXED_UNIT_SHIFT = 30;
+
+constexpr Fixed fixedPixels(int pixels) { return pixels * FIXED_ONE; }
+
+// For config.h constants only, in constexpr definitions: the compiler folds
+// them with exact rounding. A run-time float must never come through here.
+constexpr Fixed fixedConstant(double value) {
+    return static_cast<Fixed>(value * FIXED_ONE + (value < 0.0 ? -0.5 : 0.5));
+}
+constexpr int64_t binaryAngleUnits(double radians) {
+    return static_cast<int64_t>(radians * (4294967296.0 / (2.0 * 3.14159265358979323846)) + (radians < 0.0 ? -0.5 : 0.5));
+}
+constexpr BinaryAngle toBinaryAngle(double radians) { return static_cast<BinaryAngle>(binaryAngleUnits(radians)); }
+
+inline int fixedFloor(Fixed v) { return v >> FIXED_SHIFT; }
+
+// Distance covered in ms at perSecond, truncated toward zero.
+inline Fixed fixedStep(Fixed perSecond, int64_t ms) { return static_cast<Fixed>(perSecond * ms / 1000); }
+
+// Float copies for drawing and for observers. Each is one exactly rounded
+// conversion or multiply, so they come out the same everywhere as well.
+inline float fixedToFloat(Fixed v) { return static_cast<float>(v) / FIXED_ONE; }
+inline float unitToFloat(int32_t v) { return static_cast<float>(v) / (1 << FIXED_UNIT_SHIFT); }
+float binaryAngleToRadians(BinaryAngle angle);
+
+// True if angle lies on the arc from start running span clockwise, ends included.
+inline bool binaryAngleWithin(BinaryAngle angle, BinaryAngle start, BinaryAngle span) { return angle - start <= span; }
+
+// CORDIC, 30 iterations: within 1.8e-8 of the true value.
+void fixedSinCos(BinaryAngle angle, int32_t& s, int32_t& c);
+// Direction of (x, y) in any common scale; 0 for (0, 0).
+BinaryAngle fixedAtan2(int64_t y, int64_t x);
+
+uint64_t isqrt(uint64_t v);
+inline Fixed fixedSqrt(Fixed v) { return v > 0 ? static_cast<Fixed>(isqrt(static_cast<uint64_t>(v) << FIXED_SHIFT)) : 0; }
+
+// Uniform in [0, n) from one draw. The standard distributions are free to
+// differ between libraries; this is the same with any of them.
+inline uint32_t randomBelow(std::mt19937& rng, uint32_t n) {
+    return static_cast<uint32_t>((static_cast<uint64_t>(rng()) * n) >> 32);
+}
+
+#endif
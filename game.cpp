@@ -4,22 +4,49 @@
 #include <cmath>
 #include <cstdlib>
 #include <iostream>
-#include <sstream>
 #include <algorithm>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
 #include <random>
 #include <memory> 
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include "snapshot.h"
+#include "playerdata.h"
+#include "fastmath.h"
+#include "fixedpoint.h"
+#include "sweep.h"
+
+
+// Per thread, so headless games can run side by side.
+thread_local std::random_device rd;
+thread_local std::uniform_real_distribution<> dis(0.0, 1.0); 
+thread_local std::uniform_int_distribution<> dist_side(0, 3); 
+thread_local std::uniform_int_distribution<> dist_y_spawn(0, SCREEN_HEIGHT - 1); 
+thread_local std::uniform_int_distribution<> dist_x_spawn(0, SCREEN_WIDTH - 1); 
+
+namespace {
+
+// The config.h values the fixed-point mode needs, folded at compile time.
+constexpr BinaryAngle FIXED_INITIAL_SHIELD = toBinaryAngle(INITIAL_SHIELD_START_ANGLE);
+constexpr BinaryAngle FIXED_SHIELD_ARC = toBinaryAngle(SHIELD_ARC_ANGLE);
+constexpr int64_t FIXED_SHIELD_TURN_MIN = binaryAngleUnits(SHIELD_ROTATION_SPEED_FACTOR * MIN_SENSITIVITY_MULTIPLIER);
+constexpr int64_t FIXED_SHIELD_TURN_MAX = binaryAngleUnits(SHIELD_ROTATION_SPEED_FACTOR * MAX_SENSITIVITY_MULTIPLIER);
+constexpr int32_t FIXED_SHARK_TURN = static_cast<int32_t>(binaryAngleUnits(SHARK_ANGULAR_SPEED));
+constexpr Fixed FIXED_SHARK_INITIAL_RADIUS = fixedConstant(SHARK_INITIAL_RADIUS);
+constexpr Fixed FIXED_SHARK_MIN_RADIUS = fixedConstant(SHARK_MIN_RADIUS);
+constexpr Fixed FIXED_SHARK_SPIRAL_SPEED = fixedConstant(SHARK_SPIRAL_SPEED);
+constexpr Fixed FIXED_SHARK_BULLET_SPEED = fixedConstant(DEFAULT_MISSILE_SPEED * SHARK_BULLET_SPEED_MULTIPLIER);
+constexpr Fixed FIXED_FAST_MISSILE_SPEED_MULTIPLIER = fixedConstant(FAST_MISSILE_SPEED_MULTIPLIER);
+constexpr Fixed FIXED_ALLY_SPEED = fixedConstant(ALLY_SPEED);
+constexpr Fixed FIXED_HEAL_ITEM_DROP_SPEED = fixedConstant(HEAL_ITEM_DROP_SPEED);
+const Fixed FIXED_MISSILE_RADIUS = fixedSqrt(fixedConstant(MISSILE_COLLISION_RADIUS_SQ));
+const Fixed FIXED_FAST_MISSILE_RADIUS = fixedSqrt(fixedConstant(FAST_MISSILE_COLLISION_RADIUS_SQ));
+const Fixed FIXED_SHARK_RADIUS = fixedSqrt(fixedConstant(SHARK_COLLISION_RADIUS_SQ));
+const Fixed FIXED_SHARK_BULLET_RADIUS = fixedSqrt(fixedConstant(SHARK_BULLET_COLLISION_RADIUS_SQ));
 
-
-std::random_device rd;
-std::mt19937 gen(rd());
-std::uniform_real_distribution<> dis(0.0, 1.0); 
-std::uniform_int_distribution<> dist_wave_increase(0, RANDOM_WAVES_UNTIL_INCREASE -1); 
-std::uniform_int_distribution<> dist_wave_delay(0, RANDOM_WAVE_DELAY -1); 
-std::uniform_int_distribution<> dist_side(0, 3); 
-std::uniform_int_distribution<> dist_y_spawn(0, SCREEN_HEIGHT - 1); 
-std::uniform_int_distribution<> dist_x_spawn(0, SCREEN_WIDTH - 1); 
+}
 
 SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& path) {
     SDL_Texture* newTexture = nullptr;
@@ -45,8 +72,8 @@ Game::Game(SDL_Renderer* r, Enemy* e, MainMenu* m,
            SDL_Texture* bgTexture)
     : renderer(r), enemy(e), menu(m),
 
-      mspaceshipTexture(nullptr), pauseButtonTexture(nullptr), scoreTexture(nullptr),
-      highscoreTexture(nullptr), pausedTexture(nullptr), backToMenuTexture(nullptr),
+      mspaceshipTexture(nullptr), pauseButtonTexture(nullptr),
+      pausedTexture(nullptr), backToMenuTexture(nullptr),
       restartTexture(nullptr), gameOverTextTexture(nullptr), volumeLabelTexture(nullptr),
       giveUpTexture(nullptr), backgroundTexture(bgTexture),
 
@@ -58,17 +85,19 @@ Game::Game(SDL_Renderer* r, Enemy* e, MainMenu* m,
       sfxHealCollect(sfxHealCollectIn), 
       bgmGame(bgmGameIn),
       gameOver(false), paused(false), showWarning(false),
-      justStarted(false),
 
       startTime(0), pauseStartTime(0), totalPausedTime(0), warningStartTime(0),
-      nextSpawnTime(INITIAL_SPAWN_DELAY), lastMissileSpawnTime(0),
-
-      lastAllySpawnTime(0), 
  
       score(0), missileCount(INITIAL_MISSILE_COUNT), waveCount(0),
-      spawnedMissilesInWave(0),
+      missilesBlocked(0), elapsedTime(0), clockRemainderMs(0.0f), clockRemainderUs(0),
+      rng(rd()), runSeed(0), snapshotPath(SNAPSHOT_FILE), lastSnapshotTime(0),
+      practiceMode(false), invulnerable(false),
+      rewindBuffer(m ? REWIND_BUFFER_BYTES : 0, REWIND_MAX_FRAMES, REWIND_KEYFRAME_INTERVAL),
+      practiceTexture(nullptr),
 
       warningX(0), warningY(0), arcStartAngle(INITIAL_SHIELD_START_ANGLE),
+      fixedPoint(false), shieldBearing(FIXED_INITIAL_SHIELD),
+      shieldLeftHeld(false), shieldRightHeld(false),
 
       volume(DEFAULT_VOLUME), sensitivity(static_cast<int>(DEFAULT_SENSITIVITY)), isDraggingVolume(false),
 
@@ -77,10 +106,32 @@ Game::Game(SDL_Renderer* r, Enemy* e, MainMenu* m,
       giveUpButton(GIVE_UP_BUTTON_RECT), volumeSlider(VOLUME_SLIDER_RECT),
       volumeKnob(VOLUME_KNOB_RECT),
 
-      trajectory{TRAJECTORY_CENTER.x, TRAJECTORY_CENTER.y, TRAJECTORY_RADIUS}
+      trajectory{TRAJECTORY_CENTER.x, TRAJECTORY_CENTER.y, TRAJECTORY_RADIUS},
+      grid(static_cast<float>(TRAJECTORY_CENTER.x), static_cast<float>(TRAJECTORY_CENTER.y), static_cast<int>(GridKind::Count)),
+      jobs(nullptr), preciseHull(false)
 
 {
-    wavesUntilIncrease = BASE_WAVES_UNTIL_INCREASE + dist_wave_increase(gen);
+    waveScript.load(WAVE_SCRIPT_FILE);
+    // Headless games are kept by the thousand and never save or rewind.
+    if (menu) {
+        snapshotBuffer.reserve(SNAPSHOT_RESERVE_BYTES);
+        rewindScratch.reserve(SNAPSHOT_RESERVE_BYTES);
+        menu->persistence.reserveBuffers(snapshotPath, 2, SNAPSHOT_RESERVE_BYTES);
+    }
+    shieldKeyEvents.reserve(SHIELD_KEY_QUEUE_CAPACITY);
+    targets.reserve(MISSILE_POOL_CAPACITY);
+    fastMissiles.reserve(MISSILE_POOL_CAPACITY);
+    spaceSharks.reserve(SHARK_POOL_CAPACITY);
+    sharkBullets.reserve(SHARK_BULLET_POOL_CAPACITY);
+    allies.reserve(ALLY_POOL_CAPACITY);
+    healItems.reserve(HEAL_ITEM_POOL_CAPACITY);
+    grid.reserve(std::max(SHARK_POOL_CAPACITY, SHARK_BULLET_POOL_CAPACITY));
+    gridHits.reserve(SHARK_POOL_CAPACITY + SHARK_BULLET_POOL_CAPACITY);
+    contactOutcomes.reserve(SHARK_POOL_CAPACITY + SHARK_BULLET_POOL_CAPACITY);
+    entityCells.reserve(std::max(SHARK_POOL_CAPACITY, SHARK_BULLET_POOL_CAPACITY));
+    entityGone.reserve(SHARK_BULLET_POOL_CAPACITY);
+    firedTimers.reserve(TIMER_POOL_CAPACITY);
+    timerScratch.reserve(TIMER_POOL_CAPACITY);
 
     lives.clear();
     for (int i = 0; i < PLAYER_LIVES; ++i) {
@@ -89,8 +140,13 @@ Game::Game(SDL_Renderer* r, Enemy* e, MainMenu* m,
     }
 
 
-    setVolume(menu->volume);
-    setSensitivity(menu->sensitivity);
+    // Without a menu and renderer the game runs headless: no textures, no
+    // sound or music, nothing written to disk.
+    if (menu) {
+        setVolume(menu->volume);
+        setSensitivity(menu->sensitivity);
+    }
+    if (!renderer) return;
 
 
     mspaceshipTexture = loadTexture(renderer, IMG_SPACESHIP);
@@ -107,15 +163,13 @@ Game::Game(SDL_Renderer* r, Enemy* e, MainMenu* m,
 
 
     initTextures(); 
-    updateScoreTexture();
-    updateHighscoreTexture();
+    updateScoreLabel();
+    updateHighscoreLabel();
 }
 
 Game::~Game() {
     if (mspaceshipTexture) SDL_DestroyTexture(mspaceshipTexture);
     if (pauseButtonTexture) SDL_DestroyTexture(pauseButtonTexture);
-    if (scoreTexture) SDL_DestroyTexture(scoreTexture);
-    if (highscoreTexture) SDL_DestroyTexture(highscoreTexture);
     if (pausedTexture) SDL_DestroyTexture(pausedTexture);
     if (backToMenuTexture) SDL_DestroyTexture(backToMenuTexture);
     if (restartTexture) SDL_DestroyTexture(restartTexture);
@@ -124,6 +178,7 @@ Game::~Game() {
     if (giveUpTexture) SDL_DestroyTexture(giveUpTexture);
     if (allyShipTexture) SDL_DestroyTexture(allyShipTexture);
     if (healItemTexture) SDL_DestroyTexture(healItemTexture);
+    if (practiceTexture) SDL_DestroyTexture(practiceTexture);
 }
 
 
@@ -131,13 +186,15 @@ void Game::initTextures() {
     TTF_Font* fontLarge = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_LARGE);
     TTF_Font* fontXLarge = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_XLARGE);
     TTF_Font* fontNormal = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_NORMAL);
+    TTF_Font* fontSmall = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_SMALL);
 
 
-    if (!fontLarge || !fontXLarge || !fontNormal) {
+    if (!fontLarge || !fontXLarge || !fontNormal || !fontSmall) {
         std::cerr << "TTF_OpenFont failed in Game::initTextures: " << TTF_GetError() << std::endl;
         if(fontLarge) TTF_CloseFont(fontLarge);
         if(fontXLarge) TTF_CloseFont(fontXLarge);
         if(fontNormal) TTF_CloseFont(fontNormal);
+        if(fontSmall) TTF_CloseFont(fontSmall);
 
         pausedTexture = nullptr;
         backToMenuTexture = nullptr;
@@ -145,8 +202,7 @@ void Game::initTextures() {
         gameOverTextTexture = nullptr;
         volumeLabelTexture = nullptr;
         giveUpTexture = nullptr;
-        scoreTexture = nullptr;
-        highscoreTexture = nullptr;
+        practiceTexture = nullptr;
         return;
     }
 
@@ -177,65 +233,24 @@ void Game::initTextures() {
     if (!createTextureHelper("Paused", pausedTexture, fontLarge)) { std::cerr << "Error creating paused texture." << std::endl; }
     if (!createTextureHelper("Game over", gameOverTextTexture, fontXLarge)) { std::cerr << "Error creating game over texture." << std::endl; }
     if (!createTextureHelper("Volume", volumeLabelTexture, fontNormal)) { std::cerr << "Error creating volume label texture." << std::endl; }
+    if (!createTextureHelper("Practice - hold Backspace to rewind", practiceTexture, fontNormal)) { std::cerr << "Error creating practice label texture." << std::endl; }
+
+    if (!scoreLabel.load(renderer, fontSmall, "Score: ", TEXT_COLOR)) { std::cerr << "Error creating score label." << std::endl; }
+    if (!highscoreLabel.load(renderer, fontSmall, "Highscore: ", TEXT_COLOR)) { std::cerr << "Error creating highscore label." << std::endl; }
 
     TTF_CloseFont(fontLarge);
     TTF_CloseFont(fontXLarge);
     TTF_CloseFont(fontNormal);
+    TTF_CloseFont(fontSmall);
 }
 
 
-void Game::updateScoreTexture() {
-    TTF_Font* font = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_SMALL); 
-    if (!font) {
-        std::cerr << "Failed to open font for score (small): " << TTF_GetError() << std::endl;
-         if (scoreTexture) SDL_DestroyTexture(scoreTexture);
-         scoreTexture = nullptr;
-        return;
-    }
-    std::stringstream ss;
-    ss << "Score: " << score;
-    SDL_Surface* textSurface = TTF_RenderText_Solid(font, ss.str().c_str(), TEXT_COLOR);
-    TTF_CloseFont(font); 
-    if (!textSurface) {
-        std::cerr << "Failed to render score text (small): " << TTF_GetError() << std::endl;
-        if (scoreTexture) SDL_DestroyTexture(scoreTexture);
-        scoreTexture = nullptr;
-        return;
-    }
-    if (scoreTexture) SDL_DestroyTexture(scoreTexture); 
-    scoreTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    SDL_FreeSurface(textSurface);
-    if (!scoreTexture) {
-        std::cerr << "Failed to create score texture (small): " << SDL_GetError() << std::endl;
-    }
+void Game::updateScoreLabel() {
+    scoreLabel.setValue(score);
 }
 
-
-void Game::updateHighscoreTexture() {
-    TTF_Font* font = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_SMALL); 
-     if (!font) {
-         std::cerr << "Failed to open font for highscore (small): " << TTF_GetError() << std::endl;
-         if (highscoreTexture) SDL_DestroyTexture(highscoreTexture);
-         highscoreTexture = nullptr;
-         return;
-     }
-    std::stringstream ss;
-    int highscore = (menu && !menu->highscores.empty()) ? menu->highscores[0] : 0;
-    ss << "Highscore: " << highscore;
-    SDL_Surface* textSurface = TTF_RenderText_Solid(font, ss.str().c_str(), TEXT_COLOR);
-    TTF_CloseFont(font);
-    if (!textSurface) {
-        std::cerr << "Failed to render highscore text (small): " << TTF_GetError() << std::endl;
-         if (highscoreTexture) SDL_DestroyTexture(highscoreTexture);
-         highscoreTexture = nullptr;
-        return;
-    }
-    if (highscoreTexture) SDL_DestroyTexture(highscoreTexture);
-    highscoreTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
-    SDL_FreeSurface(textSurface);
-     if (!highscoreTexture) {
-         std::cerr << "Failed to create highscore texture (small): " << SDL_GetError() << std::endl;
-     }
+void Game::updateHighscoreLabel() {
+    highscoreLabel.setValue((menu && !menu->highscores.empty()) ? menu->highscores[0] : 0);
 }
 
 void Game::updatePausedTexture() { }
@@ -243,13 +258,19 @@ void Game::updateGameOverTextTexture() { }
 void Game::updateVolumeLabelTexture() { }
 
 void Game::handleInput(SDL_Event& event) {
+    if ((event.type == SDL_KEYDOWN || event.type == SDL_KEYUP) && !event.key.repeat) {
+        SDL_Scancode key = event.key.keysym.scancode;
+        if (key == SDL_SCANCODE_A || key == SDL_SCANCODE_D) {
+            recordShieldKey(key, event.type == SDL_KEYDOWN, event.key.timestamp);
+        }
+    }
     if (event.type == SDL_MOUSEBUTTONDOWN) {
         int mouseX, mouseY;
         SDL_GetMouseState(&mouseX, &mouseY);
         SDL_Point mousePoint = {mouseX, mouseY};
 
         if (!gameOver && SDL_PointInRect(&mousePoint, &pauseButton)) {
-             if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+             queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
             if (!paused) { setGameStatePaused(); menu->gameState = MainMenu::PAUSED; }
             else { setGameStatePlaying(); menu->gameState = MainMenu::PLAYING; }
             return; 
@@ -261,7 +282,7 @@ void Game::handleInput(SDL_Event& event) {
                 return; 
             }
             if (SDL_PointInRect(&mousePoint, &giveUpButton)) {
-                 if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+                 queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
                 triggerGameOver(); 
                 menu->gameState = MainMenu::GAME_OVER; 
                 return; 
@@ -270,7 +291,7 @@ void Game::handleInput(SDL_Event& event) {
 
         if (gameOver) {
             if (SDL_PointInRect(&mousePoint, &backToMenuButton)) {
-                 if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+                 queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
                 reset(); 
                 menu->gameState = MainMenu::MENU; 
                  Mix_HaltMusic(); 
@@ -278,7 +299,7 @@ void Game::handleInput(SDL_Event& event) {
                 return; 
             }
             if (SDL_PointInRect(&mousePoint, &restartButton)) {
-                 if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+                 queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
                 reset(); 
                 startGame(); 
                 menu->gameState = MainMenu::PLAYING; 
@@ -308,14 +329,22 @@ void Game::handleInput(SDL_Event& event) {
             setVolume(newVolume); 
         }
      }
+    if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_BACKSPACE && practiceMode && gameOver) {
+        if (rewindOneFrame()) {
+            if (bgmGame) Mix_PlayMusic(bgmGame, -1);
+            if (showWarning) queueSound(SoundType::WarningStart, sfxWarning);
+            menu->gameState = MainMenu::PLAYING;
+        }
+        return;
+    }
     if (event.type == SDL_KEYDOWN && event.key.keysym.sym == SDLK_ESCAPE) {
         if (!gameOver) { 
             if (!paused) {
-                if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+                queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
                 setGameStatePaused();
                 menu->gameState = MainMenu::PAUSED;
             } else {
-                if (menu->sfxButtonClick) Mix_PlayChannel(CHANNEL_SFX, menu->sfxButtonClick, 0);
+                queueSound(SoundType::ButtonClick, menu->sfxButtonClick);
                 setGameStatePlaying();
                 menu->gameState = MainMenu::PLAYING;
             }
@@ -323,236 +352,291 @@ void Game::handleInput(SDL_Event& event) {
      }
 }
 
+namespace {
+
+// e^(i * |angularSpeed| * ms) for the last step taken; every shark updated
+// in the same tick shares it, turning either way by the sign of s, so a tick
+// costs one sincos however many there are.
+struct SharkStep {
+    Uint32 ms = 0;
+    float angularSpeed = 0.0f;
+    float c = 1.0f, s = 0.0f;
+};
+
+// The radius comes straight from the spawn parameters; only the direction
+// is carried forward, and it is pulled back onto the unit circle each step
+// so rounding cannot grow or shrink the orbit.
+void advanceShark(SpaceShark& ss, Uint32 now, SharkStep& step) {
+    Uint32 ms = now - ss.dirTime;
+    float speed = std::fabs(ss.angularSpeed);
+    if (ms != step.ms || speed != step.angularSpeed) {
+        float turn = speed * static_cast<float>(ms) / 1000.0f;
+        step.ms = ms;
+        step.angularSpeed = speed;
+        fastSinCos(turn, step.s, step.c);
+    }
+    float s = ss.angularSpeed < 0.0f ? -step.s : step.s;
+    float x = ss.dirX * step.c - ss.dirY * s;
+    float y = ss.dirX * s + ss.dirY * step.c;
+    float k = 1.5f - 0.5f * (x * x + y * y);
+    ss.dirX = x * k;
+    ss.dirY = y * k;
+    ss.dirTime = now;
+
+    ss.radius = sharkRadius(ss, now);
+    ss.x = TRAJECTORY_CENTER.x + ss.radius * ss.dirX;
+    ss.y = TRAJECTORY_CENTER.y + ss.radius * ss.dirY;
+}
+
+// Fixed-point sharks are placed from their spawn parameters and the clock
+// alone, so nothing is carried from one tick to the next.
+void advanceSharkFixed(SpaceShark& ss, Uint32 now) {
+    int64_t age = now - ss.spawnTime;
+    Fixed radius = std::max(FIXED_SHARK_MIN_RADIUS, FIXED_SHARK_INITIAL_RADIUS + fixedStep(FIXED_SHARK_SPIRAL_SPEED, age));
+    BinaryAngle bearing = ss.startBearing + static_cast<BinaryAngle>(ss.turnRate * age / 1000);
+    int32_t s, c;
+    fixedSinCos(bearing, s, c);
+    ss.fixedX = fixedPixels(TRAJECTORY_CENTER.x) + static_cast<Fixed>((static_cast<int64_t>(radius) * c) >> FIXED_UNIT_SHIFT);
+    ss.fixedY = fixedPixels(TRAJECTORY_CENTER.y) + static_cast<Fixed>((static_cast<int64_t>(radius) * s) >> FIXED_UNIT_SHIFT);
+    ss.dirX = unitToFloat(c);
+    ss.dirY = unitToFloat(s);
+    ss.dirTime = now;
+    ss.radius = fixedToFloat(radius);
+    ss.x = fixedToFloat(ss.fixedX);
+    ss.y = fixedToFloat(ss.fixedY);
+}
+
+// Velocity at speed from (x, y) toward the ring centre; returns the distance.
+Fixed aimAtCentre(Fixed x, Fixed y, Fixed speed, Fixed& dx, Fixed& dy) {
+    int64_t distX = fixedPixels(TRAJECTORY_CENTER.x) - static_cast<int64_t>(x);
+    int64_t distY = fixedPixels(TRAJECTORY_CENTER.y) - static_cast<int64_t>(y);
+    Fixed distance = static_cast<Fixed>(isqrt(static_cast<uint64_t>(distX * distX + distY * distY)));
+    if (distance == 0) distance = FIXED_ONE;
+    dx = static_cast<Fixed>(distX * speed / distance);
+    dy = static_cast<Fixed>(distY * speed / distance);
+    return distance;
+}
+
+template <typename Body>
+void forEachRange(JobSystem* jobs, size_t count, Body&& body) {
+    if (jobs) jobs->parallelFor(count, JOB_ENTITY_GRAIN, body);
+    else body(0, count);
+}
+
+}
+
 void Game::update(float deltaTime) {
     if (gameOver || startTime == 0 || paused) return;
 
-    Uint32 currentTime = SDL_GetTicks() - startTime - totalPausedTime;
+    Uint32 wholeMs;
+    if (fixedPoint) {
+        // The tick is rounded to whole microseconds once; from there on
+        // the clock is integer.
+        Uint32 advanceUs = static_cast<Uint32>(std::lround(deltaTime * 1000000.0f)) + clockRemainderUs;
+        wholeMs = advanceUs / 1000;
+        clockRemainderUs = advanceUs % 1000;
+    } else {
+        float advanceMs = deltaTime * 1000.0f + clockRemainderMs;
+        wholeMs = static_cast<Uint32>(advanceMs);
+        clockRemainderMs = advanceMs - static_cast<float>(wholeMs);
+    }
+    elapsedTime += wholeMs;
+    Uint32 currentTime = elapsedTime;
+
+    // Over a whole-millisecond tick every step of this is exact in float.
+    float turnMs = consumeShieldInput(fixedPoint ? static_cast<float>(wholeMs) : deltaTime * 1000.0f);
 
     const Uint8* keys = SDL_GetKeyboardState(NULL);
-    float sensitivityFactor = MIN_SENSITIVITY_MULTIPLIER + (static_cast<float>(sensitivity) / 100.0f) * (MAX_SENSITIVITY_MULTIPLIER - MIN_SENSITIVITY_MULTIPLIER);
-    if (keys[SDL_SCANCODE_A]) arcStartAngle -= SHIELD_ROTATION_SPEED_FACTOR * deltaTime * sensitivityFactor;
-    if (keys[SDL_SCANCODE_D]) arcStartAngle += SHIELD_ROTATION_SPEED_FACTOR * deltaTime * sensitivityFactor;
-    arcStartAngle = fmod(arcStartAngle, 2.0f * PI);
-    if (arcStartAngle < 0) arcStartAngle += 2.0f * PI;
-
-    if (currentTime - lastAllySpawnTime >= ALLY_SPAWN_INTERVAL) {
-        SpawnAlly();
-        lastAllySpawnTime = currentTime; 
-    }
-
-    if (waveCount >= WAVE_START_SHARK && (waveCount - WAVE_START_SHARK) % WAVE_INTERVAL_SHARK == 0 && spaceSharks.empty()) {
-        SpaceShark ss;
-        ss.radius = SHARK_INITIAL_RADIUS;
-        ss.angle = static_cast<float>(dis(gen)) * 2.0f * PI; 
-        ss.angularSpeed = (dis(gen) > 0.5 ? 1.0f : -1.0f) * SHARK_ANGULAR_SPEED;
-        ss.x = TRAJECTORY_CENTER.x + ss.radius * cos(ss.angle);
-        ss.y = TRAJECTORY_CENTER.y + ss.radius * sin(ss.angle);
-        ss.spawnTime = currentTime;
-        ss.lastBulletTime = currentTime; 
-        ss.active = true;
-        spaceSharks.push_back(ss);
-    }
-
-    if (waveCount >= WAVE_START_FAST_MISSILE && (waveCount - WAVE_START_FAST_MISSILE) % WAVE_INTERVAL_FAST_MISSILE == 0 && fastMissiles.empty() && !showWarning) {
-        showWarning = true;
-        warningStartTime = currentTime;
-         if (sfxWarning) Mix_PlayChannel(CHANNEL_WARNING, sfxWarning, -1); 
-        int side = dist_side(gen);
-        switch (side) {
-            case 0: warningX = WARNING_ICON_WIDTH / 2; warningY = dist_y_spawn(gen); break; 
-            case 1: warningX = SCREEN_WIDTH - WARNING_ICON_WIDTH / 2; warningY = dist_y_spawn(gen); break; 
-            case 2: warningX = dist_x_spawn(gen); warningY = WARNING_ICON_HEIGHT / 2; break; 
-            case 3: warningX = dist_x_spawn(gen); warningY = SCREEN_HEIGHT - WARNING_ICON_HEIGHT / 2; break; 
-        }
-    }
-
-    if (showWarning && (currentTime - warningStartTime >= FAST_MISSILE_WARNING_DURATION)) {
-        showWarning = false; 
-         Mix_HaltChannel(CHANNEL_WARNING); 
-        Target fm;
-        fm.x = static_cast<float>(warningX);
-        fm.y = static_cast<float>(warningY);
-        float distX = static_cast<float>(TRAJECTORY_CENTER.x) - fm.x;
-        float distY = static_cast<float>(TRAJECTORY_CENTER.y) - fm.y;
-        float distance = sqrt(distX * distX + distY * distY);
-        if (distance < 1e-6f) distance = 1.0f;
-        float baseSpeed = DEFAULT_MISSILE_SPEED * (1.0f + static_cast<float>(dis(gen)) * MAX_MISSILE_SPEED_RANDOM_FACTOR);
-        float missileSpeed = baseSpeed * FAST_MISSILE_SPEED_MULTIPLIER; 
-        fm.dx = (distX / distance) * missileSpeed;
-        fm.dy = (distY / distance) * missileSpeed;
-        fm.active = true;
-        fastMissiles.push_back(fm); 
-    }
-
-    bool waveAdvanced = false; 
-    if (!justStarted && currentTime >= nextSpawnTime) {
-        if (spawnedMissilesInWave < missileCount) {
-            if (currentTime - lastMissileSpawnTime >= MISSILE_SPAWN_INTERVAL || spawnedMissilesInWave == 0) {
-                Target t;
-                int side = dist_side(gen);
-                 switch (side) {
-                    case 0: t.x = 0.0f - MISSILE_WIDTH; t.y = static_cast<float>(dist_y_spawn(gen)); break; 
-                    case 1: t.x = static_cast<float>(SCREEN_WIDTH); t.y = static_cast<float>(dist_y_spawn(gen)); break; 
-                    case 2: t.x = static_cast<float>(dist_x_spawn(gen)); t.y = 0.0f - MISSILE_HEIGHT; break; 
-                    case 3: t.x = static_cast<float>(dist_x_spawn(gen)); t.y = static_cast<float>(SCREEN_HEIGHT); break;
-                }
-                float distX = static_cast<float>(TRAJECTORY_CENTER.x) - t.x;
-                float distY = static_cast<float>(TRAJECTORY_CENTER.y) - t.y;
-                float distance = sqrt(distX * distX + distY * distY);
-                if (distance < 1e-6f) distance = 1.0f;
-                float missileSpeed = DEFAULT_MISSILE_SPEED * (1.0f + static_cast<float>(dis(gen)) * MAX_MISSILE_SPEED_RANDOM_FACTOR);
-                t.dx = (distX / distance) * missileSpeed;
-                t.dy = (distY / distance) * missileSpeed;
-                t.active = true;
-                targets.push_back(t); 
-                spawnedMissilesInWave++; 
-                lastMissileSpawnTime = currentTime; 
-            }
-        }
-        else if (!waveAdvanced) {
-            waveCount++; 
-            if (waveCount > 0 && waveCount % wavesUntilIncrease == 0) { 
-                missileCount++;
-                if (missileCount > MAX_MISSILE_COUNT) missileCount = MAX_MISSILE_COUNT; 
-                wavesUntilIncrease = waveCount + BASE_WAVES_UNTIL_INCREASE + dist_wave_increase(gen);
-            }
-            nextSpawnTime = currentTime + BASE_WAVE_DELAY + dist_wave_delay(gen);
-            spawnedMissilesInWave = 0; 
-            waveAdvanced = true; 
+    if (practiceMode && keys[SDL_SCANCODE_BACKSPACE]) {
+        bool wasWarning = showWarning;
+        if (rewindOneFrame() && wasWarning != showWarning) {
+            if (showWarning) queueSound(SoundType::WarningStart, sfxWarning);
+            else queueSound(SoundType::WarningStop);
         }
+        return;
     }
-    if (justStarted) justStarted = false;
-    for (auto& ally : allies) {
-        if (ally.active) {
-            ally.x += ally.speed * deltaTime;
 
-            if (ally.x > SCREEN_WIDTH) {
-                ally.active = false; 
-                continue; 
-            }
-            if (!ally.droppingHeal && ally.x >= chitbox.x && ally.x <= chitbox.x + chitbox.w) {
-                HealItem heal;
-                heal.x = ally.x + ALLY_WIDTH / 2 - HEAL_ITEM_WIDTH / 2;
-                heal.y = ally.y + ALLY_HEIGHT; 
-                heal.speed = HEAL_ITEM_DROP_SPEED;
-                heal.active = true;
-                healItems.push_back(heal); 
-                ally.droppingHeal = true; 
-            }
-        }
+    if (fixedPoint) {
+        int64_t rate = FIXED_SHIELD_TURN_MIN + (FIXED_SHIELD_TURN_MAX - FIXED_SHIELD_TURN_MIN) * sensitivity / 100;
+        shieldBearing += static_cast<BinaryAngle>(rate * static_cast<int32_t>(turnMs) / 1000);
+        arcStartAngle = binaryAngleToRadians(shieldBearing);
+    } else {
+        float turnSeconds = turnMs / 1000.0f;
+        arcStartAngle += getShieldTurnRate() * turnSeconds;
+        arcStartAngle = wrapAngle(arcStartAngle);
     }
 
-    for (auto& heal : healItems) {
-        if (heal.active) {
-            heal.y += heal.speed * deltaTime;
+    runTimers(currentTime);
 
-            if (heal.y > SCREEN_HEIGHT) {
-                heal.active = false;
-                continue;
-            }
+    while (const SpawnEvent* spawn = timeline.next(currentTime)) applySpawn(*spawn);
 
-            if (CheckCollisionWithChitbox(heal)) {
-                 HandleHealCollection(heal); 
-            }
+    if (fixedPoint) stepEntitiesFixed(currentTime, wholeMs);
+    else stepEntities(currentTime, deltaTime);
+
+    if (practiceMode && !gameOver) {
+        recordRewindFrame();
+    }
+
+    if (!gameOver && currentTime - lastSnapshotTime >= SNAPSHOT_INTERVAL) {
+        saveSnapshot();
+        lastSnapshotTime = currentTime;
+    }
+}
+
+void Game::stepEntities(Uint32 currentTime, float deltaTime) {
+    for (size_t i = 0; i < allies.size();) {
+        AllyShip& ally = allies[i];
+        ally.x += ally.speed * deltaTime;
+
+        if (ally.x > SCREEN_WIDTH) {
+            allies.destroyAt(i);
+            continue; 
+        }
+        if (ally.heal.isNull() && ally.x >= chitbox.x && ally.x <= chitbox.x + chitbox.w) {
+            HealItem heal;
+            heal.x = ally.x + ALLY_WIDTH / 2 - HEAL_ITEM_WIDTH / 2;
+            heal.y = ally.y + ALLY_HEIGHT; 
+            heal.speed = HEAL_ITEM_DROP_SPEED;
+            ally.heal = healItems.create(heal); 
         }
+        ++i;
     }
 
+    for (size_t i = 0; i < healItems.size();) {
+        HealItem& heal = healItems[i];
+        heal.y += heal.speed * deltaTime;
 
-    for (auto& ss : spaceSharks) {
-        if (ss.active) {
-            ss.angle += ss.angularSpeed * deltaTime;
-            ss.radius += SHARK_SPIRAL_SPEED * deltaTime;
-            if (ss.radius < SHARK_MIN_RADIUS) ss.radius = SHARK_MIN_RADIUS;
-            ss.x = TRAJECTORY_CENTER.x + ss.radius * cos(ss.angle);
-            ss.y = TRAJECTORY_CENTER.y + ss.radius * sin(ss.angle);
+        if (heal.y > SCREEN_HEIGHT) {
+            healItems.destroyAt(i);
+        }
+        else if (CheckCollisionWithChitbox(heal)) {
+            healItems.destroyAt(i);
+            HandleHealCollection(); 
+        }
+        else {
+            ++i;
+        }
+    }
 
-            if (currentTime - ss.lastBulletTime >= SHARK_BULLET_INTERVAL) {
-                SharkBullet sb;
-                sb.x = ss.x; sb.y = ss.y; 
-                float distX = static_cast<float>(TRAJECTORY_CENTER.x) - sb.x;
-                float distY = static_cast<float>(TRAJECTORY_CENTER.y) - sb.y;
-                float distance = sqrt(distX * distX + distY * distY);
-                if (distance < 1e-6f) distance = 1.0f;
-                float bulletSpeed = DEFAULT_MISSILE_SPEED * SHARK_BULLET_SPEED_MULTIPLIER;
-                sb.dx = (distX / distance) * bulletSpeed;
-                sb.dy = (distY / distance) * bulletSpeed;
-                sb.active = true;
-                sharkBullets.push_back(sb); 
-                ss.lastBulletTime = currentTime;
-            }
 
-            if (CheckCollisionWithChitbox(ss)) {
-                ss.active = false; 
-                HandleHit(); 
-            }
-            else if (CheckCollisionWithArc(ss)) {
-                ss.active = false; 
-                score += SCORE_PER_SHARK; 
-                updateScoreTexture(); 
-                 if (sfxShieldHit) Mix_PlayChannel(CHANNEL_SFX, sfxShieldHit, 0); 
-            }
-            else if (currentTime - ss.spawnTime >= SHARK_LIFETIME) {
-                 ss.active = false; 
-            }
+    // Moving and filing are split: the per-entity maths runs in ranges,
+    // possibly on several threads, and the grid and pools are then updated
+    // in index order on this one, exactly as a single loop would. Below
+    // POLAR_GRID_MIN_ENTITIES the grid costs more to keep than it saves, so
+    // it is left alone and the contact passes scan the pools instead.
+    bool useGrid = spaceSharks.size() + sharkBullets.size() >= POLAR_GRID_MIN_ENTITIES;
+    entityCells.resize(spaceSharks.size());
+    forEachRange(jobs, spaceSharks.size(), [&](size_t begin, size_t end) {
+        SharkStep sharkStep;
+        for (size_t i = begin; i < end; ++i) {
+            SpaceShark& ss = spaceSharks[i];
+            advanceShark(ss, currentTime, sharkStep);
+            if (useGrid) entityCells[i] = grid.cellAt(ss.x, ss.y);
         }
+    });
+    for (size_t i = 0; useGrid && i < spaceSharks.size(); ++i) {
+        grid.place(static_cast<int>(GridKind::Shark), spaceSharks.handleAt(i), entityCells[i]);
     }
 
-    for (auto& sb : sharkBullets) {
-        if (sb.active) {
+    entityCells.resize(sharkBullets.size());
+    entityGone.resize(sharkBullets.size());
+    forEachRange(jobs, sharkBullets.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            SharkBullet& sb = sharkBullets[i];
             sb.x += sb.dx * deltaTime; sb.y += sb.dy * deltaTime;
-            if (CheckCollisionWithChitbox(sb)) {
-                sb.active = false; 
-                HandleHit(); 
-            }
-            else if (CheckCollisionWithArc(sb)) {
-                sb.active = false; 
-                 if (sfxShieldHit) Mix_PlayChannel(CHANNEL_SFX, sfxShieldHit, 0); 
-            }
-            else if (sb.x < -SHARK_BULLET_WIDTH || sb.x > SCREEN_WIDTH + SHARK_BULLET_WIDTH ||
-                       sb.y < -SHARK_BULLET_HEIGHT || sb.y > SCREEN_HEIGHT + SHARK_BULLET_HEIGHT) {
-                sb.active = false; 
-            }
+            entityGone[i] = sb.x < -SHARK_BULLET_WIDTH || sb.x > SCREEN_WIDTH + SHARK_BULLET_WIDTH ||
+                            sb.y < -SHARK_BULLET_HEIGHT || sb.y > SCREEN_HEIGHT + SHARK_BULLET_HEIGHT;
+            if (useGrid && !entityGone[i]) entityCells[i] = grid.cellAt(sb.x, sb.y);
+        }
+    });
+    // destroy() moves the last bullet into the hole; its results follow it.
+    for (size_t i = 0, count = sharkBullets.size(); i < count;) {
+        if (entityGone[i]) {
+            destroySharkBullet(sharkBullets.handleAt(i));
+            --count;
+            entityGone[i] = entityGone[count];
+            entityCells[i] = entityCells[count];
+        }
+        else {
+            if (useGrid) grid.place(static_cast<int>(GridKind::SharkBullet), sharkBullets.handleAt(i), entityCells[i]);
+            ++i;
         }
     }
 
-    for (auto& t : targets) {
-        if (t.active) {
-            t.x += t.dx * deltaTime; t.y += t.dy * deltaTime;
-            if (CheckCollisionWithChitbox(t)) {
-                t.active = false; 
-                HandleHit(); 
-            }
-            else if (CheckCollisionWithArc(t)) {
-                t.active = false; 
-                score += SCORE_PER_MISSILE; 
-                updateScoreTexture(); 
-                 if (sfxShieldHit) Mix_PlayChannel(CHANNEL_SFX, sfxShieldHit, 0); 
-            }
+    resolveShieldContacts(deltaTime, useGrid);
+}
+
+// The same phases in fixed point, on this thread and in pool order; the
+// grid is not used. Sharks meet the ship before the shield, and bullets
+// whichever comes first along their path, as in resolveShieldContacts.
+void Game::stepEntitiesFixed(Uint32 now, Uint32 ms) {
+    for (size_t i = 0; i < allies.size();) {
+        AllyShip& ally = allies[i];
+        ally.fixedX += fixedStep(FIXED_ALLY_SPEED, ms);
+        ally.x = fixedToFloat(ally.fixedX);
+        if (ally.fixedX > fixedPixels(SCREEN_WIDTH)) {
+            allies.destroyAt(i);
+            continue;
+        }
+        if (ally.heal.isNull() && ally.fixedX >= fixedPixels(chitbox.x) && ally.fixedX <= fixedPixels(chitbox.x + chitbox.w)) {
+            HealItem heal;
+            heal.fixedX = ally.fixedX + fixedPixels(ALLY_WIDTH / 2 - HEAL_ITEM_WIDTH / 2);
+            heal.fixedY = fixedPixels(static_cast<int>(ally.y) + ALLY_HEIGHT);
+            heal.x = fixedToFloat(heal.fixedX);
+            heal.y = fixedToFloat(heal.fixedY);
+            heal.speed = HEAL_ITEM_DROP_SPEED;
+            ally.heal = healItems.create(heal);
         }
+        ++i;
     }
 
-    for (auto& fm : fastMissiles) {
-        if (fm.active) {
-            fm.x += fm.dx * deltaTime; fm.y += fm.dy * deltaTime;
-            if (CheckCollisionWithChitbox(fm)) {
-                fm.active = false; 
-                HandleHit(); 
-            }
-            else if (CheckCollisionWithArc(fm)) {
-                fm.active = false; 
-                score += SCORE_PER_FAST_MISSILE; 
-                updateScoreTexture(); 
-                 if (sfxShieldHit) Mix_PlayChannel(CHANNEL_SFX, sfxShieldHit, 0); 
-            }
+    for (size_t i = 0; i < healItems.size();) {
+        HealItem& heal = healItems[i];
+        heal.fixedY += fixedStep(FIXED_HEAL_ITEM_DROP_SPEED, ms);
+        heal.y = fixedToFloat(heal.fixedY);
+        if (heal.fixedY > fixedPixels(SCREEN_HEIGHT)) {
+            healItems.destroyAt(i);
+        }
+        else if (CheckCollisionWithChitbox(heal)) {
+            healItems.destroyAt(i);
+            HandleHealCollection();
+        }
+        else {
+            ++i;
         }
     }
 
-    targets.erase(std::remove_if(targets.begin(), targets.end(), [](const Target& t){ return !t.active; }), targets.end());
-    fastMissiles.erase(std::remove_if(fastMissiles.begin(), fastMissiles.end(), [](const Target& fm){ return !fm.active; }), fastMissiles.end());
-    spaceSharks.erase(std::remove_if(spaceSharks.begin(), spaceSharks.end(), [](const SpaceShark& ss){ return !ss.active; }), spaceSharks.end());
-    sharkBullets.erase(std::remove_if(sharkBullets.begin(), sharkBullets.end(), [](const SharkBullet& sb){ return !sb.active; }), sharkBullets.end());
-    allies.erase(std::remove_if(allies.begin(), allies.end(), [](const AllyShip& a){ return !a.active; }), allies.end());
-    healItems.erase(std::remove_if(healItems.begin(), healItems.end(), [](const HealItem& h){ return !h.active; }), healItems.end());
+    // destroy() moves the last entity into the hole, so i stays put.
+    for (size_t i = 0; i < spaceSharks.size();) {
+        SpaceShark& ss = spaceSharks[i];
+        advanceSharkFixed(ss, now);
+        Contact contact = CheckCollisionWithChitbox(ss) ? Contact::Ship :
+                          CheckCollisionWithArc(ss) ? Contact::Shield : Contact::None;
+        if (contact == Contact::None) {
+            ++i;
+            continue;
+        }
+        destroyShark(spaceSharks.handleAt(i));
+        applyContact(contact, true);
+    }
+
+    for (size_t i = 0; i < sharkBullets.size();) {
+        SharkBullet& sb = sharkBullets[i];
+        Fixed fromX = sb.fixedX, fromY = sb.fixedY;
+        sb.fixedX += fixedStep(sb.fixedDx, ms);
+        sb.fixedY += fixedStep(sb.fixedDy, ms);
+        sb.x = fixedToFloat(sb.fixedX);
+        sb.y = fixedToFloat(sb.fixedY);
+        bool gone = sb.fixedX < fixedPixels(-SHARK_BULLET_WIDTH) || sb.fixedX > fixedPixels(SCREEN_WIDTH + SHARK_BULLET_WIDTH) ||
+                    sb.fixedY < fixedPixels(-SHARK_BULLET_HEIGHT) || sb.fixedY > fixedPixels(SCREEN_HEIGHT + SHARK_BULLET_HEIGHT);
+        Contact contact = gone ? Contact::None : testBulletFixed(fromX, fromY, sb);
+        if (!gone && contact == Contact::None) {
+            ++i;
+            continue;
+        }
+        destroySharkBullet(sharkBullets.handleAt(i));
+        if (contact != Contact::None) applyContact(contact, false);
+    }
 }
 
 void Game::render() {
@@ -583,42 +667,38 @@ void Game::render() {
             }
         }
 
-        for (const auto& t : targets) { enemy->renderTarget(t); }
-        for (const auto& fm : fastMissiles) { enemy->renderFastMissile(fm); }
+        for (const auto& t : targets) { enemy->renderTarget(t, elapsedTime); }
+        for (const auto& fm : fastMissiles) { enemy->renderFastMissile(fm, elapsedTime); }
         for (const auto& ss : spaceSharks) { enemy->renderSpaceShark(ss); }
         for (const auto& sb : sharkBullets) { enemy->renderSharkBullet(sb); }
 
         if (showWarning) {
-            enemy->renderWarning(static_cast<float>(warningX), static_cast<float>(warningY), warningStartTime, startTime, totalPausedTime);
+            enemy->renderWarning(static_cast<float>(warningX), static_cast<float>(warningY), warningStartTime, elapsedTime);
         }
 
         for (const auto& ally : allies) {
-            if (ally.active && allyShipTexture) {
+            if (allyShipTexture) {
                 SDL_Rect allyRect = { (int)ally.x, (int)ally.y, ALLY_WIDTH, ALLY_HEIGHT };
                 SDL_RenderCopy(renderer, allyShipTexture, NULL, &allyRect);
             }
         }
         for (const auto& heal : healItems) {
-            if (heal.active && healItemTexture) {
+            if (healItemTexture) {
                 SDL_Rect healRect = { (int)heal.x, (int)heal.y, HEAL_ITEM_WIDTH, HEAL_ITEM_HEIGHT };
                 SDL_RenderCopy(renderer, healItemTexture, NULL, &healRect);
             }
         }
 
-        if (scoreTexture) {
-            int w, h; SDL_QueryTexture(scoreTexture, NULL, NULL, &w, &h);
-            SDL_Rect scoreRect = {SCREEN_WIDTH - w - INGAME_SCORE_TEXT_PADDING_X, 
-                                  INGAME_SCORE_TEXT_Y,                          
-                                  w, h};
-            SDL_RenderCopy(renderer, scoreTexture, NULL, &scoreRect);
+        if (practiceMode && practiceTexture) {
+            int pw, ph; SDL_QueryTexture(practiceTexture, NULL, NULL, &pw, &ph);
+            SDL_Rect practiceRect = {(SCREEN_WIDTH - pw) / 2, PRACTICE_LABEL_Y, pw, ph};
+            SDL_RenderCopy(renderer, practiceTexture, NULL, &practiceRect);
+        }
 
-            if (highscoreTexture) {
-                int hw, hh; SDL_QueryTexture(highscoreTexture, NULL, NULL, &hw, &hh);
-                SDL_Rect highscoreRect = {SCREEN_WIDTH - hw - INGAME_SCORE_TEXT_PADDING_X,      
-                                          scoreRect.y + h + INGAME_HIGHSCORE_TEXT_Y_OFFSET, 
-                                          hw, hh};
-                SDL_RenderCopy(renderer, highscoreTexture, NULL, &highscoreRect);
-            }
+        if (scoreLabel.isLoaded()) {
+            scoreLabel.render(renderer, SCREEN_WIDTH - scoreLabel.width() - INGAME_SCORE_TEXT_PADDING_X, INGAME_SCORE_TEXT_Y);
+            highscoreLabel.render(renderer, SCREEN_WIDTH - highscoreLabel.width() - INGAME_SCORE_TEXT_PADDING_X,
+                                  INGAME_SCORE_TEXT_Y + scoreLabel.height() + INGAME_HIGHSCORE_TEXT_Y_OFFSET);
         }
 
     } 
@@ -657,8 +737,8 @@ void Game::render() {
         SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE); 
 
         renderTextureAt(gameOverTextTexture, SCREEN_WIDTH / 2, GAMEOVER_TITLE_Y);
-        renderTextureAt(scoreTexture, SCREEN_WIDTH / 2, SCORE_LABEL_Y); 
-        renderTextureAt(highscoreTexture, SCREEN_WIDTH / 2, HIGHSCORE_LABEL_Y); 
+        scoreLabel.render(renderer, (SCREEN_WIDTH - scoreLabel.width()) / 2, SCORE_LABEL_Y);
+        highscoreLabel.render(renderer, (SCREEN_WIDTH - highscoreLabel.width()) / 2, HIGHSCORE_LABEL_Y);
 
         SDL_SetRenderDrawColor(renderer, BUTTON_COLOR.r, BUTTON_COLOR.g, BUTTON_COLOR.b, BUTTON_COLOR.a);
         SDL_RenderFillRect(renderer, &restartButton);
@@ -666,6 +746,8 @@ void Game::render() {
 
         SDL_RenderFillRect(renderer, &backToMenuButton);
         renderTextureCentered(backToMenuTexture, backToMenuButton);
+
+        if (practiceMode) renderTextureAt(practiceTexture, SCREEN_WIDTH / 2, PRACTICE_LABEL_Y);
     }
     else if (paused) {
         SDL_SetRenderDrawColor(renderer, PAUSE_OVERLAY_COLOR.r, PAUSE_OVERLAY_COLOR.g, PAUSE_OVERLAY_COLOR.b, PAUSE_OVERLAY_COLOR.a);
@@ -675,8 +757,8 @@ void Game::render() {
         SDL_SetRenderDrawBlendMode(renderer, SDL_BLENDMODE_NONE);
 
         renderTextureAt(pausedTexture, SCREEN_WIDTH / 2, PAUSED_TITLE_Y);
-        renderTextureAt(scoreTexture, SCREEN_WIDTH / 2, SCORE_LABEL_Y); 
-        renderTextureAt(highscoreTexture, SCREEN_WIDTH / 2, HIGHSCORE_LABEL_Y); 
+        scoreLabel.render(renderer, (SCREEN_WIDTH - scoreLabel.width()) / 2, SCORE_LABEL_Y);
+        highscoreLabel.render(renderer, (SCREEN_WIDTH - highscoreLabel.width()) / 2, HIGHSCORE_LABEL_Y);
 
         renderTextureAt(volumeLabelTexture, volumeSlider.x, VOLUME_LABEL_Y, false);
         SDL_SetRenderDrawColor(renderer, SLIDER_BG_COLOR.r, SLIDER_BG_COLOR.g, SLIDER_BG_COLOR.b, SLIDER_BG_COLOR.a);
@@ -690,7 +772,9 @@ void Game::render() {
         renderTextureCentered(giveUpTexture, giveUpButton);
     }
 
+    if (latency.wantsReadback()) latency.readArc(renderer);
     SDL_RenderPresent(renderer); 
+    latency.markPresented();
 }
 
 
@@ -703,41 +787,57 @@ void Game::reset() {
     targets.clear(); fastMissiles.clear(); spaceSharks.clear(); sharkBullets.clear();
     allies.clear();
     healItems.clear();
+    grid.clear();
     for (auto& life : lives) life.isRed = false;
     missileCount = INITIAL_MISSILE_COUNT;
     waveCount = 0;
     score = 0;
-    nextSpawnTime = INITIAL_SPAWN_DELAY; 
-    spawnedMissilesInWave = 0;
-    lastMissileSpawnTime = 0;
-    lastAllySpawnTime = 0;
+    missilesBlocked = 0;
+    elapsedTime = 0;
+    clockRemainderMs = 0.0f;
+    clockRemainderUs = 0;
+    lastSnapshotTime = 0;
+    rewindBuffer.clear();
+    timers.reset(0);
+    scheduleTimer(ALLY_SPAWN_INTERVAL, GameTimer::AllySpawn);
     arcStartAngle = INITIAL_SHIELD_START_ANGLE; 
-    wavesUntilIncrease = BASE_WAVES_UNTIL_INCREASE + dist_wave_increase(gen);
+    shieldBearing = FIXED_INITIAL_SHIELD;
     startTime = 0; 
     pauseStartTime = 0;
     totalPausedTime = 0;
-    justStarted = false; 
     isDraggingVolume = false; 
-    updateScoreTexture();
-    updateHighscoreTexture();
+    updateScoreLabel();
+    updateHighscoreLabel();
     if (menu) {
         setVolume(menu->volume);
         setSensitivity(menu->sensitivity);
+        Mix_HaltMusic();
     }
-    Mix_HaltMusic();
-    Mix_HaltChannel(CHANNEL_WARNING); 
+    queueSound(SoundType::WarningStop); 
+    discardSnapshot();
 }
 
 void Game::startGame() {
+    startGame(rd());
+}
+
+void Game::startGame(Uint32 seed) {
+    runSeed = seed;
+    rng.seed(runSeed);
+    timeline.start(waveScript, runSeed);
+    if (fixedPoint) arcStartAngle = binaryAngleToRadians(shieldBearing);
+
     startTime = SDL_GetTicks();
+    if (startTime == 0) startTime = 1;
     totalPausedTime = 0; 
     pauseStartTime = 0;
-    justStarted = true; 
+    syncShieldKeys();
     gameOver = false;
     paused = false;
-    updateScoreTexture();
-    updateHighscoreTexture();
+    updateScoreLabel();
+    updateHighscoreLabel();
 
+    if (!menu) return;
     Mix_HaltMusic();
     if (bgmGame) {
         Mix_PlayMusic(bgmGame, -1); 
@@ -746,40 +846,30 @@ void Game::startGame() {
     }
 }
 
-bool Game::CheckCollisionWithArc(const Target& t) {
-    if (!t.active) return false;
-    float targetCenterX = t.x; float targetCenterY = t.y; 
-    float dx = targetCenterX - trajectory.x; float dy = targetCenterY - trajectory.y;
-    float distSq = dx * dx + dy * dy; 
-
-    float collisionRadius = sqrt(MISSILE_COLLISION_RADIUS_SQ); 
-
-    float outerRadiusSq = (trajectory.r + collisionRadius) * (trajectory.r + collisionRadius);
-    float innerRadiusSq = (trajectory.r - collisionRadius) * (trajectory.r - collisionRadius);
-    if (innerRadiusSq < 0) innerRadiusSq = 0;
-
-    if (distSq > outerRadiusSq || distSq < innerRadiusSq) return false;
-
-    float targetAngle = atan2(dy, dx);
-    float normalizedArcStart = fmod(arcStartAngle, 2.0f * PI); if (normalizedArcStart < 0) normalizedArcStart += 2.0f * PI;
-    float normalizedArcEnd = fmod(arcStartAngle + SHIELD_ARC_ANGLE, 2.0f * PI); if (normalizedArcEnd < 0) normalizedArcEnd += 2.0f * PI;
-    float normalizedTargetAngle = fmod(targetAngle, 2.0f * PI); if (normalizedTargetAngle < 0) normalizedTargetAngle += 2.0f * PI;
+bool Game::shieldCoversAngle(float angle) const {
+    float normalizedArcStart = wrapAngle(arcStartAngle);
+    float normalizedArcEnd = wrapAngle(arcStartAngle + SHIELD_ARC_ANGLE);
+    float normalizedTargetAngle = wrapAngle(angle);
 
     if (normalizedArcStart <= normalizedArcEnd) {
         return (normalizedTargetAngle >= normalizedArcStart && normalizedTargetAngle <= normalizedArcEnd);
     }
-    else {
-        return (normalizedTargetAngle >= normalizedArcStart || normalizedTargetAngle <= normalizedArcEnd);
-    }
-    return false; 
+    return (normalizedTargetAngle >= normalizedArcStart || normalizedTargetAngle <= normalizedArcEnd);
 }
-bool Game::CheckCollisionWithChitbox(const Target& t) {
-     if (!t.active) return false;
-     SDL_Rect targetRect = { (int)(t.x - 2), (int)(t.y - 2), 5, 5 };
-    return SDL_HasIntersection(&targetRect, &chitbox);
+bool Game::shieldCovers(BinaryAngle bearing) const {
+    return binaryAngleWithin(bearing, shieldBearing, FIXED_SHIELD_ARC);
 }
-bool Game::CheckCollisionWithArc(const SpaceShark& ss) {
-    if (!ss.active) return false;
+// Within reach of the shield band, and on the arc, in fixed point.
+bool Game::touchesShieldFixed(Fixed x, Fixed y, Fixed reach) const {
+    int64_t dx = x - fixedPixels(trajectory.x), dy = y - fixedPixels(trajectory.y);
+    int64_t outer = fixedPixels(trajectory.r) + reach;
+    int64_t inner = std::max<int64_t>(fixedPixels(trajectory.r) - reach, 0);
+    int64_t distSq = dx * dx + dy * dy;
+    if (distSq > outer * outer || distSq < inner * inner) return false;
+    return shieldCovers(fixedAtan2(dy, dx));
+}
+bool Game::CheckCollisionWithArc(const SpaceShark& ss) const {
+    if (fixedPoint) return touchesShieldFixed(ss.fixedX, ss.fixedY, FIXED_SHARK_RADIUS);
     float targetCenterX = ss.x; float targetCenterY = ss.y;
     float dx = targetCenterX - trajectory.x; float dy = targetCenterY - trajectory.y;
     float distSq = dx * dx + dy * dy;
@@ -787,55 +877,176 @@ bool Game::CheckCollisionWithArc(const SpaceShark& ss) {
     float outerRadiusSq = (trajectory.r + collisionRadius) * (trajectory.r + collisionRadius);
     float innerRadiusSq = (trajectory.r - collisionRadius) * (trajectory.r - collisionRadius); if (innerRadiusSq < 0) innerRadiusSq = 0;
     if (distSq > outerRadiusSq || distSq < innerRadiusSq) return false;
-    float targetAngle = atan2(dy, dx);
-    float normalizedArcStart = fmod(arcStartAngle, 2.0f * PI); if (normalizedArcStart < 0) normalizedArcStart += 2.0f * PI;
-    float normalizedArcEnd = fmod(arcStartAngle + SHIELD_ARC_ANGLE, 2.0f * PI); if (normalizedArcEnd < 0) normalizedArcEnd += 2.0f * PI;
-    float normalizedTargetAngle = fmod(targetAngle, 2.0f * PI); if (normalizedTargetAngle < 0) normalizedTargetAngle += 2.0f * PI;
-    if (normalizedArcStart <= normalizedArcEnd) { return (normalizedTargetAngle >= normalizedArcStart && normalizedTargetAngle <= normalizedArcEnd); }
-    else { return (normalizedTargetAngle >= normalizedArcStart || normalizedTargetAngle <= normalizedArcEnd); }
-    return false;
-}
-bool Game::CheckCollisionWithChitbox(const SpaceShark& ss) {
-    if (!ss.active) return false;
+    return shieldCoversAngle(fastAtan2(dy, dx));
+}
+bool Game::CheckCollisionWithChitbox(const SpaceShark& ss) const {
+    if (fixedPoint) {
+        SDL_Rect sharkRect = { fixedFloor(ss.fixedX) - SHARK_CENTER.x, fixedFloor(ss.fixedY) - SHARK_CENTER.y, SHARK_WIDTH, SHARK_HEIGHT };
+        return SDL_HasIntersection(&sharkRect, &chitbox);
+    }
+    if (preciseHull && shipMask.isLoaded() && sharkMask.isLoaded()) {
+        return shipMask.overlaps(chitbox.x, chitbox.y, sharkMask.at(sharkHeading(ss)), (int)ss.x, (int)ss.y);
+    }
     SDL_Rect sharkRect = { (int)(ss.x - SHARK_CENTER.x), (int)(ss.y - SHARK_CENTER.y), SHARK_WIDTH, SHARK_HEIGHT };
     return SDL_HasIntersection(&sharkRect, &chitbox);
 }
-bool Game::CheckCollisionWithArc(const SharkBullet& sb) {
-    if (!sb.active) return false;
-    float targetCenterX = sb.x; float targetCenterY = sb.y;
-    float dx = targetCenterX - trajectory.x; float dy = targetCenterY - trajectory.y;
-    float distSq = dx * dx + dy * dy;
-    float collisionRadius = sqrt(SHARK_BULLET_COLLISION_RADIUS_SQ);  
-    float outerRadiusSq = (trajectory.r + collisionRadius) * (trajectory.r + collisionRadius);
-    float innerRadiusSq = (trajectory.r - collisionRadius) * (trajectory.r - collisionRadius); if (innerRadiusSq < 0) innerRadiusSq = 0;
-    if (distSq > outerRadiusSq || distSq < innerRadiusSq) return false;
-    float targetAngle = atan2(dy, dx);
-    float normalizedArcStart = fmod(arcStartAngle, 2.0f * PI); if (normalizedArcStart < 0) normalizedArcStart += 2.0f * PI;
-    float normalizedArcEnd = fmod(arcStartAngle + SHIELD_ARC_ANGLE, 2.0f * PI); if (normalizedArcEnd < 0) normalizedArcEnd += 2.0f * PI;
-    float normalizedTargetAngle = fmod(targetAngle, 2.0f * PI); if (normalizedTargetAngle < 0) normalizedTargetAngle += 2.0f * PI;
-    if (normalizedArcStart <= normalizedArcEnd) { return (normalizedTargetAngle >= normalizedArcStart && normalizedTargetAngle <= normalizedArcEnd); }
-    else { return (normalizedTargetAngle >= normalizedArcStart || normalizedTargetAngle <= normalizedArcEnd); }
-    return false;
-}
-bool Game::CheckCollisionWithChitbox(const SharkBullet& sb) {
-    if (!sb.active) return false;
-    SDL_Rect bulletRect = { (int)(sb.x - SHARK_BULLET_CENTER.x), (int)(sb.y - SHARK_BULLET_CENTER.y), SHARK_BULLET_WIDTH, SHARK_BULLET_HEIGHT };
-    return SDL_HasIntersection(&bulletRect, &chitbox);
-}
-
 bool Game::CheckCollisionWithChitbox(const HealItem& hi) {
-    if (!hi.active) return false;
     SDL_Rect healRect = { (int)hi.x, (int)hi.y, HEAL_ITEM_WIDTH, HEAL_ITEM_HEIGHT };
+    if (fixedPoint) healRect = { fixedFloor(hi.fixedX), fixedFloor(hi.fixedY), HEAL_ITEM_WIDTH, HEAL_ITEM_HEIGHT };
     return SDL_HasIntersection(&healRect, &chitbox);
 }
 
+// The ship and the shield only ever meet things near the centre, so both
+// tests start from the grid: a disc around the ship, then the sectors of
+// the arc within the shield band. The ship wins when both would apply.
+// Bullets are tested along the path they took this tick, so the queries
+// are widened by the farthest a bullet can have come since the band.
+void Game::resolveShieldContacts(float deltaTime, bool useGrid) {
+    float step = DEFAULT_MISSILE_SPEED * SHARK_BULLET_SPEED_MULTIPLIER * deltaTime;
+
+    // Anything touching the ship has its centre within the ship's farthest
+    // corner plus a shark's farthest corner at any rotation, plus a pixel
+    // for the int truncation.
+    float shipX = std::max(std::fabs(chitbox.x - trajectory.x), std::fabs(chitbox.x + chitbox.w - trajectory.x));
+    float shipY = std::max(std::fabs(chitbox.y - trajectory.y), std::fabs(chitbox.y + chitbox.h - trajectory.y));
+    float sharkX = static_cast<float>(std::max(SHARK_CENTER.x, SHARK_WIDTH - SHARK_CENTER.x));
+    float sharkY = static_cast<float>(std::max(SHARK_CENTER.y, SHARK_HEIGHT - SHARK_CENTER.y));
+    float shipReach = std::sqrt(shipX * shipX + shipY * shipY) + std::sqrt(sharkX * sharkX + sharkY * sharkY) + 1.0f;
+
+    gridHits.clear();
+    if (useGrid) grid.queryDisc(shipReach + step, gridHits);
+    else collectWithin(0.0f, shipReach + step);
+    applyContacts(false, deltaTime);
+
+    float reach = std::sqrt(std::max(SHARK_COLLISION_RADIUS_SQ, SHARK_BULLET_COLLISION_RADIUS_SQ));
+    float inner = trajectory.r - reach;
+    float spread = step < inner ? std::asin(step / inner) : PI;
+    gridHits.clear();
+    if (useGrid) grid.queryArc(arcStartAngle - spread, SHIELD_ARC_ANGLE + 2.0f * spread, inner - step, trajectory.r + reach + step, gridHits);
+    else collectWithin(inner - step, trajectory.r + reach + step);
+    applyContacts(true, deltaTime);
+}
+
+// The pool scan used instead of the grid: every shark and bullet whose
+// centre lies between rMin and rMax of the ring centre, in pool order.
+void Game::collectWithin(float rMin, float rMax) {
+    float minSq = rMin > 0.0f ? rMin * rMin : 0.0f, maxSq = rMax * rMax;
+    auto within = [&](float x, float y) {
+        float dx = x - trajectory.x, dy = y - trajectory.y;
+        float distSq = dx * dx + dy * dy;
+        return distSq >= minSq && distSq <= maxSq;
+    };
+    for (size_t i = 0; i < spaceSharks.size(); ++i) {
+        if (within(spaceSharks[i].x, spaceSharks[i].y)) gridHits.push_back(PolarGridHit{static_cast<int>(GridKind::Shark), spaceSharks.handleAt(i)});
+    }
+    for (size_t i = 0; i < sharkBullets.size(); ++i) {
+        if (within(sharkBullets[i].x, sharkBullets[i].y)) gridHits.push_back(PolarGridHit{static_cast<int>(GridKind::SharkBullet), sharkBullets.handleAt(i)});
+    }
+}
+
+// Every candidate is tested first, in ranges like the movement, and the
+// outcomes are applied in query order, so threading cannot change which
+// hits land or in what order. A bullet that reached the ship and the
+// shield in the same tick goes to whichever it met first along its path;
+// the shield is where it stands at the end of the tick.
+Contact Game::testContact(const PolarGridHit& hit, bool shieldPass, float deltaTime) const {
+    if (hit.kind == static_cast<int>(GridKind::Shark)) {
+        const SpaceShark* ss = spaceSharks.get(hit.handle);
+        if (!ss) return Contact::None;
+        if (shieldPass) return CheckCollisionWithArc(*ss) ? Contact::Shield : Contact::None;
+        return CheckCollisionWithChitbox(*ss) ? Contact::Ship : Contact::None;
+    }
+
+    const SharkBullet* sb = sharkBullets.get(hit.handle);
+    if (!sb) return Contact::None;
+    float fromX = sb->x - sb->dx * deltaTime, fromY = sb->y - sb->dy * deltaTime;
+    float shipT = 0.0f, shieldT = 0.0f;
+    bool ship = preciseHull && shipMask.isLoaded() && sharkBulletMask.isLoaded() ?
+                maskContact(fromX, fromY, sb->x, sb->y, sharkBulletMask.at(fastAtan2(sb->dy, sb->dx)), shipT) :
+                sweepRect(fromX, fromY, sb->x, sb->y,
+                          static_cast<float>(chitbox.x + SHARK_BULLET_CENTER.x - SHARK_BULLET_WIDTH),
+                          static_cast<float>(chitbox.y + SHARK_BULLET_CENTER.y - SHARK_BULLET_HEIGHT),
+                          static_cast<float>(chitbox.x + chitbox.w + SHARK_BULLET_CENTER.x),
+                          static_cast<float>(chitbox.y + chitbox.h + SHARK_BULLET_CENTER.y), shipT);
+    float collisionRadius = std::sqrt(SHARK_BULLET_COLLISION_RADIUS_SQ);
+    bool shield = sweepArcBand(fromX, fromY, sb->x, sb->y, trajectory.x, trajectory.y,
+                               trajectory.r - collisionRadius, trajectory.r + collisionRadius,
+                               arcStartAngle, SHIELD_ARC_ANGLE, shieldT);
+    if (ship && (!shield || shipT <= shieldT)) return Contact::Ship;
+    return shield ? Contact::Shield : Contact::None;
+}
+
+void Game::applyContacts(bool shieldPass, float deltaTime) {
+    contactOutcomes.resize(gridHits.size());
+    forEachRange(jobs, gridHits.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) contactOutcomes[i] = testContact(gridHits[i], shieldPass, deltaTime);
+    });
+
+    for (size_t i = 0; i < gridHits.size(); ++i) {
+        const PolarGridHit& hit = gridHits[i];
+        if (contactOutcomes[i] == Contact::None) continue;
+        bool shark = hit.kind == static_cast<int>(GridKind::Shark);
+        if (shark ? !spaceSharks.get(hit.handle) : !sharkBullets.get(hit.handle)) continue;
+
+        if (shark) destroyShark(hit.handle);
+        else destroySharkBullet(hit.handle);
+        applyContact(contactOutcomes[i], shark);
+    }
+}
+
+void Game::applyContact(Contact contact, bool shark) {
+    if (contact == Contact::Ship) {
+        HandleHit();
+        return;
+    }
+    if (shark) {
+        score += SCORE_PER_SHARK;
+        updateScoreLabel();
+    }
+    missilesBlocked++;
+    queueSound(SoundType::ShieldHit, sfxShieldHit);
+}
+
+// The path a bullet took this tick is sampled every FIXED_SWEEP_STEP_PX or
+// closer, so a long tick cannot carry it across the band or the ship. The
+// first sample touching either decides, the ship on a tie.
+Contact Game::testBulletFixed(Fixed fromX, Fixed fromY, const SharkBullet& sb) const {
+    int64_t dx = sb.fixedX - fromX, dy = sb.fixedY - fromY;
+    int64_t steps = static_cast<int64_t>(isqrt(static_cast<uint64_t>(dx * dx + dy * dy))) / fixedPixels(FIXED_SWEEP_STEP_PX) + 1;
+    for (int64_t k = 1; k <= steps; ++k) {
+        Fixed x = fromX + static_cast<Fixed>(dx * k / steps), y = fromY + static_cast<Fixed>(dy * k / steps);
+        SDL_Rect bulletRect = { fixedFloor(x) - SHARK_BULLET_CENTER.x, fixedFloor(y) - SHARK_BULLET_CENTER.y, SHARK_BULLET_WIDTH, SHARK_BULLET_HEIGHT };
+        if (SDL_HasIntersection(&bulletRect, &chitbox)) return Contact::Ship;
+        if (touchesShieldFixed(x, y, FIXED_SHARK_BULLET_RADIUS)) return Contact::Shield;
+    }
+    return Contact::None;
+}
+
+void Game::destroyShark(EntityHandle handle) {
+    grid.remove(static_cast<int>(GridKind::Shark), handle);
+    spaceSharks.destroy(handle);
+}
+
+void Game::destroySharkBullet(EntityHandle handle) {
+    grid.remove(static_cast<int>(GridKind::SharkBullet), handle);
+    sharkBullets.destroy(handle);
+}
+
+// stepEntities files every live entity again before the grid is next
+// queried, so after a restore it only has to forget the old slots.
+void Game::rebuildGrid() {
+    grid.clear();
+}
+
 
 void Game::DrawCircle(SDL_Renderer* renderer, const Circle& c) {
     SDL_Point points[CIRCLE_SEGMENTS + 1];
     for (int i = 0; i <= CIRCLE_SEGMENTS; ++i) {
         float rad = (2.0f * PI * i) / CIRCLE_SEGMENTS;
-        points[i].x = c.x + static_cast<int>(c.r * cos(rad));
-        points[i].y = c.y + static_cast<int>(c.r * sin(rad));
+        float s, co;
+        fastSinCos(rad, s, co);
+        points[i].x = c.x + static_cast<int>(c.r * co);
+        points[i].y = c.y + static_cast<int>(c.r * s);
     }
     SDL_RenderDrawLines(renderer, points, CIRCLE_SEGMENTS + 1);
 }
@@ -844,15 +1055,18 @@ void Game::DrawArc(SDL_Renderer* renderer, const Circle& c, double startAngle, d
     SDL_Point points[ARC_SEGMENTS + 1];
     for (int i = 0; i <= ARC_SEGMENTS; ++i) {
         double angle = startAngle + (arcAngle * i / ARC_SEGMENTS); 
-        points[i].x = c.x + static_cast<int>(c.r * cos(angle));
-        points[i].y = c.y + static_cast<int>(c.r * sin(angle));
+        float s, co;
+        fastSinCos(static_cast<float>(angle), s, co);
+        points[i].x = c.x + static_cast<int>(c.r * co);
+        points[i].y = c.y + static_cast<int>(c.r * s);
     }
     SDL_RenderDrawLines(renderer, points, ARC_SEGMENTS + 1); 
 }
 
 void Game::HandleHit() {
     if (gameOver) return; 
-    if (sfxPlayerHit) Mix_PlayChannel(CHANNEL_SFX, sfxPlayerHit, 0);
+    queueSound(SoundType::PlayerHit, sfxPlayerHit);
+    if (invulnerable) return;
     for (auto& life : lives) {
         if (!life.isRed) {
             life.isRed = true;
@@ -873,14 +1087,14 @@ checkGameOver:
     }
 }
 
-void Game::HandleHealCollection(HealItem& heal) {
-    if (!heal.active) return; 
-
-    heal.active = false; 
+int Game::getLivesLeft() const {
+    int left = 0;
+    for (const auto& life : lives) left += life.isRed ? 0 : 1;
+    return left;
+}
 
-    if (sfxHealCollect) {
-        Mix_PlayChannel(CHANNEL_SFX, sfxHealCollect, 0);
-    }
+void Game::HandleHealCollection() {
+    queueSound(SoundType::HealCollect, sfxHealCollect);
 
     for (auto& life : lives) {
         if (life.isRed) {
@@ -894,11 +1108,11 @@ void Game::HandleHealCollection(HealItem& heal) {
 void Game::SpawnAlly() {
     AllyShip ally;
     ally.x = 0.0f - ALLY_WIDTH; 
+    ally.fixedX = fixedPixels(-ALLY_WIDTH);
     ally.y = 10.0f;         
     ally.speed = ALLY_SPEED;
-    ally.active = true;
-    ally.droppingHeal = false; 
-    allies.push_back(ally);   
+    ally.heal = NULL_ENTITY; 
+    allies.create(ally);   
 }
 
 
@@ -913,6 +1127,7 @@ void Game::setVolume(int vol) {
         }
         Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100); 
         Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100); 
+        if (menu && menu->audio) menu->audio->setEffectsVolume(volume * MIX_MAX_VOLUME / 100);
     }
  }
 
@@ -923,9 +1138,10 @@ void Game::setGameStatePlaying() {
         }
         paused = false; 
         pauseStartTime = 0; 
+        syncShieldKeys();
         Mix_ResumeMusic();
         if (showWarning) {
-             if (sfxWarning) Mix_PlayChannel(CHANNEL_WARNING, sfxWarning, -1);
+             queueSound(SoundType::WarningStart, sfxWarning);
         }
      }
 }
@@ -934,18 +1150,433 @@ void Game::setGameStatePaused() {
         pauseStartTime = SDL_GetTicks(); 
         paused = true; 
          Mix_PauseMusic(); 
-         Mix_HaltChannel(CHANNEL_WARNING); 
+         queueSound(SoundType::WarningStop); 
+        saveSnapshot();
     }
 }
+// Shield keys are queued with their SDL timestamps while a run is live and
+// replayed in update(), so a press halfway through a frame only turns the
+// shield for the half it was actually held.
+void Game::recordShieldKey(SDL_Scancode key, bool down, Uint32 timestamp) {
+    if (paused || gameOver || startTime == 0 || shieldKeyEvents.size() >= SHIELD_KEY_QUEUE_CAPACITY) {
+        applyShieldKey(key, down);
+        return;
+    }
+    shieldKeyEvents.push_back(ShieldKeyEvent{timestamp, key, down});
+    latency.markInput(timestamp);
+}
+
+float Game::getShieldTurnRate() const {
+    float sensitivityFactor = MIN_SENSITIVITY_MULTIPLIER + (static_cast<float>(sensitivity) / 100.0f) * (MAX_SENSITIVITY_MULTIPLIER - MIN_SENSITIVITY_MULTIPLIER);
+    return SHIELD_ROTATION_SPEED_FACTOR * sensitivityFactor;
+}
+
+void Game::setShieldTurn(int direction) {
+    shieldKeyEvents.clear();
+    shieldLeftHeld = direction < 0;
+    shieldRightHeld = direction > 0;
+}
+
+void Game::applyShieldKey(SDL_Scancode key, bool down) {
+    if (key == SDL_SCANCODE_A) shieldLeftHeld = down;
+    else if (key == SDL_SCANCODE_D) shieldRightHeld = down;
+}
+
+void Game::syncShieldKeys() {
+    const Uint8* keys = SDL_GetKeyboardState(NULL);
+    shieldKeyEvents.clear();
+    shieldLeftHeld = keys && keys[SDL_SCANCODE_A];
+    shieldRightHeld = keys && keys[SDL_SCANCODE_D];
+}
+
+// Splits the tick at each queued key event and returns the net time the
+// shield was turning, in ms: positive clockwise (D), negative for A.
+// The tick is taken to end now and last tickMs; events from before its
+// start (e.g. a long frame) count from the start.
+float Game::consumeShieldInput(float tickMs) {
+    Uint32 now = SDL_GetTicks();
+    float cursor = 0.0f;
+    float turnMs = 0.0f;
+    if (!shieldKeyEvents.empty()) latency.markUpdate();
+    for (const ShieldKeyEvent& e : shieldKeyEvents) {
+        float age = e.timestamp < now ? static_cast<float>(now - e.timestamp) : 0.0f;
+        float at = std::max(cursor, std::min(tickMs, tickMs - age));
+        turnMs += (static_cast<int>(shieldRightHeld) - static_cast<int>(shieldLeftHeld)) * (at - cursor);
+        cursor = at;
+        applyShieldKey(e.key, e.down);
+    }
+    turnMs += (static_cast<int>(shieldRightHeld) - static_cast<int>(shieldLeftHeld)) * (tickMs - cursor);
+    shieldKeyEvents.clear();
+    return turnMs;
+}
+
+void Game::scheduleTimer(Uint32 due, GameTimer kind, EntityHandle target) {
+    timers.schedule(due, static_cast<uint32_t>(kind), target.value);
+}
+
+// Handlers reschedule from the time the event was due, not the frame time,
+// so after a long frame a follow-up may already be due; keep going until
+// nothing more fires.
+void Game::runTimers(Uint32 now) {
+    do {
+        firedTimers.clear();
+        timers.advance(now, firedTimers);
+        for (const TimerEvent& event : firedTimers) onTimer(event);
+    } while (!firedTimers.empty());
+}
+
+void Game::onTimer(const TimerEvent& event) {
+    switch (static_cast<GameTimer>(event.kind)) {
+        case GameTimer::AllySpawn:
+            SpawnAlly();
+            scheduleTimer(event.due + ALLY_SPAWN_INTERVAL, GameTimer::AllySpawn);
+            break;
+
+        case GameTimer::WarningEnd: {
+            if (!showWarning) break;
+            showWarning = false; 
+            queueSound(SoundType::WarningStop); 
+            if (fixedPoint) {
+                Fixed speed = static_cast<Fixed>(static_cast<int64_t>(missileSpeedFixed()) * FIXED_FAST_MISSILE_SPEED_MULTIPLIER >> FIXED_SHIFT);
+                launchMissileFixed(fastMissiles, GameTimer::FastMissileCheck, warningX, warningY, speed, FIXED_FAST_MISSILE_RADIUS, event.due);
+                break;
+            }
+            float baseSpeed = missileSpeed();
+            launchMissile(fastMissiles, GameTimer::FastMissileCheck, fastMissileMask, static_cast<float>(warningX), static_cast<float>(warningY),
+                          baseSpeed * FAST_MISSILE_SPEED_MULTIPLIER, sqrt(FAST_MISSILE_COLLISION_RADIUS_SQ), event.due);
+            break;
+        }
+
+        case GameTimer::SharkFire: {
+            SpaceShark* ss = spaceSharks.get(EntityHandle{event.target});
+            if (!ss) break;
+            SharkBullet sb;
+            sb.x = ss->x; sb.y = ss->y; 
+            if (fixedPoint) {
+                sb.fixedX = ss->fixedX; sb.fixedY = ss->fixedY;
+                aimAtCentre(sb.fixedX, sb.fixedY, FIXED_SHARK_BULLET_SPEED, sb.fixedDx, sb.fixedDy);
+                sb.dx = fixedToFloat(sb.fixedDx);
+                sb.dy = fixedToFloat(sb.fixedDy);
+            } else {
+                float distX = static_cast<float>(TRAJECTORY_CENTER.x) - sb.x;
+                float distY = static_cast<float>(TRAJECTORY_CENTER.y) - sb.y;
+                float distance = sqrt(distX * distX + distY * distY);
+                if (distance < 1e-6f) distance = 1.0f;
+                float bulletSpeed = DEFAULT_MISSILE_SPEED * SHARK_BULLET_SPEED_MULTIPLIER;
+                sb.dx = (distX / distance) * bulletSpeed;
+                sb.dy = (distY / distance) * bulletSpeed;
+            }
+            sharkBullets.create(sb); 
+            scheduleTimer(event.due + waveScript.sharkFireInterval, GameTimer::SharkFire, EntityHandle{event.target});
+            break;
+        }
+
+        case GameTimer::SharkExpire:
+            destroyShark(EntityHandle{event.target});
+            break;
+
+        case GameTimer::MissileCheck:
+            checkMissile(targets, GameTimer::MissileCheck, EntityHandle{event.target}, SCORE_PER_MISSILE);
+            break;
+
+        case GameTimer::FastMissileCheck:
+            checkMissile(fastMissiles, GameTimer::FastMissileCheck, EntityHandle{event.target}, SCORE_PER_FAST_MISSILE);
+            break;
+    }
+}
+
+// Fixed-point runs draw through randomBelow, so they do not depend on how
+// the standard library implements the distribution.
+int Game::randomInt(std::uniform_int_distribution<>& dist) {
+    if (!fixedPoint) return dist(rng);
+    return dist.a() + static_cast<int>(randomBelow(rng, static_cast<uint32_t>(dist.b() - dist.a() + 1)));
+}
+
+float Game::missileSpeed() {
+    float range = static_cast<float>(waveScript.missileSpeedMax - waveScript.missileSpeedMin);
+    return static_cast<float>(waveScript.missileSpeedMin) + static_cast<float>(dis(rng)) * range;
+}
+
+Fixed Game::missileSpeedFixed() {
+    uint32_t range = static_cast<uint32_t>(waveScript.missileSpeedMax - waveScript.missileSpeedMin) << FIXED_SHIFT;
+    return fixedPixels(waveScript.missileSpeedMin) + static_cast<Fixed>(randomBelow(rng, range));
+}
+
+void Game::spawnMissile(Uint32 now) {
+    float x = 0.0f, y = 0.0f;
+    int side = randomInt(dist_side);
+    switch (side) {
+        case 0: x = 0.0f - MISSILE_WIDTH; y = static_cast<float>(randomInt(dist_y_spawn)); break; 
+        case 1: x = static_cast<float>(SCREEN_WIDTH); y = static_cast<float>(randomInt(dist_y_spawn)); break; 
+        case 2: x = static_cast<float>(randomInt(dist_x_spawn)); y = 0.0f - MISSILE_HEIGHT; break; 
+        case 3: x = static_cast<float>(randomInt(dist_x_spawn)); y = static_cast<float>(SCREEN_HEIGHT); break;
+    }
+    if (fixedPoint) {
+        launchMissileFixed(targets, GameTimer::MissileCheck, static_cast<int>(x), static_cast<int>(y), missileSpeedFixed(), FIXED_MISSILE_RADIUS, now);
+        return;
+    }
+    launchMissile(targets, GameTimer::MissileCheck, missileMask, x, y, missileSpeed(), sqrt(MISSILE_COLLISION_RADIUS_SQ), now);
+}
+
+namespace {
+
+Uint32 msAfter(Uint32 start, float seconds) {
+    if (seconds <= 0.0f) return start;
+    return start + static_cast<Uint32>(std::min(std::ceil(seconds * 1000.0f), 1e9f));
+}
+
+// Seconds until a point moving from o at velocity v is strictly inside
+// (lo, hi) on one axis; entry and exit narrow the window across axes.
+void clipSlab(float o, float v, float lo, float hi, float& entry, float& exit) {
+    if (v == 0.0f) {
+        if (o <= lo || o >= hi) exit = -1.0f;
+        return;
+    }
+    float a = (lo - o) / v, b = (hi - o) / v;
+    entry = std::max(entry, std::min(a, b));
+    exit = std::min(exit, std::max(a, b));
+}
+
+constexpr Uint32 FIXED_NEVER_MS = 1000000000;
+
+// Whole ms, rounded up, to cover distance at speed.
+Uint32 msToTravel(Fixed distance, Fixed speed) {
+    if (distance <= 0) return 0;
+    if (speed <= 0) return FIXED_NEVER_MS;
+    return static_cast<Uint32>(std::min<int64_t>((static_cast<int64_t>(distance) * 1000 + speed - 1) / speed, FIXED_NEVER_MS));
+}
+
+// clipSlab in fixed point, with times in microseconds.
+void clipSlabFixed(Fixed o, Fixed v, Fixed lo, Fixed hi, int64_t& entry, int64_t& exit) {
+    if (v == 0) {
+        if (o <= lo || o >= hi) exit = -1;
+        return;
+    }
+    int64_t a = (static_cast<int64_t>(lo) - o) * 1000000 / v, b = (static_cast<int64_t>(hi) - o) * 1000000 / v;
+    entry = std::max(entry, std::min(a, b));
+    exit = std::min(exit, std::max(a, b));
+}
+
+}
+
+// Missiles head straight for the ring centre at constant speed, so when
+// they cross the shield band and when their 5x5 box first overlaps the
+// hitbox are known at launch. A timer at the band time checks it then, so
+// the pool needs no order.
+void Game::launchMissile(EntityPool<Target>& missiles, GameTimer check, const RotatedSpriteMask& shape, float originX, float originY, float speed, float collisionRadius, Uint32 now) {
+    Target t;
+    t.originX = originX;
+    t.originY = originY;
+    float distX = static_cast<float>(TRAJECTORY_CENTER.x) - originX;
+    float distY = static_cast<float>(TRAJECTORY_CENTER.y) - originY;
+    float distance = sqrt(distX * distX + distY * distY);
+    if (distance < 1e-6f) distance = 1.0f;
+    t.dx = (distX / distance) * speed;
+    t.dy = (distY / distance) * speed;
+    t.spawnTime = now;
+    t.bandTime = msAfter(now, (distance - (trajectory.r + collisionRadius)) / speed);
+    t.bandExitTime = msAfter(now, (distance - (trajectory.r - collisionRadius)) / speed);
+
+    float entry = 0.0f, exit = 1e9f;
+    if (preciseHull && shipMask.isLoaded() && shape.isLoaded()) {
+        float along = 0.0f;
+        bool contact = maskContact(originX, originY, static_cast<float>(TRAJECTORY_CENTER.x), static_cast<float>(TRAJECTORY_CENTER.y),
+                                   shape.at(fastAtan2(t.dy, t.dx)), along);
+        entry = along * distance / speed;
+        if (!contact) exit = -1.0f;
+    } else {
+        clipSlab(originX, t.dx, chitbox.x - 3.0f, chitbox.x + chitbox.w + 2.0f, entry, exit);
+        clipSlab(originY, t.dy, chitbox.y - 3.0f, chitbox.y + chitbox.h + 2.0f, entry, exit);
+    }
+    t.hitTime = entry <= exit ? msAfter(now, entry) : msAfter(now, 1e9f);
+    if (static_cast<int32_t>(t.bandTime - t.hitTime) > 0) t.bandTime = t.hitTime;
+    t.reachedBand = false;
+
+    EntityHandle handle = missiles.create(t);
+    if (!handle.isNull()) scheduleTimer(t.bandTime, check, handle);
+}
+
+// launchMissile in fixed point; the hitbox only, and the shield test keeps
+// the bearing rather than working it out at every check.
+void Game::launchMissileFixed(EntityPool<Target>& missiles, GameTimer check, int originX, int originY, Fixed speed, Fixed collisionRadius, Uint32 now) {
+    Target t;
+    Fixed dx, dy;
+    Fixed distance = aimAtCentre(fixedPixels(originX), fixedPixels(originY), speed, dx, dy);
+    t.originX = static_cast<float>(originX);
+    t.originY = static_cast<float>(originY);
+    t.dx = fixedToFloat(dx);
+    t.dy = fixedToFloat(dy);
+    t.bearing = fixedAtan2(originY - trajectory.y, originX - trajectory.x);
+    t.spawnTime = now;
+    t.bandTime = now + msToTravel(distance - (fixedPixels(trajectory.r) + collisionRadius), speed);
+    t.bandExitTime = now + msToTravel(distance - (fixedPixels(trajectory.r) - collisionRadius), speed);
+
+    int64_t entry = 0, exit = static_cast<int64_t>(FIXED_NEVER_MS) * 1000;
+    clipSlabFixed(fixedPixels(originX), dx, fixedPixels(chitbox.x - 3), fixedPixels(chitbox.x + chitbox.w + 2), entry, exit);
+    clipSlabFixed(fixedPixels(originY), dy, fixedPixels(chitbox.y - 3), fixedPixels(chitbox.y + chitbox.h + 2), entry, exit);
+    t.hitTime = now + (entry <= exit ? static_cast<Uint32>((entry + 999) / 1000) : FIXED_NEVER_MS);
+    if (static_cast<int32_t>(t.bandTime - t.hitTime) > 0) t.bandTime = t.hitTime;
+    t.reachedBand = false;
+
+    EntityHandle handle = missiles.create(t);
+    if (!handle.isNull()) scheduleTimer(t.bandTime, check, handle);
+}
+
+// First fraction of the segment at which mask, drawn around a point moving
+// along it, touches the ship's mask. Only the stretch where the bounding
+// boxes overlap is walked, a pixel at a time.
+bool Game::maskContact(float x0, float y0, float x1, float y1, const SpriteMask& mask, float& t) const {
+    float entry = 0.0f, exit = 1.0f;
+    clipSlab(x0, x1 - x0, static_cast<float>(chitbox.x - mask.offsetX() - mask.width()), static_cast<float>(chitbox.x + chitbox.w - mask.offsetX()), entry, exit);
+    clipSlab(y0, y1 - y0, static_cast<float>(chitbox.y - mask.offsetY() - mask.height()), static_cast<float>(chitbox.y + chitbox.h - mask.offsetY()), entry, exit);
+    if (entry > exit) return false;
+
+    float length = std::sqrt((x1 - x0) * (x1 - x0) + (y1 - y0) * (y1 - y0));
+    float step = length > 1.0f ? 1.0f / length : 1.0f;
+    for (float f = entry;; f += step) {
+        if (f > exit) f = exit;
+        if (shipMask.overlaps(chitbox.x, chitbox.y, mask, (int)(x0 + (x1 - x0) * f), (int)(y0 + (y1 - y0) * f))) {
+            t = f;
+            return true;
+        }
+        if (f >= exit) return false;
+    }
+}
+
+void Game::setPreciseHull(bool enabled) {
+    preciseHull = enabled;
+    if (!enabled || shipMask.isLoaded()) return;
+    bool loaded = loadSpriteMask(IMG_SPACESHIP, chitbox.w, chitbox.h, shipMask) &&
+                  missileMask.load(IMG_MISSILE, MISSILE_WIDTH, MISSILE_HEIGHT, MISSILE_CENTER) &&
+                  fastMissileMask.load(IMG_FAST_MISSILE, FAST_MISSILE_WIDTH, FAST_MISSILE_HEIGHT, FAST_MISSILE_CENTER) &&
+                  sharkMask.load(IMG_SPACE_SHARK, SHARK_WIDTH, SHARK_HEIGHT, SHARK_CENTER) &&
+                  sharkBulletMask.load(IMG_SHARK_BULLET, SHARK_BULLET_WIDTH, SHARK_BULLET_HEIGHT, SHARK_BULLET_CENTER);
+    if (!loaded) std::cerr << "Warning: collision masks incomplete, using the hitbox where missing." << std::endl;
+}
+
+// First due at bandTime, then every frame while the missile is inside the
+// shield band, then once more at hitTime if nothing stopped it. A missile
+// that crossed the whole band between two frames still gets one shield
+// check, and gets it before the hull check if it reached the band first, so
+// a long tick cannot carry it through the shield into the ship.
+void Game::checkMissile(EntityPool<Target>& missiles, GameTimer check, EntityHandle handle, int points) {
+    Target* t = missiles.get(handle);
+    if (!t) return;
+    Uint32 now = elapsedTime;
+    bool hit = static_cast<int32_t>(now - t->hitTime) >= 0;
+    bool bandFirst = !t->reachedBand && t->bandTime != t->hitTime;
+    if ((!hit || bandFirst) && (!t->reachedBand || static_cast<int32_t>(now - t->bandExitTime) < 0)) {
+        t->reachedBand = true;
+        bool covered = fixedPoint ? shieldCovers(t->bearing) :
+                       shieldCoversAngle(fastAtan2(t->originY - trajectory.y, t->originX - trajectory.x));
+        if (covered) {
+            missiles.destroy(handle);
+            score += points; 
+            missilesBlocked++;
+            updateScoreLabel(); 
+             queueSound(SoundType::ShieldHit, sfxShieldHit); 
+            return;
+        }
+    }
+    if (hit) {
+        missiles.destroy(handle);
+        HandleHit(); 
+        return;
+    }
+    Uint32 next = static_cast<int32_t>(now + 1 - t->bandExitTime) < 0 ? now + 1 : t->hitTime;
+    scheduleTimer(next, check, handle);
+}
+void Game::addStressSharks(size_t count) {
+    for (size_t i = 0; i < count; ++i) spawnShark(elapsedTime);
+}
+
+void Game::spawnShark(Uint32 now) {
+    SpaceShark ss;
+    ss.startRadius = SHARK_INITIAL_RADIUS;
+    ss.spawnTime = now;
+    if (fixedPoint) {
+        ss.startBearing = rng();
+        ss.turnRate = rng() >> 31 ? FIXED_SHARK_TURN : -FIXED_SHARK_TURN;
+        ss.startAngle = binaryAngleToRadians(ss.startBearing);
+        ss.angularSpeed = (ss.turnRate > 0 ? 1.0f : -1.0f) * SHARK_ANGULAR_SPEED;
+        advanceSharkFixed(ss, now);
+    } else {
+        ss.startAngle = static_cast<float>(dis(rng)) * 2.0f * PI; 
+        ss.angularSpeed = (dis(rng) > 0.5 ? 1.0f : -1.0f) * SHARK_ANGULAR_SPEED;
+        fastSinCos(ss.startAngle, ss.dirY, ss.dirX);
+        ss.dirTime = now;
+        ss.radius = ss.startRadius;
+        ss.x = TRAJECTORY_CENTER.x + ss.radius * ss.dirX;
+        ss.y = TRAJECTORY_CENTER.y + ss.radius * ss.dirY;
+    }
+    EntityHandle handle = spaceSharks.create(ss);
+    if (handle.isNull()) return;
+    scheduleTimer(now + waveScript.sharkFireInterval, GameTimer::SharkFire, handle);
+    scheduleTimer(now + waveScript.sharkLifetime, GameTimer::SharkExpire, handle);
+}
+
+void Game::startWarning(Uint32 now) {
+    showWarning = true;
+    warningStartTime = now;
+    queueSound(SoundType::WarningStart, sfxWarning); 
+    int side = randomInt(dist_side);
+    switch (side) {
+        case 0: warningX = WARNING_ICON_WIDTH / 2; warningY = randomInt(dist_y_spawn); break; 
+        case 1: warningX = SCREEN_WIDTH - WARNING_ICON_WIDTH / 2; warningY = randomInt(dist_y_spawn); break; 
+        case 2: warningX = randomInt(dist_x_spawn); warningY = WARNING_ICON_HEIGHT / 2; break; 
+        case 3: warningX = randomInt(dist_x_spawn); warningY = SCREEN_HEIGHT - WARNING_ICON_HEIGHT / 2; break; 
+    }
+    scheduleTimer(now + FAST_MISSILE_WARNING_DURATION, GameTimer::WarningEnd);
+}
+
+void Game::applySpawn(const SpawnEvent& spawn) {
+    switch (spawn.kind) {
+        case SpawnKind::Wave:
+            waveCount = spawn.wave;
+            missileCount = spawn.missiles;
+            break;
+        case SpawnKind::Missile:
+            spawnMissile(spawn.time);
+            break;
+        case SpawnKind::FastMissile:
+            // There is a single warning marker; a wave that comes up while
+            // one is still showing does not get its own.
+            if (!showWarning) startWarning(spawn.time);
+            break;
+        case SpawnKind::Shark:
+            spawnShark(spawn.time);
+            break;
+    }
+}
+
+// Sharks that were blocked or hit the ship are gone by the time their
+// timers come up; those events are simply dropped.
+void Game::queueSound(SoundType type, Mix_Chunk* chunk) {
+    if (menu && menu->audio) menu->audio->post(type, chunk);
+}
+
+void Game::restartMusic() {
+    if (gameOver) return;
+    if (bgmGame) {
+        Mix_PlayMusic(bgmGame, -1);
+        if (paused) Mix_PauseMusic();
+    }
+    if (showWarning && !paused) queueSound(SoundType::WarningStart, sfxWarning);
+}
 void Game::triggerGameOver() {
     if (!gameOver) { 
          gameOver = true; 
-         Mix_HaltMusic(); 
-         Mix_HaltChannel(CHANNEL_WARNING); 
-         if (sfxGameOver) Mix_PlayChannel(CHANNEL_SFX, sfxGameOver, 0);
-         if (menu) menu->saveHighscores(score);
-         updateScoreTexture();
-         updateHighscoreTexture();
+         if (menu) Mix_HaltMusic(); 
+         queueSound(SoundType::WarningStop); 
+         queueSound(SoundType::GameOver, sfxGameOver);
+         discardSnapshot();
+         if (menu && !practiceMode) {
+             RunRecord run = {static_cast<int64_t>(std::time(nullptr)), runSeed, score, waveCount, elapsedTime, static_cast<Uint32>(missilesBlocked)};
+             menu->recordRun(run);
+             menu->saveHighscores(score);
+         }
+         updateScoreLabel();
+         updateHighscoreLabel();
          if(paused) {
             totalPausedTime += SDL_GetTicks() - pauseStartTime;
             pauseStartTime = 0;
@@ -962,4 +1593,265 @@ void Game::setSensitivity(int sens) {
 
 bool Game::isDraggingVolumeSlider() const {
     return isDraggingVolume;
-}
\ No newline at end of file
+}
+namespace {
+
+uint32_t snapshotLayoutTag() {
+    uint32_t tag = 2166136261u;
+    const size_t sizes[] = { sizeof(Target), sizeof(SpaceShark), sizeof(SharkBullet), sizeof(AllyShip),
+                             sizeof(HealItem), sizeof(Life), sizeof(std::mt19937), sizeof(TimerEvent), sizeof(EntityHandle) };
+    for (size_t size : sizes) tag = (tag ^ static_cast<uint32_t>(size)) * 16777619u;
+    return tag;
+}
+
+}
+
+void Game::captureState(SnapshotWriter& writer) const {
+    writer.put(elapsedTime);
+    writer.put(clockRemainderMs);
+    writer.put(clockRemainderUs);
+    writer.put(showWarning);
+    writer.put(warningStartTime);
+    writer.put(score);
+    writer.put(missileCount);
+    writer.put(waveCount);
+    writer.put(missilesBlocked);
+    writer.put(runSeed);
+    writer.put(warningX);
+    writer.put(warningY);
+    writer.put(arcStartAngle);
+    writer.put(fixedPoint);
+    writer.put(shieldBearing);
+    writer.put(rng);
+    writer.put(timers.nextSequence());
+    timers.collect(timerScratch);
+    writer.putVector(timerScratch);
+    writer.put(timeline.position());
+    writer.putVector(lives);
+    targets.save(writer);
+    fastMissiles.save(writer);
+    spaceSharks.save(writer);
+    sharkBullets.save(writer);
+    allies.save(writer);
+    healItems.save(writer);
+}
+
+bool Game::restoreState(SnapshotReader& reader) {
+    Uint32 restoredTime = 0;
+    int previousScore = score;
+    reader.get(restoredTime);
+    reader.get(clockRemainderMs);
+    reader.get(clockRemainderUs);
+    reader.get(showWarning);
+    reader.get(warningStartTime);
+    reader.get(score);
+    reader.get(missileCount);
+    reader.get(waveCount);
+    reader.get(missilesBlocked);
+    reader.get(runSeed);
+    reader.get(warningX);
+    reader.get(warningY);
+    reader.get(arcStartAngle);
+    reader.get(fixedPoint);
+    reader.get(shieldBearing);
+    uint32_t timerSequence = 0, timelinePosition = 0;
+    reader.get(rng);
+    reader.get(timerSequence);
+    reader.getVector(timerScratch, SNAPSHOT_MAX_ENTITIES);
+    reader.get(timelinePosition);
+    reader.getVector(lives, PLAYER_LIVES);
+    bool poolsOk = targets.load(reader, SNAPSHOT_MAX_ENTITIES) && fastMissiles.load(reader, SNAPSHOT_MAX_ENTITIES) &&
+                   spaceSharks.load(reader, SNAPSHOT_MAX_ENTITIES) && sharkBullets.load(reader, SNAPSHOT_MAX_ENTITIES) &&
+                   allies.load(reader, SNAPSHOT_MAX_ENTITIES) && healItems.load(reader, SNAPSHOT_MAX_ENTITIES);
+    if (!poolsOk || !reader.ok() || !reader.atEnd() || lives.size() != PLAYER_LIVES) return false;
+    if (!timeline.seek(waveScript, runSeed, timelinePosition)) return false;
+
+    elapsedTime = restoredTime;
+    lastSnapshotTime = restoredTime;
+    timers.restore(restoredTime, timerSequence, timerScratch);
+    rebuildGrid();
+    gameOver = false;
+    paused = false;
+    startTime = SDL_GetTicks() - restoredTime;
+    if (startTime == 0) startTime = 1;
+    totalPausedTime = 0;
+    pauseStartTime = 0;
+    isDraggingVolume = false;
+    if (score != previousScore) updateScoreLabel();
+    return true;
+}
+
+namespace {
+
+// FNV-1a over values fed in as little-endian 32-bit words, so the result
+// does not depend on the machine's byte order or struct padding.
+struct StateHash {
+    uint32_t value = 2166136261u;
+
+    void add(uint32_t v) {
+        for (int i = 0; i < 4; ++i) value = (value ^ ((v >> (8 * i)) & 0xffu)) * 16777619u;
+    }
+    void add(float v) {
+        uint32_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        add(bits);
+    }
+};
+
+}
+
+// Fixed-point runs hash only integer state, which is what the mode keeps
+// the same across builds; the floats there are copies for drawing.
+uint32_t Game::stateChecksum() const {
+    StateHash h;
+    for (uint32_t v : {elapsedTime, runSeed, static_cast<uint32_t>(score), static_cast<uint32_t>(missileCount),
+                       static_cast<uint32_t>(waveCount), static_cast<uint32_t>(missilesBlocked), static_cast<uint32_t>(gameOver),
+                       static_cast<uint32_t>(showWarning), warningStartTime, static_cast<uint32_t>(warningX),
+                       static_cast<uint32_t>(warningY), timers.nextSequence(), timeline.position()}) {
+        h.add(v);
+    }
+    for (const Life& life : lives) h.add(static_cast<uint32_t>(life.isRed));
+    timers.collect(timerScratch);
+    for (const TimerEvent& e : timerScratch) {
+        h.add(e.due); h.add(e.sequence); h.add(e.kind); h.add(e.target);
+    }
+    for (const EntityPool<Target>* missiles : {&targets, &fastMissiles}) {
+        for (const Target& t : *missiles) {
+            h.add(t.spawnTime); h.add(t.bandTime); h.add(t.bandExitTime); h.add(t.hitTime);
+            h.add(static_cast<uint32_t>(t.reachedBand));
+            if (fixedPoint) h.add(t.bearing);
+            else { h.add(t.originX); h.add(t.originY); h.add(t.dx); h.add(t.dy); }
+        }
+    }
+
+    if (fixedPoint) {
+        h.add(clockRemainderUs);
+        h.add(shieldBearing);
+        for (const SpaceShark& ss : spaceSharks) {
+            h.add(ss.spawnTime); h.add(ss.startBearing); h.add(static_cast<uint32_t>(ss.turnRate));
+            h.add(static_cast<uint32_t>(ss.fixedX)); h.add(static_cast<uint32_t>(ss.fixedY));
+        }
+        for (const SharkBullet& sb : sharkBullets) {
+            for (Fixed v : {sb.fixedX, sb.fixedY, sb.fixedDx, sb.fixedDy}) h.add(static_cast<uint32_t>(v));
+        }
+        for (const AllyShip& ally : allies) {
+            h.add(static_cast<uint32_t>(ally.fixedX));
+            h.add(static_cast<uint32_t>(ally.heal.isNull()));
+        }
+        for (const HealItem& heal : healItems) {
+            h.add(static_cast<uint32_t>(heal.fixedX));
+            h.add(static_cast<uint32_t>(heal.fixedY));
+        }
+        return h.value;
+    }
+
+    h.add(clockRemainderMs);
+    h.add(arcStartAngle);
+    for (const SpaceShark& ss : spaceSharks) {
+        h.add(ss.spawnTime); h.add(ss.startAngle); h.add(ss.angularSpeed); h.add(ss.dirX); h.add(ss.dirY); h.add(ss.x); h.add(ss.y);
+    }
+    for (const SharkBullet& sb : sharkBullets) {
+        h.add(sb.x); h.add(sb.y); h.add(sb.dx); h.add(sb.dy);
+    }
+    for (const AllyShip& ally : allies) {
+        h.add(ally.x);
+        h.add(static_cast<uint32_t>(ally.heal.isNull()));
+    }
+    for (const HealItem& heal : healItems) {
+        h.add(heal.x);
+        h.add(heal.y);
+    }
+    return h.value;
+}
+
+bool Game::captureSnapshot(std::string& out) const {
+    if (startTime == 0 || gameOver) return false;
+
+    SnapshotWriter writer(out);
+    writer.put(GAME_SNAPSHOT_MAGIC);
+    writer.put(GAME_SNAPSHOT_VERSION);
+    writer.put(static_cast<uint16_t>(GAME_SNAPSHOT_HEADER_SIZE));
+    writer.put(snapshotLayoutTag());
+    writer.put(static_cast<uint32_t>(0));
+    writer.put(static_cast<uint32_t>(0));
+    captureState(writer);
+
+    uint32_t payloadSize = static_cast<uint32_t>(writer.size() - GAME_SNAPSHOT_HEADER_SIZE);
+    uint32_t checksum = crc32(writer.data() + GAME_SNAPSHOT_HEADER_SIZE, payloadSize);
+    writer.patch(12, &payloadSize, sizeof(payloadSize));
+    writer.patch(16, &checksum, sizeof(checksum));
+    return true;
+}
+
+bool Game::restoreSnapshot(const char* data, size_t length) {
+    SnapshotReader header(data, length);
+    char magic[4];
+    uint16_t version = 0, headerSize = 0;
+    uint32_t layoutTag = 0, payloadSize = 0, checksum = 0;
+    header.get(magic); header.get(version); header.get(headerSize);
+    header.get(layoutTag); header.get(payloadSize); header.get(checksum);
+    if (!header.ok() || std::memcmp(magic, GAME_SNAPSHOT_MAGIC, sizeof(magic)) != 0) return false;
+    if (version != GAME_SNAPSHOT_VERSION || headerSize != GAME_SNAPSHOT_HEADER_SIZE || layoutTag != snapshotLayoutTag()) return false;
+    if (length - GAME_SNAPSHOT_HEADER_SIZE != payloadSize) return false;
+    if (crc32(data + GAME_SNAPSHOT_HEADER_SIZE, payloadSize) != checksum) return false;
+
+    SnapshotReader reader(data + GAME_SNAPSHOT_HEADER_SIZE, payloadSize);
+    if (!restoreState(reader)) return false;
+    updateScoreLabel();
+    updateHighscoreLabel();
+    return true;
+}
+
+void Game::saveSnapshot() {
+    if (practiceMode || !menu || !captureSnapshot(snapshotBuffer)) return;
+    menu->persistence.exchange(snapshotPath, snapshotBuffer);
+}
+
+void Game::discardSnapshot() {
+    if (menu) menu->persistence.remove(snapshotPath);
+}
+
+bool Game::resumeFromSnapshotFile() {
+    std::ifstream file(snapshotPath, std::ios::binary);
+    if (!file.is_open()) return false;
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    file.close();
+
+    reset();
+    setPracticeMode(false);
+    if (!restoreSnapshot(bytes.data(), bytes.size())) {
+        std::cerr << "Saved run in " << snapshotPath << " is unreadable, discarding it." << std::endl;
+        reset();
+        discardSnapshot();
+        return false;
+    }
+    std::cout << "Resuming saved run from " << snapshotPath << std::endl;
+    // reset() queued the file's removal; put it back in case we stop
+    // before the next autosave.
+    saveSnapshot();
+
+    if (bgmGame) Mix_PlayMusic(bgmGame, -1);
+    setGameStatePaused();
+    return true;
+}
+
+void Game::setWaveScript(const WaveScript& script) {
+    waveScript = script;
+}
+
+void Game::setPracticeMode(bool enabled) {
+    practiceMode = enabled;
+    rewindBuffer.clear();
+}
+
+void Game::recordRewindFrame() {
+    SnapshotWriter writer(rewindScratch);
+    captureState(writer);
+    rewindBuffer.push(rewindScratch);
+}
+
+bool Game::rewindOneFrame() {
+    if (!rewindBuffer.pop(rewindScratch)) return false;
+    SnapshotReader reader(rewindScratch.data(), rewindScratch.size());
+    return restoreState(reader);
+}
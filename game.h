@@ -6,23 +6,59 @@
 #include <SDL2/SDL_mixer.h>
 #include <vector>
 #include <string> 
+#include <random>
 #include "enemy.h"
 #include "mainmenu.h"
 #include "life.h"
+#include "rewind.h"
+#include "latency.h"
+#include "timerwheel.h"
+#include "wavescript.h"
+#include "numberlabel.h"
+#include "entitypool.h"
+#include "polargrid.h"
+#include "spritemask.h"
+#include "jobsystem.h"
+
+class SnapshotWriter;
+class SnapshotReader;
 
 SDL_Texture* loadTexture(SDL_Renderer* renderer, const std::string& path);
 
 struct AllyShip {
     float x, y;         
     float speed;        
-    bool active;        
-    bool droppingHeal;  
+    EntityHandle heal;  
+    Fixed fixedX;
 };
 
 struct HealItem {
     float x, y;      
     float speed;      
-    bool active;     
+    Fixed fixedX, fixedY;
+};
+
+enum class GameTimer : uint32_t {
+    AllySpawn,
+    WarningEnd,
+    SharkFire,
+    SharkExpire,
+    MissileCheck,
+    FastMissileCheck
+};
+
+enum class Contact : Uint8 { None, Ship, Shield };
+
+enum class GridKind : int {
+    Shark,
+    SharkBullet,
+    Count
+};
+
+struct ShieldKeyEvent {
+    Uint32 timestamp;
+    SDL_Scancode key;
+    bool down;
 };
 
 class Game {
@@ -33,8 +69,6 @@ private:
 
     SDL_Texture* mspaceshipTexture;
     SDL_Texture* pauseButtonTexture;
-    SDL_Texture* scoreTexture;
-    SDL_Texture* highscoreTexture;
     SDL_Texture* pausedTexture;
     SDL_Texture* backToMenuTexture;
     SDL_Texture* restartTexture;
@@ -44,6 +78,8 @@ private:
     SDL_Texture* backgroundTexture; 
     SDL_Texture* allyShipTexture;  
     SDL_Texture* healItemTexture;  
+    NumberLabel scoreLabel;
+    NumberLabel highscoreLabel;
 
     Mix_Chunk* sfxShieldHit;
     Mix_Chunk* sfxPlayerHit;
@@ -55,24 +91,49 @@ private:
     bool gameOver;
     bool paused;
     bool showWarning;
-    bool justStarted;
 
     Uint32 startTime;
     Uint32 pauseStartTime;
     Uint32 totalPausedTime;
     Uint32 warningStartTime;
-    Uint32 nextSpawnTime;
-    Uint32 lastMissileSpawnTime;
-    Uint32 lastAllySpawnTime;       
 
     int score;
     int missileCount;
     int waveCount;
-    int wavesUntilIncrease;
-    int spawnedMissilesInWave;
+    int missilesBlocked;
+    Uint32 elapsedTime;
+    float clockRemainderMs;
+    Uint32 clockRemainderUs;
+
+    std::mt19937 rng;
+    Uint32 runSeed;
+
+    TimerWheel timers;
+    std::vector<TimerEvent> firedTimers;
+    mutable std::vector<TimerEvent> timerScratch;
+
+    WaveScript waveScript;
+    WaveTimeline timeline;
+
+    std::string snapshotBuffer;
+    std::string snapshotPath;
+    Uint32 lastSnapshotTime;
+
+    bool practiceMode;
+    bool invulnerable;
+    RewindBuffer rewindBuffer;
+    std::string rewindScratch;
+    SDL_Texture* practiceTexture;
 
     int warningX, warningY;
     float arcStartAngle;
+    bool fixedPoint;
+    BinaryAngle shieldBearing;
+
+    std::vector<ShieldKeyEvent> shieldKeyEvents;
+    bool shieldLeftHeld;
+    bool shieldRightHeld;
+    LatencyTracker latency;
 
     int volume;
     int sensitivity;
@@ -90,33 +151,81 @@ private:
     Circle trajectory;
 
     std::vector<Life> lives;
-    std::vector<Target> targets;
-    std::vector<Target> fastMissiles;
-    std::vector<SpaceShark> spaceSharks;
-    std::vector<SharkBullet> sharkBullets;
-    std::vector<AllyShip> allies;      
-    std::vector<HealItem> healItems; 
+    EntityPool<Target> targets;
+    EntityPool<Target> fastMissiles;
+    EntityPool<SpaceShark> spaceSharks;
+    EntityPool<SharkBullet> sharkBullets;
+    EntityPool<AllyShip> allies;      
+    EntityPool<HealItem> healItems; 
+    PolarGrid grid;
+    std::vector<PolarGridHit> gridHits;
+    std::vector<Contact> contactOutcomes;
+
+    JobSystem* jobs;
+    std::vector<int32_t> entityCells;
+    std::vector<Uint8> entityGone;
+
+    bool preciseHull;
+    SpriteMask shipMask;
+    RotatedSpriteMask missileMask;
+    RotatedSpriteMask fastMissileMask;
+    RotatedSpriteMask sharkMask;
+    RotatedSpriteMask sharkBulletMask;
 
     void initTextures(); 
-    void updateScoreTexture();
-    void updateHighscoreTexture();
+    void updateScoreLabel();
+    void updateHighscoreLabel();
     void updatePausedTexture();
     void updateGameOverTextTexture();
     void updateVolumeLabelTexture();
     void DrawCircle(SDL_Renderer* renderer, const Circle& c);
     void DrawArc(SDL_Renderer* renderer, const Circle& c, double startAngle, double arcAngle);
 
-    bool CheckCollisionWithArc(const Target& t);
-    bool CheckCollisionWithChitbox(const Target& t);
-    bool CheckCollisionWithArc(const SpaceShark& ss);
-    bool CheckCollisionWithChitbox(const SpaceShark& ss);
-    bool CheckCollisionWithArc(const SharkBullet& sb);
-    bool CheckCollisionWithChitbox(const SharkBullet& sb);
+    bool shieldCoversAngle(float angle) const;
+    bool shieldCovers(BinaryAngle bearing) const;
+    bool touchesShieldFixed(Fixed x, Fixed y, Fixed reach) const;
+    bool CheckCollisionWithArc(const SpaceShark& ss) const;
+    bool CheckCollisionWithChitbox(const SpaceShark& ss) const;
     bool CheckCollisionWithChitbox(const HealItem& hi);
+    void stepEntities(Uint32 now, float deltaTime);
+    void stepEntitiesFixed(Uint32 now, Uint32 ms);
+    void resolveShieldContacts(float deltaTime, bool useGrid);
+    void collectWithin(float rMin, float rMax);
+    Contact testContact(const PolarGridHit& hit, bool shieldPass, float deltaTime) const;
+    void applyContacts(bool shieldPass, float deltaTime);
+    void applyContact(Contact contact, bool shark);
+    Contact testBulletFixed(Fixed fromX, Fixed fromY, const SharkBullet& sb) const;
+    void destroyShark(EntityHandle handle);
+    void destroySharkBullet(EntityHandle handle);
+    void rebuildGrid();
+
+    void captureState(SnapshotWriter& writer) const;
+    bool restoreState(SnapshotReader& reader);
 
     void HandleHit(); 
     void SpawnAlly(); 
-    void HandleHealCollection(HealItem& heal); 
+    void HandleHealCollection(); 
+    void queueSound(SoundType type, Mix_Chunk* chunk = nullptr);
+
+    void scheduleTimer(Uint32 due, GameTimer kind, EntityHandle target = NULL_ENTITY);
+    void runTimers(Uint32 now);
+    void onTimer(const TimerEvent& event);
+    void applySpawn(const SpawnEvent& spawn);
+    int randomInt(std::uniform_int_distribution<>& dist);
+    float missileSpeed();
+    Fixed missileSpeedFixed();
+    void spawnMissile(Uint32 now);
+    void launchMissile(EntityPool<Target>& missiles, GameTimer check, const RotatedSpriteMask& shape, float originX, float originY, float speed, float collisionRadius, Uint32 now);
+    void launchMissileFixed(EntityPool<Target>& missiles, GameTimer check, int originX, int originY, Fixed speed, Fixed collisionRadius, Uint32 now);
+    bool maskContact(float x0, float y0, float x1, float y1, const SpriteMask& mask, float& t) const;
+    void checkMissile(EntityPool<Target>& missiles, GameTimer check, EntityHandle handle, int points);
+    void spawnShark(Uint32 now);
+    void startWarning(Uint32 now);
+
+    void recordShieldKey(SDL_Scancode key, bool down, Uint32 timestamp);
+    void applyShieldKey(SDL_Scancode key, bool down);
+    void syncShieldKeys();
+    float consumeShieldInput(float tickMs);
 
 
 public:
@@ -133,8 +242,64 @@ public:
     void render();
     void reset();
     void startGame();
+    // Same run every time for the same seed and wave script.
+    void startGame(Uint32 seed);
+
+    bool captureSnapshot(std::string& out) const;
+    bool restoreSnapshot(const char* data, size_t length);
+    void saveSnapshot();
+    void discardSnapshot();
+    bool resumeFromSnapshotFile();
+
+    // Where autosaves go and what resuming reads; SNAPSHOT_FILE by default.
+    void setSnapshotPath(const std::string& path) { snapshotPath = path; }
+    void setPracticeMode(bool enabled);
+    bool isPracticeMode() const { return practiceMode; }
+    // Hits still remove the enemy but cost no life; for benchmarks.
+    void setInvulnerable(bool enabled) { invulnerable = enabled; }
+    // Hull hits test the sprites' alpha masks instead of the hitbox; falls
+    // back to the hitbox if the masks cannot be loaded.
+    void setPreciseHull(bool enabled);
+    bool isPreciseHull() const { return preciseHull; }
+    // Simulates in integer arithmetic (fixedpoint.h), so the same seed and
+    // inputs end in the same bits on any compiler and CPU. Set it between
+    // runs. Runs on the calling thread and hits the hitbox whatever
+    // setJobSystem and setPreciseHull say.
+    void setFixedPoint(bool enabled) { fixedPoint = enabled; }
+    bool isFixedPoint() const { return fixedPoint; }
+    // Hash of the simulated state. Fixed-point runs can compare it across
+    // builds and machines; otherwise only within one build.
+    uint32_t stateChecksum() const;
+    // Entity phases split across these workers when there are enough
+    // entities; null keeps everything on the calling thread.
+    void setJobSystem(JobSystem* system) { jobs = system; }
+    // Replaces the curve read from WAVE_SCRIPT_FILE from the next startGame on.
+    void setWaveScript(const WaveScript& script);
+    // Holds the shield turning: -1 as if A were down, 1 for D, 0 for neither.
+    // For players that are not a keyboard.
+    void setShieldTurn(int direction);
+    // Radians per second the shield turns while a key is held.
+    float getShieldTurnRate() const;
+    float getShieldAngle() const { return arcStartAngle; }
+    const EntityPool<Target>& getMissiles() const { return targets; }
+    const EntityPool<Target>& getFastMissiles() const { return fastMissiles; }
+    const EntityPool<SpaceShark>& getSpaceSharks() const { return spaceSharks; }
+    const EntityPool<SharkBullet>& getSharkBullets() const { return sharkBullets; }
+    // Spawns count sharks at once, for load tests.
+    void addStressSharks(size_t count);
+    void recordRewindFrame();
+    bool rewindOneFrame();
+    size_t rewindFrameCount() const { return rewindBuffer.frameCount(); }
+    size_t rewindBytesUsed() const { return rewindBuffer.bytesUsed(); }
+
+    LatencyTracker& latencyTracker() { return latency; }
 
     bool isGameOver() const { return gameOver; }
+    Uint32 getElapsedTime() const { return elapsedTime; }
+    int getScore() const { return score; }
+    int getWaveCount() const { return waveCount; }
+    int getMissilesBlocked() const { return missilesBlocked; }
+    int getLivesLeft() const;
     bool isPaused() const { return paused; }
     int getVolume() const { return volume; }
     void setVolume(int vol);
@@ -145,6 +310,7 @@ public:
     void setGameStatePlaying();
     void setGameStatePaused();
     void triggerGameOver();
+    void restartMusic();
 
 };
 
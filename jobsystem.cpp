@@ -0,0 +1,126 @@
+#include "jobsystem.h"
+#include "config.h"
+#include <algorithm>
+
+namespace {
+
+thread_local bool insideJob = false;
+
+}
+
+bool JobSystem::JobQueue::push(const Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (tail - head == ring.size()) return false;
+    ring[tail % ring.size()] = job;
+    ++tail;
+    return true;
+}
+
+bool JobSystem::JobQueue::popBack(Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (head == tail) return false;
+    --tail;
+    job = ring[tail % ring.size()];
+    return true;
+}
+
+bool JobSystem::JobQueue::popFront(Job& job) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (head == tail) return false;
+    job = ring[head % ring.size()];
+    ++head;
+    return true;
+}
+
+JobSystem::JobSystem(unsigned workers) : queuedJobs(0), stopping(false) {
+    if (workers == 0) {
+        unsigned cores = std::thread::hardware_concurrency();
+        workers = cores > 1 ? cores - 1 : 0;
+    }
+    // Queue 0 belongs to whichever thread calls parallelFor.
+    for (unsigned i = 0; i <= workers; ++i) {
+        queues.push_back(std::make_unique<JobQueue>());
+        queues.back()->ring.resize(JOB_QUEUE_CAPACITY);
+    }
+    for (unsigned i = 1; i <= workers; ++i) threads.emplace_back(&JobSystem::workerLoop, this, i);
+}
+
+JobSystem::~JobSystem() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (auto& thread : threads) thread.join();
+}
+
+void JobSystem::execute(const Job& job) {
+    bool wasInside = insideJob;
+    insideJob = true;
+    job.run(job.context, job.begin, job.end);
+    insideJob = wasInside;
+    job.remaining->fetch_sub(1, std::memory_order_acq_rel);
+}
+
+bool JobSystem::take(size_t self, Job& job) {
+    if (queues[self]->popBack(job)) {
+        queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+    for (size_t i = 1; i < queues.size(); ++i) {
+        if (queues[(self + i) % queues.size()]->popFront(job)) {
+            queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+// Chunks are dealt round-robin so every thread starts on its own deque and
+// only steals once that runs dry.
+void JobSystem::dispatch(size_t count, size_t grain, RunRange run, void* context) {
+    if (count == 0) return;
+    grain = std::max<size_t>(grain, 1);
+    std::unique_lock<std::mutex> dispatching(dispatchMutex, std::defer_lock);
+    if (threads.empty() || count < 2 * grain || insideJob || !dispatching.try_lock()) {
+        run(context, 0, count);
+        return;
+    }
+
+    size_t chunks = std::min((count + grain - 1) / grain, queues.size() * JOB_CHUNKS_PER_THREAD);
+    size_t perChunk = (count + chunks - 1) / chunks;
+    std::atomic<size_t> remaining(0);
+    for (size_t begin = 0, i = 0; begin < count; begin += perChunk, ++i) {
+        Job job = {run, context, begin, std::min(count, begin + perChunk), &remaining};
+        remaining.fetch_add(1, std::memory_order_relaxed);
+        if (queues[i % queues.size()]->push(job)) {
+            queuedJobs.fetch_add(1, std::memory_order_relaxed);
+        } else {
+            execute(job);
+        }
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wake.notify_all();
+
+    Job job;
+    while (remaining.load(std::memory_order_acquire) != 0) {
+        if (take(0, job)) execute(job);
+        else std::this_thread::yield();
+    }
+}
+
+void JobSystem::workerLoop(size_t self) {
+    insideJob = true;
+    Job job;
+    while (true) {
+        if (take(self, job)) {
+            execute(job);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wake.wait(lock, [this] { return stopping || queuedJobs.load(std::memory_order_relaxed) != 0; });
+        if (stopping) break;
+    }
+}
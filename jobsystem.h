@@ -0,0 +1,76 @@
+#ifndef JOBSYSTEM_H
+#define JOBSYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Fork-join pool for the data-parallel parts of a tick. The calling thread
+// and each worker own a deque of range jobs: the owner takes from the back,
+// idle threads steal from the front of the others. parallelFor returns once
+// every chunk has run, so afterwards memory looks as it would after a plain
+// loop; a chunk may only write to its own elements. Ranges under two grains,
+// calls made from inside a job and calls while another thread is already
+// dispatching all run inline on the caller. Nothing allocates after
+// construction.
+class JobSystem {
+public:
+    // 0 starts one worker per core besides the calling thread.
+    explicit JobSystem(unsigned workers = 0);
+    ~JobSystem();
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    unsigned workerCount() const { return static_cast<unsigned>(threads.size()); }
+
+    // Calls body(begin, end) over disjoint ranges covering [0, count).
+    template <typename Body>
+    void parallelFor(size_t count, size_t grain, Body&& body) {
+        using BodyType = typename std::remove_reference<Body>::type;
+        dispatch(count, grain, [](void* context, size_t begin, size_t end) {
+            (*static_cast<BodyType*>(context))(begin, end);
+        }, &body);
+    }
+
+private:
+    using RunRange = void (*)(void*, size_t, size_t);
+
+    struct Job {
+        RunRange run;
+        void* context;
+        size_t begin, end;
+        std::atomic<size_t>* remaining;
+    };
+
+    // Fixed ring of JOB_QUEUE_CAPACITY jobs; [head, tail) are queued.
+    struct JobQueue {
+        std::mutex mutex;
+        std::vector<Job> ring;
+        size_t head = 0, tail = 0;
+
+        bool push(const Job& job);
+        bool popBack(Job& job);
+        bool popFront(Job& job);
+    };
+
+    void dispatch(size_t count, size_t grain, RunRange run, void* context);
+    bool take(size_t self, Job& job);
+    void execute(const Job& job);
+    void workerLoop(size_t self);
+
+    std::vector<std::unique_ptr<JobQueue>> queues;
+    std::vector<std::thread> threads;
+    std::mutex dispatchMutex;
+    std::mutex sleepMutex;
+    std::condition_variable wake;
+    std::atomic<size_t> queuedJobs;
+    bool stopping;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "latency.h"
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+
+namespace {
+
+double ticksToMs(Uint64 ticks) {
+    return static_cast<double>(ticks) * 1000.0 / static_cast<double>(SDL_GetPerformanceFrequency());
+}
+
+}
+
+LatencyHistogram::LatencyHistogram() : buckets(), samples(0), total(0.0), worst(0.0) {}
+
+void LatencyHistogram::add(double ms) {
+    int bucket = static_cast<int>(std::max(0.0, ms) / LATENCY_BUCKET_MS);
+    buckets[std::min(bucket, LATENCY_BUCKETS)]++;
+    samples++;
+    total += ms;
+    worst = std::max(worst, ms);
+}
+
+void LatencyHistogram::clear() {
+    std::fill(buckets, buckets + LATENCY_BUCKETS + 1, 0);
+    samples = 0;
+    total = 0.0;
+    worst = 0.0;
+}
+
+// Upper edge of the bucket holding the p-th percentile sample.
+double LatencyHistogram::percentile(double p) const {
+    if (samples == 0) return 0.0;
+    int target = std::max(1, static_cast<int>(std::ceil(p / 100.0 * samples)));
+    int seen = 0;
+    for (int i = 0; i < LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= target) return (i + 1) * LATENCY_BUCKET_MS;
+    }
+    return worst;
+}
+
+void LatencyHistogram::print(std::ostream& out, const char* title) const {
+    out << std::fixed << std::setprecision(1);
+    out << title << ": " << samples << " samples";
+    if (samples == 0) {
+        out << std::endl;
+        return;
+    }
+    out << ", mean " << mean() << " ms, p50 " << percentile(50) << ", p95 " << percentile(95)
+        << ", p99 " << percentile(99) << ", max " << worst << std::endl;
+
+    int first = LATENCY_BUCKETS, last = 0, peak = 1;
+    for (int i = 0; i <= LATENCY_BUCKETS; ++i) {
+        if (!buckets[i]) continue;
+        first = std::min(first, i);
+        last = std::max(last, i);
+        peak = std::max(peak, buckets[i]);
+    }
+    for (int i = first; i <= last; ++i) {
+        if (i == LATENCY_BUCKETS) out << "  >" << std::setw(5) << LATENCY_BUCKETS * LATENCY_BUCKET_MS << " ms ";
+        else out << "  " << std::setw(6) << i * LATENCY_BUCKET_MS << " ms ";
+        out << std::setw(6) << buckets[i] << " " << std::string(buckets[i] * 40 / peak, '#') << std::endl;
+    }
+}
+
+LatencyTracker::LatencyTracker()
+    : enabled(false), readback(false), arcFound(false), arcMidAngle(0.0f) {
+    tags.reserve(SHIELD_KEY_QUEUE_CAPACITY);
+}
+
+void LatencyTracker::setEnabled(bool on) {
+    enabled = on;
+    tags.clear();
+}
+
+void LatencyTracker::markInput(Uint32 eventTimestamp) {
+    if (!enabled || tags.size() >= SHIELD_KEY_QUEUE_CAPACITY) return;
+    Uint32 now = SDL_GetTicks();
+    queueDelay.add(eventTimestamp < now ? static_cast<double>(now - eventTimestamp) : 0.0);
+    tags.push_back(Tag{SDL_GetPerformanceCounter(), 0, false});
+}
+
+void LatencyTracker::markUpdate() {
+    if (!enabled) return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    for (Tag& t : tags) {
+        if (t.applied) continue;
+        t.applied = true;
+        t.appliedAt = now;
+        toUpdate.add(ticksToMs(now - t.handledAt));
+    }
+}
+
+void LatencyTracker::markPresented() {
+    if (!enabled || tags.empty()) return;
+    Uint64 now = SDL_GetPerformanceCounter();
+    size_t kept = 0;
+    for (const Tag& t : tags) {
+        if (!t.applied) {
+            tags[kept++] = t;
+            continue;
+        }
+        updateToPresent.add(ticksToMs(now - t.appliedAt));
+        toPresent.add(ticksToMs(now - t.handledAt));
+    }
+    tags.resize(kept);
+}
+
+// Takes the circular mean of the shield-coloured pixels lying on the
+// trajectory ring; moving the arc moves the mean by the same angle.
+void LatencyTracker::readArc(SDL_Renderer* renderer) {
+    const int margin = 3;
+    const int half = TRAJECTORY_RADIUS + margin;
+    SDL_Rect area = {TRAJECTORY_CENTER.x - half, TRAJECTORY_CENTER.y - half, half * 2, half * 2};
+    pixels.resize(static_cast<size_t>(area.w) * area.h);
+    arcFound = false;
+    if (SDL_RenderReadPixels(renderer, &area, SDL_PIXELFORMAT_ARGB8888, pixels.data(), area.w * 4) != 0) return;
+
+    double sumX = 0.0, sumY = 0.0;
+    int hits = 0;
+    for (int y = 0; y < area.h; ++y) {
+        for (int x = 0; x < area.w; ++x) {
+            Uint32 p = pixels[static_cast<size_t>(y) * area.w + x];
+            int r = (p >> 16) & 0xFF, g = (p >> 8) & 0xFF, b = p & 0xFF;
+            if (std::abs(r - SHIELD_ARC_COLOR.r) > 40 || std::abs(g - SHIELD_ARC_COLOR.g) > 40 || std::abs(b - SHIELD_ARC_COLOR.b) > 40) continue;
+            double dx = x - half + 0.5, dy = y - half + 0.5;
+            double dist = std::sqrt(dx * dx + dy * dy);
+            if (std::fabs(dist - TRAJECTORY_RADIUS) > margin) continue;
+            sumX += dx / dist;
+            sumY += dy / dist;
+            hits++;
+        }
+    }
+    if (hits == 0) return;
+    arcFound = true;
+    arcMidAngle = static_cast<float>(std::atan2(sumY, sumX));
+}
+
+void LatencyTracker::report(std::ostream& out) const {
+    out << "Shield input latency" << std::endl;
+    queueDelay.print(out, "  event queued -> handled");
+    toUpdate.print(out, "  handled -> applied in update");
+    updateToPresent.print(out, "  update -> present");
+    toPresent.print(out, "  handled -> present");
+}
+
+void LatencyTracker::clear() {
+    tags.clear();
+    queueDelay.clear();
+    toUpdate.clear();
+    updateToPresent.clear();
+    toPresent.clear();
+}
@@ -0,0 +1,76 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <SDL2/SDL.h>
+#include <ostream>
+#include <vector>
+#include "config.h"
+
+// Fixed-width millisecond buckets plus one overflow bucket.
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void add(double ms);
+    void clear();
+
+    int count() const { return samples; }
+    double mean() const { return samples ? total / samples : 0.0; }
+    double max() const { return worst; }
+    double percentile(double p) const;
+    void print(std::ostream& out, const char* title) const;
+
+private:
+    int buckets[LATENCY_BUCKETS + 1];
+    int samples;
+    double total;
+    double worst;
+};
+
+// Follows shield key events from Game::handleInput through the update that
+// applies them to the SDL_RenderPresent of the frame that shows the result.
+// Each presented frame adds one sample per input it carried.
+class LatencyTracker {
+public:
+    LatencyTracker();
+
+    void setEnabled(bool on);
+    bool isEnabled() const { return enabled; }
+
+    void markInput(Uint32 eventTimestamp);
+    void markUpdate();
+    void markPresented();
+
+    // Automated mode: before each present, read back the pixels around the
+    // trajectory and estimate where the shield arc is drawn.
+    void setReadback(bool on) { readback = on; }
+    bool wantsReadback() const { return readback; }
+    void readArc(SDL_Renderer* renderer);
+    bool arcVisible() const { return arcFound; }
+    float arcAngle() const { return arcMidAngle; }
+
+    const LatencyHistogram& inputToPresent() const { return toPresent; }
+    void report(std::ostream& out) const;
+    void clear();
+
+private:
+    struct Tag {
+        Uint64 handledAt;
+        Uint64 appliedAt;
+        bool applied;
+    };
+
+    bool enabled;
+    bool readback;
+    std::vector<Tag> tags;
+    std::vector<Uint32> pixels;
+    bool arcFound;
+    float arcMidAngle;
+
+    LatencyHistogram queueDelay;
+    LatencyHistogram toUpdate;
+    LatencyHistogram updateToPresent;
+    LatencyHistogram toPresent;
+};
+
+#endif
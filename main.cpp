@@ -11,6 +11,12 @@
 #include "game.h"
 #include "mainmenu.h"
 #include "enemy.h"
+#include "bench.h"
+#include "audio.h"
+#include "alloccount.h"
+#include "jobsystem.h"
+#include "simulate.h"
+#include "autopilot.h"
 
 Mix_Chunk* loadSoundEffect(const std::string& path) {
     Mix_Chunk* chunk = Mix_LoadWAV(path.c_str());
@@ -29,6 +35,28 @@ Mix_Music* loadMusic(const std::string& path) {
 }
 
 int main(int argc, char* argv[]) {
+    std::string benchName;
+    bool trackLatency = false;
+    bool preciseHull = false;
+    bool simulate = false;
+    bool autopilot = false;
+    bool fixedPoint = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--bench" && i + 1 < argc) benchName = argv[++i];
+        else if (arg == "--latency") trackLatency = true;
+        else if (arg == "--precise-hull") preciseHull = true;
+        else if (arg == "--simulate") simulate = true;
+        else if (arg == "--autopilot") autopilot = true;
+        else if (arg == "--fixed-point") fixedPoint = true;
+    }
+    // Headless: no window, audio or files, so none of the setup below.
+    if (simulate) return runSimulation(argc, argv);
+    // The latency probes run against the dummy drivers unless a device is named explicitly.
+    if (benchName == "audio") SDL_setenv("SDL_AUDIODRIVER", "dummy", 0);
+    if (benchName == "latency") SDL_setenv("SDL_VIDEODRIVER", "offscreen", 0);
+
+    installSdlAllocationHook();
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) < 0) {
         std::cerr << "SDL_Init Error: " << SDL_GetError() << std::endl;
         return 1;
@@ -47,7 +75,8 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    if (Mix_OpenAudio(AUDIO_FREQUENCY, MIX_DEFAULT_FORMAT, AUDIO_CHANNELS, AUDIO_CHUNK_SIZE) < 0) {
+    AudioDevice audio;
+    if (!audio.open(AudioLatencyMode::Standard)) {
         std::cerr << "Mix_OpenAudio Error: " << Mix_GetError() << std::endl;
         IMG_Quit();
         TTF_Quit();
@@ -55,26 +84,25 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    Mix_AllocateChannels(8);
-
-    SDL_Window* window = SDL_CreateWindow(WINDOW_TITLE.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, 0);
+    SDL_Window* window = SDL_CreateWindow(WINDOW_TITLE.c_str(), SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED, SCREEN_WIDTH, SCREEN_HEIGHT, benchName.empty() ? 0 : SDL_WINDOW_HIDDEN);
     if (!window) {
         std::cerr << "SDL_CreateWindow Error: " << SDL_GetError() << std::endl;
-        Mix_CloseAudio(); IMG_Quit(); TTF_Quit(); SDL_Quit();
+        audio.close(); IMG_Quit(); TTF_Quit(); SDL_Quit();
         return 1;
     }
 
-    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    Uint32 rendererFlags = benchName == "latency" ? SDL_RENDERER_SOFTWARE : (SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    SDL_Renderer* renderer = SDL_CreateRenderer(window, -1, rendererFlags);
     if (!renderer) {
         std::cerr << "SDL_CreateRenderer Error: " << SDL_GetError() << std::endl;
-        SDL_DestroyWindow(window); Mix_CloseAudio(); IMG_Quit(); TTF_Quit(); SDL_Quit();
+        SDL_DestroyWindow(window); audio.close(); IMG_Quit(); TTF_Quit(); SDL_Quit();
         return 1;
     }
 
     TTF_Font* mainFont = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_LARGE);
     if (!mainFont) {
         std::cerr << "TTF_OpenFont failed for main font: " << FONT_PATH << " - " << TTF_GetError() << std::endl;
-        SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); Mix_CloseAudio(); IMG_Quit(); TTF_Quit(); SDL_Quit();
+        SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); audio.close(); IMG_Quit(); TTF_Quit(); SDL_Quit();
         return 1;
     }
     std::cout << "Successfully loaded main font: " << FONT_PATH << std::endl;
@@ -82,7 +110,7 @@ int main(int argc, char* argv[]) {
     SDL_Texture* missileTexture = loadTexture(renderer, IMG_MISSILE);
     if (!missileTexture) {
         std::cerr << "Error loading missile texture, exiting." << std::endl;
-        TTF_CloseFont(mainFont); SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); Mix_CloseAudio(); IMG_Quit(); TTF_Quit(); SDL_Quit();
+        TTF_CloseFont(mainFont); SDL_DestroyRenderer(renderer); SDL_DestroyWindow(window); audio.close(); IMG_Quit(); TTF_Quit(); SDL_Quit();
         return 1;
     }
 
@@ -100,17 +128,29 @@ int main(int argc, char* argv[]) {
     Mix_Music* bgmMenu = loadMusic(BGM_MENU);
     Mix_Music* bgmGame = loadMusic(BGM_GAME);
 
-    MainMenu menu(renderer, mainFont, sfxButtonClick, bgmMenu, mainMenuBgTexture);
+    MainMenu menu(renderer, mainFont, sfxButtonClick, bgmMenu, mainMenuBgTexture, &audio);
     Enemy enemy(renderer, missileTexture);
+    JobSystem jobs;
+    Autopilot pilot;
     Game game(renderer, &enemy, &menu, sfxShieldHit, sfxPlayerHit, sfxGameOver, sfxWarning, sfxHealCollect, bgmGame, gameBgTexture);
 
     menu.applySettingsToGame(game);
+    if (trackLatency) game.latencyTracker().setEnabled(true);
+    if (preciseHull) game.setPreciseHull(true);
+    if (fixedPoint) game.setFixedPoint(true);
+    game.setJobSystem(&jobs);
 
     bool running = true;
+    int exitCode = 0;
     SDL_Event event;
     Uint32 lastTime = SDL_GetTicks();
 
-    if (bgmMenu) {
+    if (!benchName.empty()) {
+        exitCode = runBenchmark(benchName, game, audio);
+        running = false;
+    } else if (game.resumeFromSnapshotFile()) {
+        menu.gameState = MainMenu::PAUSED;
+    } else if (bgmMenu) {
         Mix_PlayMusic(bgmMenu, -1);
     } else {
         std::cerr << "Warning: Menu BGM not loaded, cannot play." << std::endl;
@@ -120,6 +160,9 @@ int main(int argc, char* argv[]) {
         while (SDL_PollEvent(&event)) {
             if (event.type == SDL_QUIT) {
                 running = false;
+                if (menu.gameState == MainMenu::PLAYING || menu.gameState == MainMenu::PAUSED) {
+                    game.saveSnapshot();
+                }
             }
 
             switch (menu.gameState) {
@@ -140,16 +183,20 @@ int main(int argc, char* argv[]) {
             }
         }
 
+        menu.checkAudioDevice(game);
+
         Uint32 currentTime = SDL_GetTicks();
         float deltaTime = (currentTime > lastTime) ? (currentTime - lastTime) / 1000.0f : 0.0f;
         lastTime = currentTime;
 
         if (menu.gameState == MainMenu::PLAYING) {
+            if (autopilot) game.setShieldTurn(pilot.decide(game, deltaTime));
             game.update(deltaTime);
             if (game.isGameOver()) {
                 menu.gameState = MainMenu::GAME_OVER;
             }
         }
+        audio.endTick();
 
          switch (menu.gameState) {
             case MainMenu::MENU:
@@ -169,6 +216,11 @@ int main(int argc, char* argv[]) {
         }
     }
 
+    menu.runLog.close();
+    menu.persistence.flush();
+    if (trackLatency) game.latencyTracker().report(std::cout);
+    audio.close();
+
     Mix_FreeChunk(sfxShieldHit);
     Mix_FreeChunk(sfxPlayerHit);
     Mix_FreeChunk(sfxButtonClick);
@@ -185,10 +237,9 @@ int main(int argc, char* argv[]) {
     SDL_DestroyRenderer(renderer);
     SDL_DestroyWindow(window);
 
-    Mix_CloseAudio();
     IMG_Quit();
     TTF_Quit();
     SDL_Quit();
 
-    return 0;
+    return exitCode;
 }
\ No newline at end of file
@@ -1,30 +1,30 @@
 #include "mainmenu.h"
 #include "game.h"
 #include "config.h"
+#include "playerdata.h"
 #include <sstream>
 #include <iostream>
-#include <fstream>
-#include <filesystem> 
 #include <algorithm>
 #include <string>
 #include <cctype>
+#include <ctime>
 #include <SDL2/SDL_image.h>
 #include <SDL2/SDL_mixer.h>
-#include <stdexcept>
 
-MainMenu::MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music* bgm, SDL_Texture* bgTexture)
+MainMenu::MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music* bgm, SDL_Texture* bgTexture, AudioDevice* audioDevice)
     : renderer(r), font(f), 
-      titleTexture(nullptr), playButtonTexture(nullptr), highscoreButtonTexture(nullptr),
+      titleTexture(nullptr), playButtonTexture(nullptr), practiceButtonTexture(nullptr), highscoreButtonTexture(nullptr),
       settingsButtonTexture(nullptr), exitButtonTexture(nullptr), highscoreTitleTexture(nullptr),
       highscoreListTexture(nullptr), settingsTitleTexture(nullptr), backButtonTexture(nullptr),
-      volumeTexture(nullptr), sensitivityTexture(nullptr), backgroundTexture(bgTexture),
-      sfxButtonClick(sfxClick), bgmMenu(bgm),
-      playButton(PLAY_BUTTON_RECT), highscoreButton(HIGHSCORE_BUTTON_RECT),
+      volumeTexture(nullptr), sensitivityTexture(nullptr), audioModeTexture(nullptr), backgroundTexture(bgTexture),
+      sfxButtonClick(sfxClick), bgmMenu(bgm), audio(audioDevice),
+      playButton(PLAY_BUTTON_RECT), practiceButton(PRACTICE_BUTTON_RECT), highscoreButton(HIGHSCORE_BUTTON_RECT),
       settingsButton(SETTINGS_BUTTON_RECT), exitButton(EXIT_BUTTON_RECT),
       backButton(BACK_BUTTON_RECT), volumeSlider(VOLUME_SLIDER_RECT_SETTINGS),
       volumeKnob(VOLUME_KNOB_RECT_SETTINGS), sensitivitySlider(SENSITIVITY_SLIDER_RECT_SETTINGS),
-      sensitivityKnob(SENSITIVITY_KNOB_RECT_SETTINGS),
-      volume(DEFAULT_VOLUME), sensitivity(static_cast<int>(DEFAULT_SENSITIVITY)),
+      sensitivityKnob(SENSITIVITY_KNOB_RECT_SETTINGS), audioModeButton(AUDIO_MODE_BUTTON_RECT_SETTINGS),
+      volume(DEFAULT_VOLUME), sensitivity(static_cast<int>(DEFAULT_SENSITIVITY)), audioLatency(0),
+      runLog(persistence),
       isDraggingVolumeKnob(false), isDraggingSensitivityKnob(false),
       gameState(MENU) 
 {
@@ -34,8 +34,13 @@ MainMenu::MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music*
     }
     std::cout << "MainMenu received a valid font pointer." << std::endl;
 
-    loadHighscores();
-    loadSettings();
+    loadPlayerData();
+    runLog.open(RUN_LOG_FILE, RUN_INDEX_FILE);
+
+    if (audio && audio->isOpen() && static_cast<int>(audio->mode()) != audioLatency) {
+        audio->open(static_cast<AudioLatencyMode>(audioLatency));
+        audioLatency = static_cast<int>(audio->mode());
+    }
 
     auto createTexture = [&](const char* text, SDL_Texture*& texture) {
         if (!this->font) {
@@ -60,6 +65,7 @@ MainMenu::MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music*
 
     if (!createTexture("Space Shield", titleTexture)) {  }
     if (!createTexture("Play", playButtonTexture)) {  }
+    if (!createTexture("Practice", practiceButtonTexture)) {  }
     if (!createTexture("Highscore", highscoreButtonTexture)) {   }
     if (!createTexture("Settings", settingsButtonTexture)) {   }
     if (!createTexture("Exit", exitButtonTexture)) {   }
@@ -70,14 +76,16 @@ MainMenu::MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music*
     updateHighscoreListTexture();
     updateVolumeTexture();
     updateSensitivityTexture();
+    updateAudioModeTexture();
 
     Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100);
-    Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100); 
+    applyEffectsVolume();
 }
 
 MainMenu::~MainMenu() {
     if (titleTexture) SDL_DestroyTexture(titleTexture);
     if (playButtonTexture) SDL_DestroyTexture(playButtonTexture);
+    if (practiceButtonTexture) SDL_DestroyTexture(practiceButtonTexture);
     if (highscoreButtonTexture) SDL_DestroyTexture(highscoreButtonTexture);
     if (settingsButtonTexture) SDL_DestroyTexture(settingsButtonTexture);
     if (exitButtonTexture) SDL_DestroyTexture(exitButtonTexture);
@@ -87,46 +95,7 @@ MainMenu::~MainMenu() {
     if (backButtonTexture) SDL_DestroyTexture(backButtonTexture);
     if (volumeTexture) SDL_DestroyTexture(volumeTexture);
     if (sensitivityTexture) SDL_DestroyTexture(sensitivityTexture);
-}
-
-void MainMenu::loadHighscores() {
-    std::ifstream file(PLAYER_DATA_FILE);
-    highscores.clear();
-
-    if (!file.is_open()) {
-        std::cerr << "Could not open " << PLAYER_DATA_FILE << " for reading highscores. Initializing with defaults." << std::endl;
-        while (highscores.size() < MAX_HIGHSCORES_DISPLAY) {
-            highscores.push_back(0);
-        }
-        return;
-    }
-
-    std::cout << "Loading highscores from " << PLAYER_DATA_FILE << std::endl;
-    std::string line;
-    int score;
-    while (highscores.size() < MAX_HIGHSCORES_DISPLAY && std::getline(file, line)) {
-        try {
-            size_t processedChars = 0;
-            size_t first_digit = line.find_first_not_of(" \t");
-            if (first_digit == std::string::npos) continue;
-            score = std::stoi(line.substr(first_digit), &processedChars);
-            size_t last_digit = first_digit + processedChars;
-            size_t first_nondigit_after = line.find_first_not_of(" \t", last_digit);
-            if (first_nondigit_after == std::string::npos) {
-                 highscores.push_back(score);
-            }
-        } catch (const std::invalid_argument& ia) { }
-        catch (const std::out_of_range& oor) { std::cerr << "Skipping out-of-range highscore line: " << line << std::endl; }
-    }
-    file.close();
-
-    while (highscores.size() < MAX_HIGHSCORES_DISPLAY) {
-        highscores.push_back(0);
-    }
-    std::sort(highscores.begin(), highscores.end(), std::greater<int>());
-    if (highscores.size() > MAX_HIGHSCORES_DISPLAY) {
-        highscores.resize(MAX_HIGHSCORES_DISPLAY);
-    }
+    if (audioModeTexture) SDL_DestroyTexture(audioModeTexture);
 }
 
 void MainMenu::saveHighscores(int newScore) {
@@ -139,63 +108,49 @@ void MainMenu::saveHighscores(int newScore) {
     saveSettings(); 
 }
 
-void MainMenu::loadSettings() {
-    std::ifstream file(PLAYER_DATA_FILE);
-    volume = DEFAULT_VOLUME;
-    sensitivity = static_cast<int>(DEFAULT_SENSITIVITY);
+void MainMenu::recordRun(const RunRecord& run) {
+    runLog.append(run);
+}
 
-    if (!file.is_open()) {
-        std::cerr << "Could not open " << PLAYER_DATA_FILE << " for reading settings. Using defaults." << std::endl;
-    } else {
-        std::cout << "Loading settings from " << PLAYER_DATA_FILE << std::endl;
-        std::string line;
-        while (std::getline(file, line)) {
-            size_t separatorPos;
-            if ((separatorPos = line.find("Volume: ")) != std::string::npos) {
-                try {
-                    volume = std::stoi(line.substr(separatorPos + 8));
-                    volume = std::max(0, std::min(volume, 100));
-                } catch (...) { volume = DEFAULT_VOLUME; }
-            } else if ((separatorPos = line.find("Sensitivity: ")) != std::string::npos) {
-                try {
-                    sensitivity = std::stoi(line.substr(separatorPos + 13));
-                    sensitivity = std::max(0, std::min(sensitivity, 100));
-                } catch (...) { sensitivity = static_cast<int>(DEFAULT_SENSITIVITY); }
-            }
-        }
-        file.close();
+void MainMenu::loadPlayerData() {
+    PlayerData data;
+    PlayerDataSource source = readPlayerDataFile(PLAYER_DATA_FILE, data);
+    switch (source) {
+        case PlayerDataSource::Missing:
+            std::cerr << "Could not open " << PLAYER_DATA_FILE << " for reading. Using defaults." << std::endl;
+            break;
+        case PlayerDataSource::Corrupt:
+            std::cerr << "Player data in " << PLAYER_DATA_FILE << " is corrupt or unsupported. Using defaults." << std::endl;
+            break;
+        case PlayerDataSource::LegacyText:
+            std::cout << "Migrating legacy text player data in " << PLAYER_DATA_FILE << std::endl;
+            break;
+        case PlayerDataSource::Binary:
+            std::cout << "Loaded player data from " << PLAYER_DATA_FILE << std::endl;
+            break;
     }
 
+    highscores.assign(data.highscores, data.highscores + MAX_HIGHSCORES_DISPLAY);
+    volume = data.volume;
+    sensitivity = data.sensitivity;
+    audioLatency = data.audioLatency;
+
     int knobRangeVol = volumeSlider.w - volumeKnob.w;
     volumeKnob.x = volumeSlider.x + static_cast<int>(round(((float)volume / 100.0f) * knobRangeVol));
     int knobRangeSens = sensitivitySlider.w - sensitivityKnob.w;
     sensitivityKnob.x = sensitivitySlider.x + static_cast<int>(round(((float)sensitivity / 100.0f) * knobRangeSens));
+
+    if (source == PlayerDataSource::LegacyText) saveSettings();
 }
 
 void MainMenu::saveSettings() {
-    if (!PLAYER_DATA_DIR.empty()) {
-        try {
-            if (!std::filesystem::exists(PLAYER_DATA_DIR)) {
-                 std::filesystem::create_directories(PLAYER_DATA_DIR);
-            }
-        } catch (const std::filesystem::filesystem_error& e) {
-            std::cerr << "Filesystem error creating directory: " << e.what() << std::endl;
-        } catch (...) {
-             std::cerr << "Unknown error creating directory " << PLAYER_DATA_DIR << std::endl;
-        }
-    }
-
-    std::ofstream file(PLAYER_DATA_FILE);
-    if (!file.is_open()) {
-        std::cerr << "Error: Could not open player data file for saving: " << PLAYER_DATA_FILE << std::endl;
-        return;
-    }
-
-    for (int s : highscores) { file << s << "\n"; }
-    file << "Volume: " << volume << "\n";
-    file << "Sensitivity: " << sensitivity << "\n";
-    file.close();
-    std::cout << "Saved scores and settings to " << PLAYER_DATA_FILE << std::endl;
+    PlayerData data;
+    resetPlayerData(data);
+    data.volume = volume;
+    data.sensitivity = sensitivity;
+    data.audioLatency = audioLatency;
+    for (size_t i = 0; i < highscores.size() && i < MAX_HIGHSCORES_DISPLAY; ++i) data.highscores[i] = highscores[i];
+    persistence.submit(PLAYER_DATA_FILE, encodePlayerData(data), "player data");
 }
 
 void MainMenu::updateHighscoreListTexture() {
@@ -234,6 +189,13 @@ void MainMenu::updateHighscoreListTexture() {
         }
     }
 
+    std::vector<RunRecord> weeklyBest = runLog.topRunsSince(static_cast<int64_t>(std::time(nullptr)) - LEADERBOARD_PERIOD_SECONDS, 1);
+    if (!weeklyBest.empty()) {
+        std::stringstream weekly;
+        weekly << "\n\nBest this week: " << weeklyBest[0].score << " (wave " << weeklyBest[0].wave << ")";
+        highscoreListStr += weekly.str();
+    }
+
 
     SDL_Surface* textSurface = TTF_RenderText_Blended_Wrapped(listFont, highscoreListStr.c_str(), TEXT_COLOR, SCREEN_WIDTH - 100); 
     TTF_CloseFont(listFont); 
@@ -290,6 +252,59 @@ void MainMenu::updateSensitivityTexture() {
     if (!sensitivityTexture) {}
 }
 
+void MainMenu::applyEffectsVolume() {
+    Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100);
+    if (audio) audio->setEffectsVolume(volume * MIX_MAX_VOLUME / 100);
+}
+
+void MainMenu::updateAudioModeTexture() {
+    TTF_Font* audioFont = TTF_OpenFont(FONT_PATH.c_str(), FONT_SIZE_NORMAL);
+    if (!audioFont) { if (audioModeTexture) SDL_DestroyTexture(audioModeTexture); audioModeTexture = nullptr; return; }
+
+    AudioLatencyMode mode = static_cast<AudioLatencyMode>(audioLatency);
+    int chunk = audioChunkSizeFor(mode);
+    std::stringstream ss;
+    ss << "Audio: " << audioLatencyName(mode) << " (" << chunk << ", " << (chunk * 1000 + AUDIO_FREQUENCY / 2) / AUDIO_FREQUENCY << " ms)";
+    std::string audioStr = ss.str();
+
+    SDL_Surface* textSurface = TTF_RenderText_Solid(audioFont, audioStr.c_str(), TEXT_COLOR);
+    TTF_CloseFont(audioFont);
+
+    if (!textSurface) { if (audioModeTexture) SDL_DestroyTexture(audioModeTexture); audioModeTexture = nullptr; return; }
+    if (audioModeTexture) SDL_DestroyTexture(audioModeTexture);
+    audioModeTexture = SDL_CreateTextureFromSurface(renderer, textSurface);
+    SDL_FreeSurface(textSurface);
+}
+
+void MainMenu::cycleAudioLatency(Game& game) {
+    audioLatency = (audioLatency + 1) % (PLAYER_DATA_MAX_AUDIO_LATENCY + 1);
+    if (audio && audio->open(static_cast<AudioLatencyMode>(audioLatency))) {
+        audioLatency = static_cast<int>(audio->mode());
+        restoreAudioAfterReopen(game);
+    }
+    updateAudioModeTexture();
+}
+
+// Called once per frame; reopening the device stops every channel, so the
+// settings and the music for the current screen are put back afterwards.
+void MainMenu::checkAudioDevice(Game& game) {
+    if (!audio || !audio->fallBackIfUnderrunning()) return;
+    audioLatency = static_cast<int>(audio->mode());
+    updateAudioModeTexture();
+    saveSettings();
+    restoreAudioAfterReopen(game);
+}
+
+void MainMenu::restoreAudioAfterReopen(Game& game) {
+    Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100);
+    applyEffectsVolume();
+    if (gameState == PLAYING || gameState == PAUSED) {
+        game.restartMusic();
+    } else if (gameState != GAME_OVER && bgmMenu) {
+        Mix_PlayMusic(bgmMenu, -1);
+    }
+}
+
 void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
     if (event.type == SDL_MOUSEBUTTONDOWN) {
        int mouseX, mouseY;
@@ -302,12 +317,19 @@ void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
                buttonClicked = true;
                gameState = PLAYING;
                game.reset();
+               game.setPracticeMode(false);
+               applySettingsToGame(game);
+               game.startGame();
+           } else if (SDL_PointInRect(&mousePoint, &practiceButton)) {
+               buttonClicked = true;
+               gameState = PLAYING;
+               game.reset();
+               game.setPracticeMode(true);
                applySettingsToGame(game);
                game.startGame();
            } else if (SDL_PointInRect(&mousePoint, &highscoreButton)) {
                buttonClicked = true;
                gameState = HIGHSCORE;
-               loadHighscores();
                updateHighscoreListTexture();
            } else if (SDL_PointInRect(&mousePoint, &settingsButton)) {
                buttonClicked = true;
@@ -337,7 +359,11 @@ void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
        }
 
        if (gameState == SETTINGS) {
-           if (SDL_PointInRect(&mousePoint, &volumeKnob) || SDL_PointInRect(&mousePoint, &volumeSlider)) {
+           if (SDL_PointInRect(&mousePoint, &audioModeButton)) {
+               buttonClicked = true;
+               cycleAudioLatency(game);
+           }
+           else if (SDL_PointInRect(&mousePoint, &volumeKnob) || SDL_PointInRect(&mousePoint, &volumeSlider)) {
                isDraggingVolumeKnob = true;
                 if (SDL_PointInRect(&mousePoint, &volumeSlider) && !SDL_PointInRect(&mousePoint, &volumeKnob)) {
                     int mouseX_Adjusted = mouseX;
@@ -349,7 +375,7 @@ void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
                           volumeKnob.x = volumeSlider.x + static_cast<int>(round(((float)volume / 100.0f) * knobRange));
                           updateVolumeTexture();
                           Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100);
-                          Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100);
+                          applyEffectsVolume();
                      }
                 }
            }
@@ -378,7 +404,7 @@ void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
            isDraggingVolumeKnob = false;
             // updateVolumeTexture(); 
             Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100);
-            Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100);
+            applyEffectsVolume();
         }
         if (isDraggingSensitivityKnob) {
             isDraggingSensitivityKnob = false;
@@ -406,7 +432,7 @@ void MainMenu::handleInput(SDL_Event& event, bool& running, Game& game) {
 
                    // Áp dụng âm lượng ngay lập tức để nghe thay đổi
                    Mix_VolumeMusic(volume * MIX_MAX_VOLUME / 100);
-                   Mix_Volume(-1, volume * MIX_MAX_VOLUME / 100); // Áp dụng cho SFX
+                   applyEffectsVolume();
                }
            }
            // Xử lý kéo núm Sensitivity
@@ -487,6 +513,7 @@ void MainMenu::render() {
         renderTextureAt(titleTexture, SCREEN_WIDTH / 2, 100);
         SDL_SetRenderDrawColor(renderer, BUTTON_COLOR.r, BUTTON_COLOR.g, BUTTON_COLOR.b, BUTTON_COLOR.a);
         SDL_RenderFillRect(renderer, &playButton); renderTextureCentered(playButtonTexture, playButton);
+        SDL_RenderFillRect(renderer, &practiceButton); renderTextureCentered(practiceButtonTexture, practiceButton);
         SDL_RenderFillRect(renderer, &highscoreButton); renderTextureCentered(highscoreButtonTexture, highscoreButton);
         SDL_RenderFillRect(renderer, &settingsButton); renderTextureCentered(settingsButtonTexture, settingsButton);
         SDL_RenderFillRect(renderer, &exitButton); renderTextureCentered(exitButtonTexture, exitButton);
@@ -506,6 +533,7 @@ void MainMenu::render() {
         renderTextureAt(sensitivityTexture, sensitivitySlider.x, SENSITIVITY_LABEL_Y_SETTINGS, false);
         SDL_SetRenderDrawColor(renderer, SLIDER_BG_COLOR.r, SLIDER_BG_COLOR.g, SLIDER_BG_COLOR.b, SLIDER_BG_COLOR.a); SDL_RenderFillRect(renderer, &sensitivitySlider);
         const SDL_Color& sensKnobColor = isDraggingSensitivityKnob ? SLIDER_KNOB_DRAG_COLOR : SLIDER_KNOB_COLOR; SDL_SetRenderDrawColor(renderer, sensKnobColor.r, sensKnobColor.g, sensKnobColor.b, sensKnobColor.a); SDL_RenderFillRect(renderer, &sensitivityKnob);
+        SDL_SetRenderDrawColor(renderer, BUTTON_COLOR.r, BUTTON_COLOR.g, BUTTON_COLOR.b, BUTTON_COLOR.a); SDL_RenderFillRect(renderer, &audioModeButton); renderTextureCentered(audioModeTexture, audioModeButton);
         SDL_SetRenderDrawColor(renderer, BUTTON_COLOR.r, BUTTON_COLOR.g, BUTTON_COLOR.b, BUTTON_COLOR.a); SDL_RenderFillRect(renderer, &backButton); renderTextureCentered(backButtonTexture, backButton);
     }
 
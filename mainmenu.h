@@ -7,6 +7,9 @@
 #include <vector>
 #include <string>
 #include "config.h"
+#include "persistence.h"
+#include "runlog.h"
+#include "audio.h"
 
 class Game;
 
@@ -20,6 +23,7 @@ public:
 
     SDL_Texture* titleTexture;
     SDL_Texture* playButtonTexture;
+    SDL_Texture* practiceButtonTexture;
     SDL_Texture* highscoreButtonTexture;
     SDL_Texture* settingsButtonTexture;
     SDL_Texture* exitButtonTexture;
@@ -29,13 +33,16 @@ public:
     SDL_Texture* backButtonTexture;
     SDL_Texture* volumeTexture;        
     SDL_Texture* sensitivityTexture;  
+    SDL_Texture* audioModeTexture;
     SDL_Texture* backgroundTexture;    
 
 
     Mix_Chunk* sfxButtonClick; 
     Mix_Music* bgmMenu;       
+    AudioDevice* audio;
 
     SDL_Rect playButton;
+    SDL_Rect practiceButton;
     SDL_Rect highscoreButton;
     SDL_Rect settingsButton;
     SDL_Rect exitButton;
@@ -44,28 +51,38 @@ public:
     SDL_Rect volumeKnob;       
     SDL_Rect sensitivitySlider; 
     SDL_Rect sensitivityKnob;   
+    SDL_Rect audioModeButton;
 
     std::vector<int> highscores; 
     int volume;                  
     int sensitivity;            
+    int audioLatency;
+
+    PersistenceWorker persistence;
+    RunLog runLog;
 
     bool isDraggingVolumeKnob;
     bool isDraggingSensitivityKnob;
 
-    MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music* bgm, SDL_Texture* bgTexture);
+    MainMenu(SDL_Renderer* r, TTF_Font* f, Mix_Chunk* sfxClick, Mix_Music* bgm, SDL_Texture* bgTexture, AudioDevice* audioDevice);
     ~MainMenu(); 
 
     void handleInput(SDL_Event& event, bool& running, Game& game); 
     void render(); 
 
-    void loadHighscores();              
+    void loadPlayerData();
     void saveHighscores(int score);   
+    void recordRun(const RunRecord& run);
     void updateHighscoreListTexture();  
 
-    void loadSettings();            
     void saveSettings();               
     void updateVolumeTexture();     
     void updateSensitivityTexture();    
+    void updateAudioModeTexture();
+    void applyEffectsVolume();
+    void cycleAudioLatency(Game& game);
+    void checkAudioDevice(Game& game);
+    void restoreAudioAfterReopen(Game& game);
     void applySettingsToGame(Game& game); 
 };
 
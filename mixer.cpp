@@ -0,0 +1,165 @@
+#include "mixer.h"
+#include <SDL2/SDL_mixer.h>
+#include <algorithm>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define MIXER_USE_SSE2 1
+#endif
+
+namespace {
+
+int soundPriority(SoundType type) {
+    switch (type) {
+        case SoundType::GameOver: return 5;
+        case SoundType::WarningStart: return 4;
+        case SoundType::PlayerHit: return 3;
+        case SoundType::HealCollect: return 2;
+        case SoundType::ShieldHit: return 1;
+        default: return 0;
+    }
+}
+
+// Products are kept at Q7 so that dozens of full-scale voices still fit in
+// the 32-bit accumulator.
+constexpr int PRODUCT_SHIFT = 8;
+constexpr int RESOLVE_SHIFT = 15 - PRODUCT_SHIFT;
+
+// accumulator[i] += samples[i] * gain, gain in Q15.
+void accumulate(int32_t* acc, const Sint16* samples, int count, int32_t gain) {
+    int i = 0;
+#ifdef MIXER_USE_SSE2
+    __m128i g = _mm_set1_epi16(static_cast<short>(gain));
+    for (; i + 8 <= count; i += 8) {
+        __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(samples + i));
+        __m128i lo = _mm_mullo_epi16(x, g);
+        __m128i hi = _mm_mulhi_epi16(x, g);
+        __m128i* a = reinterpret_cast<__m128i*>(acc + i);
+        __m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), PRODUCT_SHIFT);
+        __m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), PRODUCT_SHIFT);
+        _mm_storeu_si128(a, _mm_add_epi32(_mm_loadu_si128(a), p0));
+        _mm_storeu_si128(a + 1, _mm_add_epi32(_mm_loadu_si128(a + 1), p1));
+    }
+#endif
+    for (; i < count; ++i) acc[i] += (samples[i] * gain) >> PRODUCT_SHIFT;
+}
+
+// stream[i] = saturate(stream[i] + accumulator[i] back to Q0)
+void resolve(Sint16* stream, const int32_t* acc, int count) {
+    int i = 0;
+#ifdef MIXER_USE_SSE2
+    for (; i + 8 <= count; i += 8) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(stream + i));
+        __m128i s0 = _mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16);
+        __m128i s1 = _mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16);
+        __m128i a0 = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i)), RESOLVE_SHIFT);
+        __m128i a1 = _mm_srai_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(acc + i + 4)), RESOLVE_SHIFT);
+        __m128i out = _mm_packs_epi32(_mm_add_epi32(s0, a0), _mm_add_epi32(s1, a1));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(stream + i), out);
+    }
+#endif
+    for (; i < count; ++i) {
+        int32_t v = stream[i] + (acc[i] >> RESOLVE_SHIFT);
+        stream[i] = static_cast<Sint16>(std::max(-32768, std::min(32767, v)));
+    }
+}
+
+}
+
+SoundMixer::SoundMixer()
+    : voices(), accumulator(), voiceCounter(0), masterVolume(MIX_MAX_VOLUME),
+      active(0), peak(0), stolen(0), dropped(0) {}
+
+void SoundMixer::reset() {
+    for (MixerVoice& v : voices) v.active = false;
+    active = 0;
+}
+
+void SoundMixer::play(const SoundEvent& event) {
+    if (event.type == SoundType::WarningStop) {
+        stopType(SoundType::WarningStart);
+        return;
+    }
+    if (event.type == SoundType::StopAll) {
+        reset();
+        return;
+    }
+    if (!event.chunk || !event.chunk->abuf || event.chunk->alen < sizeof(Sint16)) return;
+    if (event.type == SoundType::WarningStart) stopType(SoundType::WarningStart);
+
+    int priority = soundPriority(event.type);
+    int index = allocateVoice(priority);
+    if (index < 0) {
+        dropped++;
+        return;
+    }
+
+    MixerVoice& v = voices[index];
+    v.samples = reinterpret_cast<const Sint16*>(event.chunk->abuf);
+    v.length = event.chunk->alen / sizeof(Sint16);
+    v.position = 0;
+    v.chunkVolume = event.chunk->volume;
+    v.priority = priority;
+    v.started = ++voiceCounter;
+    v.type = event.type;
+    v.loop = event.type == SoundType::WarningStart;
+    v.active = true;
+}
+
+int SoundMixer::allocateVoice(int priority) {
+    int victim = -1;
+    for (int i = 0; i < SOUND_MIXER_VOICES; ++i) {
+        const MixerVoice& v = voices[i];
+        if (!v.active) return i;
+        if (v.priority > priority || v.loop) continue;
+        if (victim < 0 || v.priority < voices[victim].priority ||
+            (v.priority == voices[victim].priority && v.started < voices[victim].started)) {
+            victim = i;
+        }
+    }
+    if (victim >= 0) stolen++;
+    return victim;
+}
+
+void SoundMixer::stopType(SoundType type) {
+    for (MixerVoice& v : voices) {
+        if (v.active && v.type == type) v.active = false;
+    }
+}
+
+void SoundMixer::mixVoice(MixerVoice& voice, int32_t gain, int samples) {
+    int done = 0;
+    while (done < samples && voice.active) {
+        int n = std::min<int>(samples - done, static_cast<int>(voice.length - voice.position));
+        accumulate(accumulator + done, voice.samples + voice.position, n, gain);
+        done += n;
+        voice.position += n;
+        if (voice.position >= voice.length) {
+            if (voice.loop) voice.position = 0;
+            else voice.active = false;
+        }
+    }
+}
+
+void SoundMixer::mix(Sint16* stream, int samples) {
+    int master = masterVolume.load();
+    for (int offset = 0; offset < samples; offset += SOUND_MIXER_BLOCK) {
+        int count = std::min(SOUND_MIXER_BLOCK, samples - offset);
+        std::memset(accumulator, 0, count * sizeof(int32_t));
+        int playing = 0;
+        for (MixerVoice& v : voices) {
+            if (!v.active) continue;
+            playing++;
+            // chunk volume x master volume, both 0..128, as Q15 capped below 1.0
+            int32_t gain = std::min(32767, v.chunkVolume * master * 2);
+            mixVoice(v, gain, count);
+        }
+        if (playing > peak.load()) peak = playing;
+        if (playing > 0) resolve(stream + offset, accumulator, count);
+    }
+
+    int still = 0;
+    for (const MixerVoice& v : voices) still += v.active ? 1 : 0;
+    active = still;
+}
@@ -0,0 +1,59 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <SDL2/SDL.h>
+#include <atomic>
+#include <cstdint>
+#include "config.h"
+#include "soundqueue.h"
+
+struct MixerVoice {
+    const Sint16* samples;
+    uint32_t length;
+    uint32_t position;
+    int32_t chunkVolume;
+    int priority;
+    uint32_t started;
+    SoundType type;
+    bool loop;
+    bool active;
+};
+
+// Software mixer for game sounds, run from the audio callback on top of
+// whatever SDL_mixer produced. Voices point straight at the chunk's PCM,
+// which Mix_LoadWAV has already converted to the device format, and live in
+// a fixed pool; when it is full the oldest voice of the lowest priority
+// not above the new sound is stolen. Only 16-bit output is supported.
+class SoundMixer {
+public:
+    SoundMixer();
+
+    void reset();
+    void setMasterVolume(int volume) { masterVolume = volume; }
+    int getMasterVolume() const { return masterVolume.load(); }
+
+    // Audio thread only.
+    void play(const SoundEvent& event);
+    void mix(Sint16* stream, int samples);
+
+    int activeVoices() const { return active.load(); }
+    int peakVoices() const { return peak.load(); }
+    int stolenVoices() const { return stolen.load(); }
+    int droppedSounds() const { return dropped.load(); }
+
+private:
+    int allocateVoice(int priority);
+    void stopType(SoundType type);
+    void mixVoice(MixerVoice& voice, int32_t gain, int samples);
+
+    MixerVoice voices[SOUND_MIXER_VOICES];
+    int32_t accumulator[SOUND_MIXER_BLOCK];
+    uint32_t voiceCounter;
+    std::atomic<int> masterVolume;
+    std::atomic<int> active;
+    std::atomic<int> peak;
+    std::atomic<int> stolen;
+    std::atomic<int> dropped;
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include "numberlabel.h"
+#include <iostream>
+
+namespace {
+
+const char DIGITS[] = "0123456789";
+
+SDL_Texture* renderText(SDL_Renderer* renderer, TTF_Font* font, const char* text, SDL_Color color) {
+    SDL_Surface* surface = TTF_RenderText_Solid(font, text, color);
+    if (!surface) {
+        std::cerr << "TTF_RenderText_Solid failed for \"" << text << "\": " << TTF_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
+    SDL_FreeSurface(surface);
+    if (!texture) std::cerr << "SDL_CreateTextureFromSurface failed for \"" << text << "\": " << SDL_GetError() << std::endl;
+    return texture;
+}
+
+}
+
+NumberLabel::NumberLabel()
+    : prefixTexture(nullptr), digitTexture(nullptr), prefixWidth(0), textHeight(0), digitX{}, digits{'0'}, digitCount(1) {}
+
+NumberLabel::~NumberLabel() {
+    release();
+}
+
+void NumberLabel::release() {
+    if (prefixTexture) SDL_DestroyTexture(prefixTexture);
+    if (digitTexture) SDL_DestroyTexture(digitTexture);
+    prefixTexture = nullptr;
+    digitTexture = nullptr;
+}
+
+// Digit boundaries come from measuring each prefix of the strip, so the
+// glyphs are cut where TTF placed them.
+bool NumberLabel::load(SDL_Renderer* renderer, TTF_Font* font, const char* prefix, SDL_Color color) {
+    release();
+    if (!font) return false;
+    prefixTexture = renderText(renderer, font, prefix, color);
+    digitTexture = renderText(renderer, font, DIGITS, color);
+    if (!isLoaded()) {
+        release();
+        return false;
+    }
+
+    SDL_QueryTexture(prefixTexture, NULL, NULL, &prefixWidth, &textHeight);
+    char head[11] = {};
+    for (int i = 1; i <= 10; ++i) {
+        head[i - 1] = DIGITS[i - 1];
+        if (TTF_SizeText(font, head, &digitX[i], NULL) != 0) {
+            release();
+            return false;
+        }
+    }
+    return true;
+}
+
+void NumberLabel::setValue(int value) {
+    unsigned int v = value > 0 ? static_cast<unsigned int>(value) : 0u;
+    char reversed[sizeof(digits)];
+    int n = 0;
+    do {
+        reversed[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v > 0);
+    for (int i = 0; i < n; ++i) digits[i] = reversed[n - 1 - i];
+    digitCount = n;
+}
+
+int NumberLabel::width() const {
+    int w = prefixWidth;
+    for (int i = 0; i < digitCount; ++i) {
+        int d = digits[i] - '0';
+        w += digitX[d + 1] - digitX[d];
+    }
+    return w;
+}
+
+void NumberLabel::render(SDL_Renderer* renderer, int x, int y) const {
+    if (!isLoaded()) return;
+    SDL_Rect prefixRect = {x, y, prefixWidth, textHeight};
+    SDL_RenderCopy(renderer, prefixTexture, NULL, &prefixRect);
+    x += prefixWidth;
+    for (int i = 0; i < digitCount; ++i) {
+        int d = digits[i] - '0';
+        SDL_Rect src = {digitX[d], 0, digitX[d + 1] - digitX[d], textHeight};
+        SDL_Rect dst = {x, y, src.w, src.h};
+        SDL_RenderCopy(renderer, digitTexture, &src, &dst);
+        x += src.w;
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef NUMBERLABEL_H
+#define NUMBERLABEL_H
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_ttf.h>
+
+// "Score: 1234"-style text drawn from two textures rendered once: the
+// prefix and a strip of the ten digits. Changing the value only rewrites a
+// few bytes, so a score that changes on every kill never goes back to TTF
+// or the texture allocator.
+class NumberLabel {
+public:
+    NumberLabel();
+    ~NumberLabel();
+
+    NumberLabel(const NumberLabel&) = delete;
+    NumberLabel& operator=(const NumberLabel&) = delete;
+
+    bool load(SDL_Renderer* renderer, TTF_Font* font, const char* prefix, SDL_Color color);
+    void release();
+    void setValue(int value);
+
+    bool isLoaded() const { return prefixTexture && digitTexture; }
+    int width() const;
+    int height() const { return textHeight; }
+    void render(SDL_Renderer* renderer, int x, int y) const;
+
+private:
+    SDL_Texture* prefixTexture;
+    SDL_Texture* digitTexture;
+    int prefixWidth;
+    int textHeight;
+    int digitX[11];
+    char digits[12];
+    int digitCount;
+};
+
+#endif
@@ -0,0 +1,244 @@
+#include "persistence.h"
+#include <iostream>
+#include <filesystem>
+#include <utility>
+#include <algorithm>
+#include <cstdio>
+#include <fcntl.h>
+#ifdef _WIN32
+#include <io.h>
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace {
+
+constexpr size_t PENDING_RESERVE = 16;
+
+bool writeAllAndSync(int fd, const std::string& bytes) {
+    size_t written = 0;
+    bool ok = true;
+    while (written < bytes.size()) {
+#ifdef _WIN32
+        int n = _write(fd, bytes.data() + written, static_cast<unsigned int>(bytes.size() - written));
+#else
+        ssize_t n = write(fd, bytes.data() + written, bytes.size() - written);
+#endif
+        if (n <= 0) { ok = false; break; }
+        written += static_cast<size_t>(n);
+    }
+#ifdef _WIN32
+    if (ok && _commit(fd) != 0) ok = false;
+    _close(fd);
+#else
+    if (ok && fsync(fd) != 0) ok = false;
+    close(fd);
+#endif
+    return ok;
+}
+
+}
+
+PersistenceWorker::PersistenceWorker()
+    : writing(false), stopping(false) {
+    // Room for a typical queue up front, so steady saving does not grow it.
+    pending.reserve(PENDING_RESERVE);
+    batch.reserve(PENDING_RESERVE);
+    spares.reserve(PENDING_RESERVE);
+    worker = std::thread(&PersistenceWorker::run, this);
+}
+
+PersistenceWorker::~PersistenceWorker() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    if (worker.joinable()) worker.join();
+}
+
+void PersistenceWorker::submit(const std::string& path, std::string contents, const char* what) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                     [&](const PendingWrite& w) { return w.path == path; }),
+                      pending.end());
+        pending.push_back({path, std::move(contents), WriteKind::Replace, what});
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::exchange(const std::string& path, std::string& contents) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto last = std::find_if(pending.rbegin(), pending.rend(),
+                                 [&](const PendingWrite& w) { return w.path == path; });
+        if (last != pending.rend() && last->kind == WriteKind::Replace) {
+            // Only ever the one entry for the path; the older contents come back.
+            last->contents.swap(contents);
+        } else {
+            pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                         [&](const PendingWrite& w) { return w.path == path; }),
+                          pending.end());
+            PendingWrite write;
+            if (!spares.empty()) {
+                write = std::move(spares.back());
+                spares.pop_back();
+            }
+            write.path = path;
+            write.kind = WriteKind::Replace;
+            write.what = nullptr;
+            write.recycle = true;
+            write.contents.swap(contents);
+            pending.push_back(std::move(write));
+        }
+        contents.clear();
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::remove(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        pending.erase(std::remove_if(pending.begin(), pending.end(),
+                                     [&](const PendingWrite& w) { return w.path == path; }),
+                      pending.end());
+        pending.push_back({path, std::string(), WriteKind::Remove});
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::append(const std::string& path, const std::string& bytes) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto last = std::find_if(pending.rbegin(), pending.rend(),
+                                 [&](const PendingWrite& w) { return w.path == path; });
+        if (last != pending.rend() && last->kind != WriteKind::Remove) last->contents += bytes;
+        else pending.push_back({path, bytes, WriteKind::Append});
+    }
+    wake.notify_one();
+}
+
+void PersistenceWorker::reserveBuffers(const std::string& path, size_t count, size_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (size_t i = 0; i < count; ++i) {
+        PendingWrite write;
+        write.path = path;
+        write.kind = WriteKind::Replace;
+        write.recycle = true;
+        write.contents.reserve(bytes);
+        spares.push_back(std::move(write));
+    }
+}
+
+void PersistenceWorker::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && !writing; });
+}
+
+void PersistenceWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !pending.empty(); });
+        if (pending.empty()) break;
+
+        // batch keeps its capacity between rounds, and pending gets it back.
+        batch.swap(pending);
+        writing = true;
+        lock.unlock();
+
+        for (const auto& entry : batch) {
+            if (entry.kind == WriteKind::Remove) {
+                std::remove(entry.path.c_str());
+            } else if (entry.kind == WriteKind::Append) {
+                appendDurably(entry.path, entry.contents);
+            } else if (writeAtomically(entry.path, entry.contents) && entry.what) {
+                std::cout << "Saved " << entry.what << " to " << entry.path << std::endl;
+            }
+        }
+
+        lock.lock();
+        for (auto& entry : batch) {
+            if (entry.recycle) spares.push_back(std::move(entry));
+        }
+        batch.clear();
+        writing = false;
+        if (pending.empty()) idle.notify_all();
+    }
+    idle.notify_all();
+}
+
+bool PersistenceWorker::ensureParentDirectory(const std::string& path) {
+    std::filesystem::path parent = std::filesystem::path(path).parent_path();
+    if (parent.empty() || createdDirectories.count(parent.string())) return true;
+
+    std::error_code ec;
+    std::filesystem::create_directories(parent, ec);
+    if (ec) {
+        std::cerr << "Filesystem error creating directory " << parent.string() << ": " << ec.message() << std::endl;
+        return false;
+    }
+    createdDirectories.insert(parent.string());
+    return true;
+}
+
+bool PersistenceWorker::writeAtomically(const std::string& path, const std::string& contents) {
+    if (!ensureParentDirectory(path)) return false;
+
+    std::string tempPath = path + ".tmp";
+#ifdef _WIN32
+    int fd = _open(tempPath.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, 0644);
+#else
+    int fd = open(tempPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd < 0) {
+        std::cerr << "Error: Could not open " << tempPath << " for writing." << std::endl;
+        return false;
+    }
+
+    bool ok = writeAllAndSync(fd, contents);
+    if (!ok) {
+        std::cerr << "Error: Failed to write " << tempPath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifdef _WIN32
+    if (!MoveFileExA(tempPath.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH)) {
+#else
+    if (std::rename(tempPath.c_str(), path.c_str()) != 0) {
+#endif
+        std::cerr << "Error: Could not replace " << path << " with " << tempPath << std::endl;
+        std::remove(tempPath.c_str());
+        return false;
+    }
+
+#ifndef _WIN32
+    std::string parent = std::filesystem::path(path).parent_path().string();
+    int dirFd = open(parent.empty() ? "." : parent.c_str(), O_RDONLY);
+    if (dirFd >= 0) {
+        fsync(dirFd);
+        close(dirFd);
+    }
+#endif
+    return true;
+}
+
+bool PersistenceWorker::appendDurably(const std::string& path, const std::string& bytes) {
+    if (!ensureParentDirectory(path)) return false;
+
+#ifdef _WIN32
+    int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_APPEND | _O_BINARY, 0644);
+#else
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND, 0644);
+#endif
+    if (fd < 0) {
+        std::cerr << "Error: Could not open " << path << " for appending." << std::endl;
+        return false;
+    }
+
+    bool ok = writeAllAndSync(fd, bytes);
+    if (!ok) std::cerr << "Error: Failed to append to " << path << std::endl;
+    return ok;
+}
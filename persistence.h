@@ -0,0 +1,65 @@
+#ifndef PERSISTENCE_H
+#define PERSISTENCE_H
+
+#include <string>
+#include <vector>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Background writer for player files. Callers hand over the full contents of a
+// file and return immediately; the worker thread writes it to "<path>.tmp",
+// fsyncs and renames it over the target. If a path is submitted again before
+// its previous contents reached disk, only the newest contents are written.
+// Appends are queued in order behind any pending write to the same path and
+// fsynced after they are written; a removal drops whatever is still queued.
+// A submit with a description logs "Saved <what> to <path>" once written.
+class PersistenceWorker {
+public:
+    PersistenceWorker();
+    ~PersistenceWorker();
+
+    PersistenceWorker(const PersistenceWorker&) = delete;
+    PersistenceWorker& operator=(const PersistenceWorker&) = delete;
+
+    void submit(const std::string& path, std::string contents, const char* what = nullptr);
+    // As submit, but swaps contents for an empty buffer the worker is done
+    // with, so a file saved over and over reuses the same few buffers.
+    void exchange(const std::string& path, std::string& contents);
+    // Sets aside count buffers of bytes for exchange on path. Two cover a
+    // write in progress plus one waiting.
+    void reserveBuffers(const std::string& path, size_t count, size_t bytes);
+    void append(const std::string& path, const std::string& bytes);
+    void remove(const std::string& path);
+    void flush();
+
+private:
+    enum class WriteKind { Replace, Append, Remove };
+
+    struct PendingWrite {
+        std::string path;
+        std::string contents;
+        WriteKind kind;
+        const char* what = nullptr;
+        bool recycle = false;
+    };
+
+    void run();
+    bool ensureParentDirectory(const std::string& path);
+    bool writeAtomically(const std::string& path, const std::string& contents);
+    bool appendDurably(const std::string& path, const std::string& bytes);
+
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    std::vector<PendingWrite> pending;
+    std::vector<PendingWrite> batch;
+    std::vector<PendingWrite> spares;
+    std::set<std::string> createdDirectories;
+    bool writing;
+    bool stopping;
+    std::thread worker;
+};
+
+#endif
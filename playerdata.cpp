@@ -0,0 +1,165 @@
+#include "playerdata.h"
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <functional>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+
+namespace {
+
+struct Crc32Table {
+    uint32_t entries[256];
+    Crc32Table() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i;
+            for (int k = 0; k < 8; ++k) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            entries[i] = c;
+        }
+    }
+};
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+uint16_t getU16(const std::string& in, size_t pos) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(in[pos]) | (static_cast<uint8_t>(in[pos + 1]) << 8));
+}
+
+uint32_t getU32(const std::string& in, size_t pos) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(in[pos + i])) << (8 * i);
+    return v;
+}
+
+int clampPercent(long v) {
+    return static_cast<int>(std::max(0L, std::min(v, 100L)));
+}
+
+void sortHighscores(PlayerData& data) {
+    std::sort(data.highscores, data.highscores + MAX_HIGHSCORES_DISPLAY, std::greater<int>());
+}
+
+}
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc) {
+    static const Crc32Table table;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    crc = ~crc;
+    for (size_t i = 0; i < length; ++i) crc = table.entries[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    return ~crc;
+}
+
+void resetPlayerData(PlayerData& data) {
+    data.volume = DEFAULT_VOLUME;
+    data.sensitivity = static_cast<int>(DEFAULT_SENSITIVITY);
+    data.audioLatency = 0;
+    std::fill(data.highscores, data.highscores + MAX_HIGHSCORES_DISPLAY, 0);
+}
+
+std::string encodePlayerData(const PlayerData& data) {
+    std::string payload;
+    payload.reserve(PLAYER_DATA_SETTINGS_SIZE + MAX_HIGHSCORES_DISPLAY * 4);
+    putU32(payload, static_cast<uint32_t>(data.volume));
+    putU32(payload, static_cast<uint32_t>(data.sensitivity));
+    putU16(payload, static_cast<uint16_t>(MAX_HIGHSCORES_DISPLAY));
+    putU16(payload, static_cast<uint16_t>(data.audioLatency));
+    for (int s : data.highscores) putU32(payload, static_cast<uint32_t>(s));
+
+    std::string out;
+    out.reserve(PLAYER_DATA_HEADER_SIZE + payload.size());
+    out.append(PLAYER_DATA_MAGIC, sizeof(PLAYER_DATA_MAGIC));
+    putU16(out, PLAYER_DATA_VERSION);
+    putU16(out, static_cast<uint16_t>(PLAYER_DATA_HEADER_SIZE));
+    putU32(out, static_cast<uint32_t>(payload.size()));
+    putU32(out, crc32(payload.data(), payload.size()));
+    out += payload;
+    return out;
+}
+
+bool decodePlayerData(const std::string& bytes, PlayerData& data) {
+    if (bytes.size() < PLAYER_DATA_HEADER_SIZE) return false;
+    if (std::memcmp(bytes.data(), PLAYER_DATA_MAGIC, sizeof(PLAYER_DATA_MAGIC)) != 0) return false;
+
+    uint16_t version = getU16(bytes, 4);
+    size_t headerSize = getU16(bytes, 6);
+    size_t payloadSize = getU32(bytes, 8);
+    uint32_t expectedCrc = getU32(bytes, 12);
+    if (version == 0 || version > PLAYER_DATA_VERSION) return false;
+    if (headerSize < PLAYER_DATA_HEADER_SIZE || headerSize > bytes.size()) return false;
+    if (payloadSize < PLAYER_DATA_SETTINGS_SIZE || bytes.size() - headerSize < payloadSize) return false;
+    if (crc32(bytes.data() + headerSize, payloadSize) != expectedCrc) return false;
+
+    size_t pos = headerSize;
+    resetPlayerData(data);
+    data.volume = clampPercent(static_cast<int32_t>(getU32(bytes, pos)));
+    data.sensitivity = clampPercent(static_cast<int32_t>(getU32(bytes, pos + 4)));
+    size_t scoreCount = getU16(bytes, pos + 8);
+    data.audioLatency = std::min<int>(getU16(bytes, pos + 10), PLAYER_DATA_MAX_AUDIO_LATENCY);
+    pos += PLAYER_DATA_SETTINGS_SIZE;
+    if (payloadSize - PLAYER_DATA_SETTINGS_SIZE < scoreCount * 4) return false;
+
+    for (size_t i = 0; i < scoreCount && i < static_cast<size_t>(MAX_HIGHSCORES_DISPLAY); ++i) {
+        data.highscores[i] = static_cast<int32_t>(getU32(bytes, pos + i * 4));
+    }
+    sortHighscores(data);
+    return true;
+}
+
+bool parseLegacyPlayerData(const std::string& text, PlayerData& data) {
+    resetPlayerData(data);
+    int scoreCount = 0;
+    bool sawAnything = false;
+    size_t lineStart = 0;
+    while (lineStart < text.size()) {
+        size_t lineEnd = text.find('\n', lineStart);
+        if (lineEnd == std::string::npos) lineEnd = text.size();
+        std::string line = text.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 1;
+
+        const char* begin = line.c_str();
+        char* end = nullptr;
+        size_t separatorPos;
+        if ((separatorPos = line.find("Volume: ")) != std::string::npos) {
+            long v = std::strtol(begin + separatorPos + 8, &end, 10);
+            if (end != begin + separatorPos + 8) data.volume = clampPercent(v);
+            sawAnything = true;
+        } else if ((separatorPos = line.find("Sensitivity: ")) != std::string::npos) {
+            long v = std::strtol(begin + separatorPos + 13, &end, 10);
+            if (end != begin + separatorPos + 13) data.sensitivity = clampPercent(v);
+            sawAnything = true;
+        } else if (scoreCount < MAX_HIGHSCORES_DISPLAY) {
+            long v = std::strtol(begin, &end, 10);
+            if (end == begin || v < INT_MIN || v > INT_MAX) continue;
+            while (*end == ' ' || *end == '\t' || *end == '\r') ++end;
+            if (*end != '\0') continue;
+            data.highscores[scoreCount++] = static_cast<int>(v);
+            sawAnything = true;
+        }
+    }
+    sortHighscores(data);
+    return sawAnything;
+}
+
+PlayerDataSource readPlayerDataFile(const std::string& path, PlayerData& data) {
+    resetPlayerData(data);
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) return PlayerDataSource::Missing;
+
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() >= sizeof(PLAYER_DATA_MAGIC) && std::memcmp(bytes.data(), PLAYER_DATA_MAGIC, sizeof(PLAYER_DATA_MAGIC)) == 0) {
+        if (decodePlayerData(bytes, data)) return PlayerDataSource::Binary;
+        resetPlayerData(data);
+        return PlayerDataSource::Corrupt;
+    }
+    if (parseLegacyPlayerData(bytes, data)) return PlayerDataSource::LegacyText;
+    resetPlayerData(data);
+    return bytes.empty() ? PlayerDataSource::Missing : PlayerDataSource::Corrupt;
+}
@@ -0,0 +1,36 @@
+#ifndef PLAYERDATA_H
+#define PLAYERDATA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "config.h"
+
+// On-disk layout (little-endian):
+//   header   "SSPD" | u16 version | u16 header size | u32 payload size | u32 crc32(payload)
+//   settings i32 volume | i32 sensitivity | u16 score count | u16 audio latency mode
+//   scores   score count x i32, highest first
+constexpr char PLAYER_DATA_MAGIC[4] = {'S', 'S', 'P', 'D'};
+constexpr uint16_t PLAYER_DATA_VERSION = 1;
+constexpr size_t PLAYER_DATA_HEADER_SIZE = 16;
+constexpr size_t PLAYER_DATA_SETTINGS_SIZE = 12;
+constexpr int PLAYER_DATA_MAX_AUDIO_LATENCY = 2;
+
+struct PlayerData {
+    int volume;
+    int sensitivity;
+    int audioLatency;
+    int highscores[MAX_HIGHSCORES_DISPLAY];
+};
+
+enum class PlayerDataSource { Missing, Binary, LegacyText, Corrupt };
+
+uint32_t crc32(const void* data, size_t length, uint32_t crc = 0);
+
+void resetPlayerData(PlayerData& data);
+std::string encodePlayerData(const PlayerData& data);
+bool decodePlayerData(const std::string& bytes, PlayerData& data);
+bool parseLegacyPlayerData(const std::string& text, PlayerData& data);
+PlayerDataSource readPlayerDataFile(const std::string& path, PlayerData& data);
+
+#endif
@@ -0,0 +1,130 @@
+#include "polargrid.h"
+#include "fastmath.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr float SECTORS_PER_RADIAN = POLAR_GRID_SECTORS / (2.0f * PI);
+
+constexpr int SECTORS_PER_QUADRANT = POLAR_GRID_SECTORS / 4;
+static_assert(POLAR_GRID_SECTORS % 4 == 0, "sectors must split evenly into quadrants");
+
+int sectorOf(float angle) {
+    int sector = static_cast<int>(wrapAngle(angle) * SECTORS_PER_RADIAN);
+    return std::min(sector, POLAR_GRID_SECTORS - 1);
+}
+
+// Filing compares against these instead of taking a square root and an
+// arctangent per entity: the ring from the squared distance in ring widths,
+// and the sector within an octant from the tangents of its edges.
+struct CellTables {
+    uint8_t ringOfSquare[POLAR_GRID_RINGS * POLAR_GRID_RINGS];
+    float edgeTan[SECTORS_PER_QUADRANT / 2];
+
+    CellTables() {
+        for (int ring = 0; ring < POLAR_GRID_RINGS; ++ring) {
+            for (int q = ring * ring; q < (ring + 1) * (ring + 1); ++q) ringOfSquare[q] = static_cast<uint8_t>(ring);
+        }
+        for (int k = 0; k < SECTORS_PER_QUADRANT / 2; ++k) edgeTan[k] = std::tan((k + 1) / SECTORS_PER_RADIAN);
+    }
+};
+
+const CellTables cellTables;
+
+}
+
+PolarGrid::PolarGrid(float cx, float cy, int kindCount) : centerX(cx), centerY(cy), kinds(kindCount), count(0) {
+    std::fill(std::begin(cells), std::end(cells), -1);
+}
+
+void PolarGrid::reserve(size_t slotsPerKind) {
+    entries.reserve(slotsPerKind * kinds);
+}
+
+void PolarGrid::clear() {
+    entries.clear();
+    std::fill(std::begin(cells), std::end(cells), -1);
+    count = 0;
+}
+
+int PolarGrid::ringOf(float r) const {
+    if (r <= 0.0f) return 0;
+    return std::min(static_cast<int>(r / POLAR_GRID_RING_WIDTH), POLAR_GRID_RINGS - 1);
+}
+
+// Branch-free, since entities sit in every direction: the angle within the
+// quadrant is folded about its diagonal, and the octant's sector counted
+// from the tangent of the smaller side over the larger. A point exactly on
+// a sector edge may land on either side of it, as with fastAtan2.
+int32_t PolarGrid::cellAt(float x, float y) const {
+    float dx = x - centerX, dy = y - centerY;
+    float widths = (dx * dx + dy * dy) * (1.0f / (POLAR_GRID_RING_WIDTH * POLAR_GRID_RING_WIDTH));
+    int ring = widths < POLAR_GRID_RINGS * POLAR_GRID_RINGS ? cellTables.ringOfSquare[static_cast<int>(widths)] : POLAR_GRID_RINGS - 1;
+
+    float ax = std::fabs(dx), ay = std::fabs(dy);
+    float lo = std::min(ax, ay), hi = std::max(ax, ay);
+    float t = hi > 0.0f ? lo / hi : 0.0f;
+    int edges = 0;
+    for (int k = 0; k < SECTORS_PER_QUADRANT / 2 - 1; ++k) edges += t >= cellTables.edgeTan[k];
+    int inQuadrant = ay > ax ? SECTORS_PER_QUADRANT - 1 - edges : edges;
+    // Quadrants 1 and 3 run from their far edge back toward the axis.
+    int mirrored = (dx < 0.0f) != (dy < 0.0f);
+    int sector = (dy < 0.0f) * (POLAR_GRID_SECTORS / 2) + (mirrored ? 2 * SECTORS_PER_QUADRANT - 1 - inQuadrant : inQuadrant);
+    return ring * POLAR_GRID_SECTORS + sector;
+}
+
+void PolarGrid::unlink(int32_t index) {
+    Entry& e = entries[index];
+    if (e.prev >= 0) entries[e.prev].next = e.next;
+    else cells[e.cell] = e.next;
+    if (e.next >= 0) entries[e.next].prev = e.prev;
+    e.cell = -1;
+    count--;
+}
+
+void PolarGrid::place(int kind, EntityHandle handle, int32_t cell) {
+    size_t index = static_cast<size_t>(handle.slot()) * kinds + kind;
+    if (index >= entries.size()) entries.resize(index + 1, Entry{NULL_ENTITY, -1, -1, -1});
+    Entry& e = entries[index];
+    if (e.cell == cell && e.handle == handle) return;
+
+    if (e.cell >= 0) unlink(static_cast<int32_t>(index));
+    e.handle = handle;
+    e.cell = cell;
+    e.prev = -1;
+    e.next = cells[cell];
+    if (e.next >= 0) entries[e.next].prev = static_cast<int32_t>(index);
+    cells[cell] = static_cast<int32_t>(index);
+    count++;
+}
+
+void PolarGrid::remove(int kind, EntityHandle handle) {
+    size_t index = static_cast<size_t>(handle.slot()) * kinds + kind;
+    if (index < entries.size() && entries[index].cell >= 0 && entries[index].handle == handle) unlink(static_cast<int32_t>(index));
+}
+
+void PolarGrid::collect(int ring, int sector, std::vector<PolarGridHit>& out) const {
+    for (int32_t index = cells[ring * POLAR_GRID_SECTORS + sector]; index >= 0; index = entries[index].next) {
+        out.push_back(PolarGridHit{static_cast<int>(index % kinds), entries[index].handle});
+    }
+}
+
+void PolarGrid::queryArc(float start, float length, float rMin, float rMax, std::vector<PolarGridHit>& out) const {
+    int firstRing = ringOf(rMin), lastRing = ringOf(rMax);
+    int firstSector = sectorOf(start);
+    int sectors = POLAR_GRID_SECTORS;
+    if (length * SECTORS_PER_RADIAN + 1.0f < POLAR_GRID_SECTORS) {
+        sectors = (sectorOf(start + length) - firstSector + POLAR_GRID_SECTORS) % POLAR_GRID_SECTORS + 1;
+    }
+    for (int ring = firstRing; ring <= lastRing; ++ring) {
+        for (int i = 0; i < sectors; ++i) collect(ring, (firstSector + i) % POLAR_GRID_SECTORS, out);
+    }
+}
+
+void PolarGrid::queryDisc(float radius, std::vector<PolarGridHit>& out) const {
+    int lastRing = ringOf(radius);
+    for (int ring = 0; ring <= lastRing; ++ring) {
+        for (int sector = 0; sector < POLAR_GRID_SECTORS; ++sector) collect(ring, sector, out);
+    }
+}
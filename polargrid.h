@@ -0,0 +1,65 @@
+#ifndef POLARGRID_H
+#define POLARGRID_H
+
+#include <cstdint>
+#include <vector>
+#include "config.h"
+#include "entitypool.h"
+
+struct PolarGridHit {
+    int kind;
+    EntityHandle handle;
+};
+
+// Broad phase for everything that meets the shield. Entities are filed by
+// the polar cell of their centre around the trajectory centre: angle sectors
+// times rings of POLAR_GRID_RING_WIDTH px, the last ring catching everything
+// further out. Each cell is an intrusive list threaded through one entry per
+// (kind, pool slot), so moving an entity is O(1) and nothing allocates once
+// the pools have reached their size. Queries return every entity in a cell
+// that overlaps the region; callers still run the exact test. Game only
+// keeps one filled from POLAR_GRID_MIN_ENTITIES entities up.
+class PolarGrid {
+public:
+    PolarGrid(float centerX, float centerY, int kinds);
+
+    void clear();
+    // Inserts the entity, or moves it if it is already filed. A slot that
+    // now holds a different generation is treated as a fresh insert.
+    void update(int kind, EntityHandle handle, float x, float y) { place(kind, handle, cellAt(x, y)); }
+    // The two halves of update(): cellAt only reads the grid's geometry, so
+    // it can run for many entities at once before they are placed in turn.
+    int32_t cellAt(float x, float y) const;
+    void place(int kind, EntityHandle handle, int32_t cell);
+    void remove(int kind, EntityHandle handle);
+
+    // Cells overlapping the rings [rMin, rMax] and the arc from start
+    // through start + length (radians, length >= 0), the way the shield arc
+    // is measured.
+    void queryArc(float start, float length, float rMin, float rMax, std::vector<PolarGridHit>& out) const;
+    // Cells overlapping the disc of the given radius around the centre.
+    void queryDisc(float radius, std::vector<PolarGridHit>& out) const;
+
+    size_t size() const { return count; }
+    void reserve(size_t slotsPerKind);
+
+private:
+    struct Entry {
+        EntityHandle handle;
+        int32_t cell;
+        int32_t prev;
+        int32_t next;
+    };
+
+    int ringOf(float r) const;
+    void unlink(int32_t index);
+    void collect(int ring, int sector, std::vector<PolarGridHit>& out) const;
+
+    float centerX, centerY;
+    int kinds;
+    std::vector<Entry> entries;
+    int32_t cells[POLAR_GRID_RINGS * POLAR_GRID_SECTORS];
+    size_t count;
+};
+
+#endif
@@ -0,0 +1,173 @@
+#include "rewind.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr size_t MIN_ZERO_RUN = 8;
+constexpr size_t MAX_RUN = 0xFFFF;
+
+size_t maxEncodedSize(size_t rawLength) {
+    return 4 + rawLength + 4 * (rawLength / MAX_RUN + 2);
+}
+
+void putU16(unsigned char* out, size_t v) {
+    out[0] = static_cast<unsigned char>(v & 0xFF);
+    out[1] = static_cast<unsigned char>((v >> 8) & 0xFF);
+}
+
+size_t getU16(const unsigned char* in) {
+    return static_cast<size_t>(in[0]) | (static_cast<size_t>(in[1]) << 8);
+}
+
+}
+
+RewindBuffer::RewindBuffer(size_t arenaBytes, size_t maxFrames, int interval)
+    : arena(arenaBytes), frames(std::max<size_t>(maxFrames, 1)), head(0), count(0), writeOffset(0),
+      keyframeInterval(std::max(interval, 1)), framesSinceKeyframe(0) {}
+
+void RewindBuffer::clear() {
+    head = 0;
+    count = 0;
+    writeOffset = 0;
+    framesSinceKeyframe = 0;
+    keyframeState.clear();
+}
+
+size_t RewindBuffer::bytesUsed() const {
+    size_t used = 0;
+    for (size_t age = 0; age < count; ++age) used += frames[slot(age)].length;
+    return used;
+}
+
+bool RewindBuffer::push(const std::string& state) {
+    size_t offset = 0;
+    if (!reserve(maxEncodedSize(state.size()), offset)) return false;
+
+    bool isKeyframe = count == 0 || framesSinceKeyframe >= keyframeInterval;
+    if (isKeyframe) {
+        keyframeState.assign(state);
+        framesSinceKeyframe = 0;
+    }
+
+    Frame& frame = frames[head];
+    frame.offset = offset;
+    frame.isKeyframe = isKeyframe;
+    frame.keyframe = isKeyframe ? head : frames[slot(0)].keyframe;
+    frame.length = encode(state, isKeyframe ? noReference : keyframeState, offset);
+
+    head = (head + 1) % frames.size();
+    count++;
+    writeOffset = offset + frame.length;
+    framesSinceKeyframe++;
+    return true;
+}
+
+bool RewindBuffer::pop(std::string& state) {
+    if (count == 0) return false;
+
+    const Frame& frame = frames[slot(0)];
+    if (frame.isKeyframe) {
+        decode(frame, noReference, state);
+    } else {
+        decode(frames[frame.keyframe], noReference, scratch);
+        decode(frame, scratch, state);
+    }
+
+    writeOffset = frame.offset;
+    head = slot(0);
+    count--;
+    // The next push starts a fresh keyframe so it never deltas against a popped state.
+    framesSinceKeyframe = keyframeInterval;
+    return true;
+}
+
+bool RewindBuffer::reserve(size_t length, size_t& offset) {
+    if (length > arena.size()) return false;
+
+    bool wrapped = false;
+    offset = writeOffset;
+    if (offset + length > arena.size()) {
+        offset = 0;
+        wrapped = true;
+    }
+
+    while (count > 0) {
+        const Frame& oldest = frames[slot(count - 1)];
+        bool overlaps = oldest.offset < offset + length && offset < oldest.offset + oldest.length;
+        bool skippedTail = wrapped && oldest.offset >= writeOffset;
+        if (!overlaps && !skippedTail && count < frames.size()) break;
+        dropOldest();
+    }
+    return true;
+}
+
+void RewindBuffer::dropOldest() {
+    count--;
+    while (count > 0 && !frames[slot(count - 1)].isKeyframe) count--;
+}
+
+size_t RewindBuffer::encode(const std::string& state, const std::string& reference, size_t offset) {
+    unsigned char* out = arena.data() + offset;
+    const unsigned char* raw = reinterpret_cast<const unsigned char*>(state.data());
+    const unsigned char* ref = reinterpret_cast<const unsigned char*>(reference.data());
+    size_t n = state.size();
+    size_t refLength = reference.size();
+    auto diff = [&](size_t i) -> unsigned char { return i < refLength ? raw[i] ^ ref[i] : raw[i]; };
+
+    uint32_t rawLength = static_cast<uint32_t>(n);
+    std::memcpy(out, &rawLength, sizeof(rawLength));
+    size_t pos = sizeof(rawLength);
+
+    size_t i = 0;
+    while (i < n) {
+        size_t zeroStart = i;
+        while (i < n && i - zeroStart < MAX_RUN && diff(i) == 0) ++i;
+        size_t zeroRun = i - zeroStart;
+
+        // Zero runs shorter than MIN_ZERO_RUN stay inside the literal; a new chunk
+        // header would cost more than it saves.
+        size_t literalStart = i;
+        while (i < n) {
+            if (diff(i) != 0) {
+                if (i - literalStart >= MAX_RUN) break;
+                ++i;
+                continue;
+            }
+            size_t z = i;
+            while (z < n && z - i < MIN_ZERO_RUN && diff(z) == 0) ++z;
+            if (z - i >= MIN_ZERO_RUN || z == n || z - literalStart > MAX_RUN) break;
+            i = z;
+        }
+        size_t literalLength = i - literalStart;
+
+        putU16(out + pos, zeroRun);
+        putU16(out + pos + 2, literalLength);
+        pos += 4;
+        for (size_t k = 0; k < literalLength; ++k) out[pos + k] = diff(literalStart + k);
+        pos += literalLength;
+    }
+    return pos;
+}
+
+void RewindBuffer::decode(const Frame& frame, const std::string& reference, std::string& out) const {
+    const unsigned char* in = arena.data() + frame.offset;
+    const unsigned char* end = in + frame.length;
+    uint32_t rawLength = 0;
+    std::memcpy(&rawLength, in, sizeof(rawLength));
+    in += sizeof(rawLength);
+
+    out.resize(rawLength);
+    size_t refLength = reference.size();
+    auto base = [&](size_t i) -> char { return i < refLength ? reference[i] : 0; };
+
+    size_t pos = 0;
+    while (in < end && pos < rawLength) {
+        size_t zeroRun = getU16(in);
+        size_t literalLength = getU16(in + 2);
+        in += 4;
+        for (size_t k = 0; k < zeroRun && pos < rawLength; ++k, ++pos) out[pos] = base(pos);
+        for (size_t k = 0; k < literalLength && pos < rawLength; ++k, ++pos) out[pos] = static_cast<char>(in[k] ^ static_cast<unsigned char>(base(pos)));
+        in += literalLength;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef REWIND_H
+#define REWIND_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Fixed-memory history of serialized game states for practice mode.
+// Every keyframeInterval-th frame is a keyframe; the others are stored as the
+// XOR against their keyframe with zero runs squeezed out, so a frame decodes
+// from at most two entries. Frames live in one byte arena that is reused as a
+// ring: when it is full the oldest keyframe and its deltas are dropped.
+class RewindBuffer {
+public:
+    RewindBuffer(size_t arenaBytes, size_t maxFrames, int keyframeInterval);
+
+    void clear();
+    bool push(const std::string& state);
+    bool pop(std::string& state);
+
+    size_t frameCount() const { return count; }
+    size_t bytesUsed() const;
+    size_t capacityBytes() const { return arena.size(); }
+
+private:
+    struct Frame {
+        size_t offset;
+        size_t length;
+        size_t keyframe;
+        bool isKeyframe;
+    };
+
+    size_t encode(const std::string& state, const std::string& reference, size_t offset);
+    void decode(const Frame& frame, const std::string& reference, std::string& out) const;
+    bool reserve(size_t length, size_t& offset);
+    void dropOldest();
+    size_t slot(size_t age) const { return (head + frames.size() - 1 - age) % frames.size(); }
+
+    std::vector<unsigned char> arena;
+    std::vector<Frame> frames;
+    size_t head;
+    size_t count;
+    size_t writeOffset;
+    int keyframeInterval;
+    int framesSinceKeyframe;
+    std::string keyframeState;
+    std::string scratch;
+    const std::string noReference;
+};
+
+#endif
@@ -0,0 +1,277 @@
+#include "runlog.h"
+#include "playerdata.h"
+#include "config.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <cstring>
+
+namespace {
+
+constexpr char RUN_LOG_MAGIC[4] = {'S', 'S', 'R', 'L'};
+constexpr char RUN_INDEX_MAGIC[4] = {'S', 'S', 'R', 'I'};
+constexpr uint16_t RUN_LOG_VERSION = 1;
+constexpr size_t RUN_LOG_HEADER_SIZE = 16;
+constexpr size_t RUN_RECORD_SIZE = 32;
+constexpr size_t RUN_INDEX_HEADER_SIZE = 20;
+constexpr size_t RUN_INDEX_ENTRY_SIZE = 16;
+
+void putU16(std::string& out, uint16_t v) {
+    out.push_back(static_cast<char>(v & 0xFF));
+    out.push_back(static_cast<char>((v >> 8) & 0xFF));
+}
+
+void putU32(std::string& out, uint32_t v) {
+    for (int i = 0; i < 4; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+void putU64(std::string& out, uint64_t v) {
+    for (int i = 0; i < 8; ++i) out.push_back(static_cast<char>((v >> (8 * i)) & 0xFF));
+}
+
+uint16_t getU16(const char* in) {
+    return static_cast<uint16_t>(static_cast<uint8_t>(in[0]) | (static_cast<uint8_t>(in[1]) << 8));
+}
+
+uint32_t getU32(const char* in) {
+    uint32_t v = 0;
+    for (int i = 0; i < 4; ++i) v |= static_cast<uint32_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    return v;
+}
+
+uint64_t getU64(const char* in) {
+    uint64_t v = 0;
+    for (int i = 0; i < 8; ++i) v |= static_cast<uint64_t>(static_cast<uint8_t>(in[i])) << (8 * i);
+    return v;
+}
+
+std::string encodeLogHeader() {
+    std::string out(RUN_LOG_MAGIC, sizeof(RUN_LOG_MAGIC));
+    putU16(out, RUN_LOG_VERSION);
+    putU16(out, static_cast<uint16_t>(RUN_RECORD_SIZE));
+    putU32(out, 0);
+    putU32(out, 0);
+    return out;
+}
+
+bool isValidLogHeader(const std::string& bytes) {
+    return bytes.size() >= RUN_LOG_HEADER_SIZE &&
+           std::memcmp(bytes.data(), RUN_LOG_MAGIC, sizeof(RUN_LOG_MAGIC)) == 0 &&
+           getU16(bytes.data() + 4) == RUN_LOG_VERSION &&
+           getU16(bytes.data() + 6) == RUN_RECORD_SIZE;
+}
+
+std::string encodeRecord(const RunRecord& r) {
+    std::string out;
+    out.reserve(RUN_RECORD_SIZE);
+    putU64(out, static_cast<uint64_t>(r.timestamp));
+    putU32(out, r.seed);
+    putU32(out, static_cast<uint32_t>(r.score));
+    putU32(out, static_cast<uint32_t>(r.wave));
+    putU32(out, r.durationMs);
+    putU32(out, r.missilesBlocked);
+    putU32(out, crc32(out.data(), out.size()));
+    return out;
+}
+
+bool decodeRecord(const char* in, RunRecord& r) {
+    if (crc32(in, RUN_RECORD_SIZE - 4) != getU32(in + RUN_RECORD_SIZE - 4)) return false;
+    r.timestamp = static_cast<int64_t>(getU64(in));
+    r.seed = getU32(in + 8);
+    r.score = static_cast<int32_t>(getU32(in + 12));
+    r.wave = static_cast<int32_t>(getU32(in + 16));
+    r.durationMs = getU32(in + 20);
+    r.missilesBlocked = getU32(in + 24);
+    return true;
+}
+
+}
+
+RunLog::RunLog(PersistenceWorker& worker)
+    : persistence(worker), indexDirty(false) {}
+
+void RunLog::open(const std::string& logFile, const std::string& indexFile) {
+    logPath = logFile;
+    indexPath = indexFile;
+    index.clear();
+    records.clear();
+    indexDirty = false;
+
+    std::ifstream file(logPath, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        persistence.submit(logPath, encodeLogHeader());
+        writeIndex();
+        return;
+    }
+
+    std::streamoff size = file.tellg();
+    file.seekg(0);
+    std::string header(RUN_LOG_HEADER_SIZE, '\0');
+    if (size < static_cast<std::streamoff>(RUN_LOG_HEADER_SIZE) || !file.read(&header[0], header.size()) || !isValidLogHeader(header)) {
+        std::cerr << "Run log " << logPath << " has an unknown format. Starting a new log." << std::endl;
+        persistence.submit(logPath, encodeLogHeader());
+        writeIndex();
+        return;
+    }
+    file.close();
+
+    bool tornTail = (static_cast<size_t>(size) - RUN_LOG_HEADER_SIZE) % RUN_RECORD_SIZE != 0;
+    records = readAllRecords();
+    if (tornTail || records.size() > RUN_LOG_COMPACT_THRESHOLD) {
+        compact();
+    } else if (!loadIndex(static_cast<uint32_t>(records.size()))) {
+        rebuildIndex();
+        writeIndex();
+    }
+}
+
+void RunLog::append(const RunRecord& record) {
+    if (logPath.empty()) return;
+
+    uint32_t recordNumber = static_cast<uint32_t>(records.size());
+    records.push_back(record);
+    persistence.append(logPath, encodeRecord(record));
+
+    if (records.size() > RUN_LOG_COMPACT_THRESHOLD) {
+        compact();
+        return;
+    }
+
+    IndexEntry entry = {record.score, recordNumber, record.timestamp};
+    auto pos = std::upper_bound(index.begin(), index.end(), entry, ranksBefore);
+    index.insert(pos, entry);
+    indexDirty = true;
+}
+
+void RunLog::close() {
+    if (indexDirty) writeIndex();
+}
+
+bool RunLog::ranksBefore(const IndexEntry& a, const IndexEntry& b) {
+    if (a.score != b.score) return a.score > b.score;
+    if (a.timestamp != b.timestamp) return a.timestamp > b.timestamp;
+    return a.recordNumber > b.recordNumber;
+}
+
+std::vector<RunRecord> RunLog::topRuns(size_t count) const {
+    return topRunsSince(INT64_MIN, count);
+}
+
+std::vector<RunRecord> RunLog::topRunsSince(int64_t since, size_t count) const {
+    std::vector<RunRecord> result;
+    for (const IndexEntry& entry : index) {
+        if (result.size() >= count) break;
+        if (entry.timestamp < since) continue;
+        result.push_back(records[entry.recordNumber]);
+    }
+    return result;
+}
+
+std::vector<RunRecord> RunLog::readAllRecords() const {
+    std::vector<RunRecord> loaded;
+    std::ifstream file(logPath, std::ios::binary);
+    if (!file.is_open()) return loaded;
+
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (!isValidLogHeader(bytes)) return loaded;
+
+    size_t count = (bytes.size() - RUN_LOG_HEADER_SIZE) / RUN_RECORD_SIZE;
+    loaded.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        RunRecord record;
+        if (decodeRecord(bytes.data() + RUN_LOG_HEADER_SIZE + i * RUN_RECORD_SIZE, record)) {
+            loaded.push_back(record);
+        } else {
+            // Unreadable records keep their slot so record numbers match file
+            // positions; rebuildIndex leaves them out.
+            loaded.push_back(RunRecord{0, 0, 0, 0, 0, 0});
+        }
+    }
+    return loaded;
+}
+
+void RunLog::rebuildIndex() {
+    index.clear();
+    index.reserve(records.size());
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (records[i].timestamp == 0) continue;
+        index.push_back({records[i].score, static_cast<uint32_t>(i), records[i].timestamp});
+    }
+    std::stable_sort(index.begin(), index.end(), ranksBefore);
+}
+
+bool RunLog::loadIndex(uint32_t expectedCount) {
+    std::ifstream file(indexPath, std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::string bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (bytes.size() < RUN_INDEX_HEADER_SIZE) return false;
+    if (std::memcmp(bytes.data(), RUN_INDEX_MAGIC, sizeof(RUN_INDEX_MAGIC)) != 0) return false;
+    if (getU16(bytes.data() + 4) != RUN_LOG_VERSION || getU16(bytes.data() + 6) != RUN_INDEX_ENTRY_SIZE) return false;
+
+    size_t count = getU32(bytes.data() + 8);
+    // An index written before the last append reached the log is rebuilt instead.
+    if (getU32(bytes.data() + 12) != expectedCount) return false;
+    if (bytes.size() != RUN_INDEX_HEADER_SIZE + count * RUN_INDEX_ENTRY_SIZE) return false;
+    if (crc32(bytes.data() + RUN_INDEX_HEADER_SIZE, count * RUN_INDEX_ENTRY_SIZE) != getU32(bytes.data() + 16)) return false;
+
+    std::vector<IndexEntry> loaded;
+    loaded.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        const char* p = bytes.data() + RUN_INDEX_HEADER_SIZE + i * RUN_INDEX_ENTRY_SIZE;
+        IndexEntry entry = {static_cast<int32_t>(getU32(p)), getU32(p + 4), static_cast<int64_t>(getU64(p + 8))};
+        if (entry.recordNumber >= expectedCount) return false;
+        loaded.push_back(entry);
+    }
+
+    index.swap(loaded);
+    return true;
+}
+
+void RunLog::writeIndex() {
+    std::string entries;
+    entries.reserve(index.size() * RUN_INDEX_ENTRY_SIZE);
+    for (const IndexEntry& entry : index) {
+        putU32(entries, static_cast<uint32_t>(entry.score));
+        putU32(entries, entry.recordNumber);
+        putU64(entries, static_cast<uint64_t>(entry.timestamp));
+    }
+
+    std::string out(RUN_INDEX_MAGIC, sizeof(RUN_INDEX_MAGIC));
+    putU16(out, RUN_LOG_VERSION);
+    putU16(out, static_cast<uint16_t>(RUN_INDEX_ENTRY_SIZE));
+    putU32(out, static_cast<uint32_t>(index.size()));
+    putU32(out, static_cast<uint32_t>(records.size()));
+    putU32(out, crc32(entries.data(), entries.size()));
+    out += entries;
+    persistence.submit(indexPath, std::move(out));
+    indexDirty = false;
+}
+
+void RunLog::compact() {
+    std::vector<size_t> byScore;
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (records[i].timestamp != 0) byScore.push_back(i);
+    }
+    std::vector<bool> keep(records.size(), false);
+    size_t recentStart = byScore.size() > RUN_LOG_KEEP_RECENT ? byScore.size() - RUN_LOG_KEEP_RECENT : 0;
+    for (size_t i = recentStart; i < byScore.size(); ++i) keep[byScore[i]] = true;
+
+    std::stable_sort(byScore.begin(), byScore.end(), [&](size_t a, size_t b) { return records[a].score > records[b].score; });
+    for (size_t i = 0; i < byScore.size() && i < RUN_LOG_KEEP_TOP; ++i) keep[byScore[i]] = true;
+
+    std::vector<RunRecord> kept;
+    std::string log = encodeLogHeader();
+    for (size_t i = 0; i < records.size(); ++i) {
+        if (!keep[i]) continue;
+        kept.push_back(records[i]);
+        log += encodeRecord(records[i]);
+    }
+    std::cout << "Compacted run log " << logPath << " from " << records.size() << " to " << kept.size() << " records." << std::endl;
+
+    records.swap(kept);
+    persistence.submit(logPath, std::move(log));
+    rebuildIndex();
+    writeIndex();
+}
@@ -0,0 +1,69 @@
+#ifndef RUNLOG_H
+#define RUNLOG_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "persistence.h"
+
+struct RunRecord {
+    int64_t timestamp;
+    uint32_t seed;
+    int32_t score;
+    int32_t wave;
+    uint32_t durationMs;
+    uint32_t missilesBlocked;
+};
+
+// Append-only history of finished runs plus a score-sorted index.
+//   runs.log  "SSRL" | u16 version | u16 record size | u32 reserved | u32 reserved
+//             then fixed records: i64 timestamp | u32 seed | i32 score | i32 wave
+//             | u32 duration ms | u32 missiles blocked | u32 crc32(first 28 bytes)
+//   runs.idx  "SSRI" | u16 version | u16 entry size | u32 entry count | u32 log record count
+//             | u32 crc32(entries)
+//             then entries sorted by score (desc), newest first on ties:
+//             i32 score | u32 record number | i64 timestamp
+// Both are read into memory on open, so play never reads either file; a run
+// is appended to the log as it ends. The index is only rewritten on open,
+// compaction and close, and a stale or missing one is rebuilt from the log.
+// The log is compacted on open or append once it grows past
+// RUN_LOG_COMPACT_THRESHOLD records.
+class RunLog {
+public:
+    explicit RunLog(PersistenceWorker& worker);
+
+    void open(const std::string& logPath, const std::string& indexPath);
+    void append(const RunRecord& record);
+    // Writes the index if runs were added since it was last written.
+    void close();
+
+    std::vector<RunRecord> topRuns(size_t count) const;
+    std::vector<RunRecord> topRunsSince(int64_t since, size_t count) const;
+    size_t size() const { return index.size(); }
+
+private:
+    struct IndexEntry {
+        int32_t score;
+        uint32_t recordNumber;
+        int64_t timestamp;
+    };
+
+    static bool ranksBefore(const IndexEntry& a, const IndexEntry& b);
+
+    std::vector<RunRecord> readAllRecords() const;
+    void rebuildIndex();
+    bool loadIndex(uint32_t expectedCount);
+    void writeIndex();
+    void compact();
+
+    PersistenceWorker& persistence;
+    std::string logPath;
+    std::string indexPath;
+    std::vector<IndexEntry> index;
+    // Every record in the log, by record number.
+    std::vector<RunRecord> records;
+    bool indexDirty;
+};
+
+#endif
@@ -0,0 +1,261 @@
+#include "simulate.h"
+#include "game.h"
+#include "autopilot.h"
+#include "config.h"
+#include "jobsystem.h"
+#include "wavescript.h"
+#include <SDL2/SDL.h>
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+
+enum class SimPlayer { Still, Sweep, Bot };
+
+struct SimulationOptions {
+    size_t runs = SIMULATE_RUNS;
+    std::vector<std::string> scripts;
+    Uint32 seed = 1;
+    SimPlayer player = SimPlayer::Bot;
+    AutopilotSkill skill;
+    float maxSeconds = SIMULATE_MAX_SECONDS;
+    float tickMs = SIMULATE_TICK_MS;
+    unsigned threads = 0;
+    bool fixedPoint = false;
+    std::string out;
+};
+
+struct RunResult {
+    Uint32 seed;
+    Uint32 survivedMs;
+    int score;
+    int wave;
+    int blocked;
+    bool censored;
+    uint32_t checksum;
+};
+
+struct ParameterSet {
+    std::string path;
+    WaveScript script;
+    std::vector<RunResult> results;
+};
+
+const char* playerName(SimPlayer player) {
+    switch (player) {
+        case SimPlayer::Still: return "still";
+        case SimPlayer::Sweep: return "sweep";
+        case SimPlayer::Bot: break;
+    }
+    return "bot";
+}
+
+bool parseOptions(int argc, char* argv[], SimulationOptions& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--fixed-point") {
+            options.fixedPoint = true;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            std::cerr << "simulate: " << arg << " needs a value" << std::endl;
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--simulate") options.runs = std::strtoul(value.c_str(), nullptr, 10);
+        else if (arg == "--script") options.scripts.push_back(value);
+        else if (arg == "--seed") options.seed = static_cast<Uint32>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--max-seconds") options.maxSeconds = std::strtof(value.c_str(), nullptr);
+        else if (arg == "--tick-ms") options.tickMs = std::strtof(value.c_str(), nullptr);
+        else if (arg == "--threads") options.threads = static_cast<unsigned>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--out") options.out = value;
+        else if (arg == "--reaction-ms") options.skill.reactionMs = static_cast<Uint32>(std::strtoul(value.c_str(), nullptr, 10));
+        else if (arg == "--aim-noise") options.skill.aimNoise = std::strtof(value.c_str(), nullptr);
+        else if (arg == "--player" && value == "still") options.player = SimPlayer::Still;
+        else if (arg == "--player" && value == "sweep") options.player = SimPlayer::Sweep;
+        else if (arg == "--player" && value == "bot") options.player = SimPlayer::Bot;
+        else {
+            std::cerr << "simulate: cannot use " << arg << " " << value << std::endl;
+            return false;
+        }
+    }
+    if (options.runs == 0 || !(options.maxSeconds > 0.0f) || !(options.tickMs > 0.0f)) {
+        std::cerr << "simulate: runs, --max-seconds and --tick-ms must be positive" << std::endl;
+        return false;
+    }
+    if (options.scripts.empty()) options.scripts.push_back(WAVE_SCRIPT_FILE);
+    return true;
+}
+
+// The scripted players only hold the shield still or keep it turning
+// clockwise; the bot steers every tick. All play at the default sensitivity.
+RunResult playRun(Game& game, Autopilot& pilot, const ParameterSet& set, Uint32 seed, const SimulationOptions& options) {
+    game.reset();
+    game.setFixedPoint(options.fixedPoint);
+    game.setWaveScript(set.script);
+    game.startGame(seed);
+    pilot.reset(seed);
+    game.setShieldTurn(options.player == SimPlayer::Sweep ? 1 : 0);
+    Uint32 limit = static_cast<Uint32>(options.maxSeconds * 1000.0f);
+    float deltaTime = options.tickMs / 1000.0f;
+    while (!game.isGameOver() && game.getElapsedTime() < limit) {
+        if (options.player == SimPlayer::Bot) game.setShieldTurn(pilot.decide(game, deltaTime));
+        game.update(deltaTime);
+    }
+    return RunResult{seed, game.getElapsedTime(), game.getScore(), game.getWaveCount(), game.getMissilesBlocked(), !game.isGameOver(),
+                     game.stateChecksum()};
+}
+
+// Nearest-rank percentile of a sorted list.
+template <typename T>
+T percentile(const std::vector<T>& sorted, int p) {
+    size_t rank = (sorted.size() * p + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+template <typename T>
+void writeStats(std::ostream& out, std::vector<T> values) {
+    std::sort(values.begin(), values.end());
+    double sum = 0.0;
+    for (T v : values) sum += v;
+    out << "\"mean\": " << sum / values.size() << ", \"p10\": " << percentile(values, 10) << ", \"p50\": " << percentile(values, 50)
+        << ", \"p90\": " << percentile(values, 90) << ", \"max\": " << values.back();
+}
+
+std::string jsonString(const std::string& text) {
+    std::string quoted = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') quoted += '\\';
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+std::vector<double> survivalSeconds(const ParameterSet& set) {
+    std::vector<double> seconds;
+    for (const RunResult& r : set.results) seconds.push_back(r.survivedMs / 1000.0);
+    return seconds;
+}
+
+std::vector<int> scores(const ParameterSet& set) {
+    std::vector<int> values;
+    for (const RunResult& r : set.results) values.push_back(r.score);
+    return values;
+}
+
+bool writeCsv(const std::string& path, const std::vector<ParameterSet>& sets) {
+    std::ofstream file(path);
+    file << "script,seed,survival_s,score,wave,blocked,censored,checksum\n";
+    file << std::fixed << std::setprecision(3);
+    for (const ParameterSet& set : sets) {
+        for (const RunResult& r : set.results) {
+            file << set.path << ',' << r.seed << ',' << r.survivedMs / 1000.0 << ',' << r.score << ',' << r.wave << ','
+                 << r.blocked << ',' << (r.censored ? 1 : 0) << ',' << r.checksum << '\n';
+        }
+    }
+    return static_cast<bool>(file);
+}
+
+bool writeJson(const std::string& path, const std::vector<ParameterSet>& sets, const SimulationOptions& options) {
+    std::ofstream file(path);
+    file << std::fixed << std::setprecision(3);
+    file << "{\n  \"player\": \"" << playerName(options.player) << "\", \"reaction_ms\": " << options.skill.reactionMs
+         << ", \"aim_noise\": " << options.skill.aimNoise << ", \"tick_ms\": " << options.tickMs
+         << ", \"max_seconds\": " << options.maxSeconds << ", \"first_seed\": " << options.seed
+         << ", \"fixed_point\": " << (options.fixedPoint ? "true" : "false") << ",\n  \"sets\": [\n";
+    for (size_t s = 0; s < sets.size(); ++s) {
+        const ParameterSet& set = sets[s];
+        size_t censored = std::count_if(set.results.begin(), set.results.end(), [](const RunResult& r) { return r.censored; });
+        file << "    {\"script\": " << jsonString(set.path) << ", \"runs\": " << set.results.size() << ", \"censored\": " << censored << ",\n";
+        file << "     \"survival_s\": {";
+        writeStats(file, survivalSeconds(set));
+        file << "},\n     \"score\": {";
+        writeStats(file, scores(set));
+        file << "},\n     \"runs_survival_s\": [";
+        for (size_t i = 0; i < set.results.size(); ++i) file << (i ? ", " : "") << set.results[i].survivedMs / 1000.0;
+        file << "],\n     \"runs_score\": [";
+        for (size_t i = 0; i < set.results.size(); ++i) file << (i ? ", " : "") << set.results[i].score;
+        file << "]}" << (s + 1 < sets.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return static_cast<bool>(file);
+}
+
+void printSummary(const std::vector<ParameterSet>& sets) {
+    std::cout << std::fixed << std::setprecision(1);
+    for (const ParameterSet& set : sets) {
+        std::vector<double> seconds = survivalSeconds(set);
+        std::vector<int> points = scores(set);
+        std::sort(seconds.begin(), seconds.end());
+        std::sort(points.begin(), points.end());
+        size_t censored = std::count_if(set.results.begin(), set.results.end(), [](const RunResult& r) { return r.censored; });
+        std::cout << set.path << ": " << set.results.size() << " runs, " << censored << " reached the time limit" << std::endl;
+        std::cout << "  survival s  p10 " << std::setw(8) << percentile(seconds, 10) << "  p50 " << std::setw(8) << percentile(seconds, 50)
+                  << "  p90 " << std::setw(8) << percentile(seconds, 90) << std::endl;
+        std::cout << "  score       p10 " << std::setw(8) << percentile(points, 10) << "  p50 " << std::setw(8) << percentile(points, 50)
+                  << "  p90 " << std::setw(8) << percentile(points, 90) << std::endl;
+    }
+}
+
+}
+
+int runSimulation(int argc, char* argv[]) {
+    SimulationOptions options;
+    if (!parseOptions(argc, argv, options)) return 1;
+
+    std::vector<ParameterSet> sets(options.scripts.size());
+    for (size_t s = 0; s < sets.size(); ++s) {
+        sets[s].path = options.scripts[s];
+        if (!sets[s].script.load(sets[s].path)) {
+            std::cerr << "simulate: wave script " << sets[s].path << " could not be used" << std::endl;
+            return 1;
+        }
+        sets[s].results.resize(options.runs);
+    }
+
+    // One game per chunk of runs, reset between them; every run writes
+    // only its own result slot.
+    size_t total = sets.size() * options.runs;
+    auto simulate = [&](size_t begin, size_t end) {
+        Game game(nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr);
+        Autopilot pilot(options.skill);
+        for (size_t i = begin; i < end; ++i) {
+            ParameterSet& set = sets[i / options.runs];
+            Uint32 seed = options.seed + static_cast<Uint32>(i % options.runs);
+            set.results[i % options.runs] = playRun(game, pilot, set, seed, options);
+        }
+    };
+    Uint64 start = SDL_GetPerformanceCounter();
+    unsigned threads = 1;
+    if (options.threads == 1) {
+        simulate(0, total);
+    } else {
+        JobSystem jobs(options.threads > 1 ? options.threads - 1 : 0);
+        threads = jobs.workerCount() + 1;
+        jobs.parallelFor(total, 1, simulate);
+    }
+    double wallSeconds = static_cast<double>(SDL_GetPerformanceCounter() - start) / static_cast<double>(SDL_GetPerformanceFrequency());
+
+    double simulatedSeconds = 0.0;
+    for (const ParameterSet& set : sets) {
+        for (const RunResult& r : set.results) simulatedSeconds += r.survivedMs / 1000.0;
+    }
+    printSummary(sets);
+    std::cout << total << " runs on " << threads << " threads in " << std::setprecision(2) << wallSeconds << " s, "
+              << std::setprecision(0) << simulatedSeconds / std::max(wallSeconds, 1e-9) * 60.0 << " simulated s per minute" << std::endl;
+
+    if (options.out.empty()) return 0;
+    bool json = options.out.size() >= 5 && options.out.compare(options.out.size() - 5, 5, ".json") == 0;
+    if (!(json ? writeJson(options.out, sets, options) : writeCsv(options.out, sets))) {
+        std::cerr << "simulate: could not write " << options.out << std::endl;
+        return 1;
+    }
+    std::cout << "Results written to " << options.out << std::endl;
+    return 0;
+}
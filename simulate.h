@@ -0,0 +1,20 @@
+#ifndef SIMULATE_H
+#define SIMULATE_H
+
+// Headless Monte Carlo runs for tuning the difficulty curve:
+//
+//   spaceshield --simulate <runs> [--script <waves.txt>]... [--seed <n>]
+//               [--player bot|still|sweep] [--reaction-ms <ms>] [--aim-noise <rad>]
+//               [--max-seconds <s>] [--tick-ms <ms>] [--fixed-point]
+//               [--threads <n>] [--out <results.csv|results.json>]
+//
+// Every wave script is one parameter set and plays the same seeds, so sets
+// differ only by their rules. Runs are spread over all cores; a summary of
+// survival time and score per set goes to stdout and each run to --out,
+// with a checksum of its end state. With --fixed-point and the still or
+// sweep player those checksums match across builds and machines; the bot
+// steers with float maths, so its runs may not.
+// Returns the process exit code.
+int runSimulation(int argc, char* argv[]);
+
+#endif
@@ -0,0 +1,78 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <type_traits>
+
+// Raw little helpers for Game::captureSnapshot / Game::restoreSnapshot. Values
+// are copied byte for byte, so snapshots are only meant to be read back by
+// the same build; the header carries a layout tag to reject anything else.
+//   header "SSGS" | u16 version | u16 header size | u32 layout tag | u32 payload size | u32 crc32(payload)
+constexpr char GAME_SNAPSHOT_MAGIC[4] = {'S', 'S', 'G', 'S'};
+constexpr uint16_t GAME_SNAPSHOT_VERSION = 8;
+constexpr size_t GAME_SNAPSHOT_HEADER_SIZE = 20;
+
+class SnapshotWriter {
+public:
+    // Reuses the capacity of out; nothing is allocated once it is large enough.
+    explicit SnapshotWriter(std::string& out) : buffer(out) { buffer.clear(); }
+
+    template <typename T>
+    void put(const T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be trivially copyable");
+        buffer.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    void putVector(const std::vector<T>& values) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be trivially copyable");
+        put(static_cast<uint32_t>(values.size()));
+        if (!values.empty()) buffer.append(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+    }
+
+    size_t size() const { return buffer.size(); }
+    void patch(size_t offset, const void* data, size_t length) { std::memcpy(&buffer[offset], data, length); }
+    const char* data() const { return buffer.data(); }
+
+private:
+    std::string& buffer;
+};
+
+class SnapshotReader {
+public:
+    SnapshotReader(const char* data, size_t length) : cursor(data), end(data + length), failed(false) {}
+
+    template <typename T>
+    bool get(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "snapshot fields must be trivially copyable");
+        if (failed || static_cast<size_t>(end - cursor) < sizeof(T)) { failed = true; return false; }
+        std::memcpy(&value, cursor, sizeof(T));
+        cursor += sizeof(T);
+        return true;
+    }
+
+    // Fills values without shrinking its capacity; maxCount bounds corrupt input.
+    template <typename T>
+    bool getVector(std::vector<T>& values, uint32_t maxCount) {
+        uint32_t count = 0;
+        if (!get(count) || count > maxCount || static_cast<size_t>(end - cursor) < count * sizeof(T)) { failed = true; return false; }
+        values.resize(count);
+        if (count > 0) std::memcpy(values.data(), cursor, count * sizeof(T));
+        cursor += count * sizeof(T);
+        return true;
+    }
+
+    bool ok() const { return !failed; }
+    bool atEnd() const { return cursor == end; }
+
+private:
+    const char* cursor;
+    const char* end;
+    bool failed;
+};
+
+#endif
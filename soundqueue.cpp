@@ -0,0 +1,24 @@
+#include "soundqueue.h"
+
+SoundQueue::SoundQueue() : slots(), head(0), tail(0) {}
+
+bool SoundQueue::push(const SoundEvent& event) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if (t - head.load(std::memory_order_acquire) == SOUND_QUEUE_CAPACITY) return false;
+    slots[t & (SOUND_QUEUE_CAPACITY - 1)] = event;
+    tail.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+bool SoundQueue::pop(SoundEvent& event) {
+    size_t h = head.load(std::memory_order_relaxed);
+    if (h == tail.load(std::memory_order_acquire)) return false;
+    event = slots[h & (SOUND_QUEUE_CAPACITY - 1)];
+    head.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+// Only valid while the consumer is stopped.
+void SoundQueue::clear() {
+    head.store(tail.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
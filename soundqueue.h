@@ -0,0 +1,45 @@
+#ifndef SOUNDQUEUE_H
+#define SOUNDQUEUE_H
+
+#include <SDL2/SDL_mixer.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "config.h"
+
+enum class SoundType : uint8_t {
+    ShieldHit,
+    PlayerHit,
+    HealCollect,
+    ButtonClick,
+    GameOver,
+    WarningStart,
+    WarningStop,
+    StopAll,
+    Count
+};
+
+struct SoundEvent {
+    SoundType type;
+    Mix_Chunk* chunk;
+};
+
+// Single-producer/single-consumer ring. The game thread pushes, the sound
+// thread pops; neither side ever blocks. A full queue drops the new event.
+class SoundQueue {
+public:
+    SoundQueue();
+
+    bool push(const SoundEvent& event);
+    bool pop(SoundEvent& event);
+    void clear();
+
+private:
+    static_assert((SOUND_QUEUE_CAPACITY & (SOUND_QUEUE_CAPACITY - 1)) == 0, "SOUND_QUEUE_CAPACITY must be a power of two");
+
+    SoundEvent slots[SOUND_QUEUE_CAPACITY];
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+};
+
+#endif
@@ -0,0 +1,138 @@
+#include "spritemask.h"
+#include "config.h"
+#include "fastmath.h"
+#include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+namespace {
+
+SDL_Surface* loadRgbaSurface(const std::string& path) {
+    SDL_Surface* loaded = IMG_Load(path.c_str());
+    if (!loaded) {
+        std::cerr << "Unable to load collision mask " << path << "! SDL_image Error: " << IMG_GetError() << std::endl;
+        return nullptr;
+    }
+    SDL_Surface* rgba = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_RGBA32, 0);
+    if (rgba != loaded) SDL_FreeSurface(loaded);
+    if (!rgba) std::cerr << "Unable to convert collision mask " << path << "! SDL Error: " << SDL_GetError() << std::endl;
+    return rgba;
+}
+
+}
+
+void SpriteMask::build(SDL_Surface* rgba, int width, int height, SDL_Point pivot, float angle) {
+    words.clear();
+    if (!rgba || width <= 0 || height <= 0 || SDL_LockSurface(rgba) != 0) return;
+    if (!rgba->pixels) {
+        SDL_UnlockSurface(rgba);
+        return;
+    }
+
+    float s, c;
+    fastSinCos(angle, s, c);
+    float cornersX[4] = {0.0f, 1.0f * width, 0.0f, 1.0f * width};
+    float cornersY[4] = {0.0f, 0.0f, 1.0f * height, 1.0f * height};
+    float minX = 1e9f, minY = 1e9f, maxX = -1e9f, maxY = -1e9f;
+    for (int i = 0; i < 4; ++i) {
+        float x = cornersX[i] - pivot.x, y = cornersY[i] - pivot.y;
+        float rx = c * x - s * y, ry = s * x + c * y;
+        minX = std::min(minX, rx); maxX = std::max(maxX, rx);
+        minY = std::min(minY, ry); maxY = std::max(maxY, ry);
+    }
+    // Snap away float noise so an unrotated mask keeps the sprite's size.
+    int left = static_cast<int>(std::floor(minX + 1e-3f));
+    int top = static_cast<int>(std::floor(minY + 1e-3f));
+    int boxW = static_cast<int>(std::ceil(maxX - 1e-3f)) - left;
+    int boxH = static_cast<int>(std::ceil(maxY - 1e-3f)) - top;
+
+    std::vector<Uint8> covered(static_cast<size_t>(boxW) * boxH, 0);
+    int firstColumn = boxW, lastColumn = -1, firstRow = boxH, lastRow = -1;
+    const Uint8* pixels = static_cast<const Uint8*>(rgba->pixels);
+    for (int row = 0; row < boxH; ++row) {
+        for (int column = 0; column < boxW; ++column) {
+            float sx = left + column + 0.5f, sy = top + row + 0.5f;
+            float u = c * sx + s * sy + pivot.x, v = -s * sx + c * sy + pivot.y;
+            if (u < 0.0f || v < 0.0f || u >= width || v >= height) continue;
+            int px = std::min(static_cast<int>(u * rgba->w / width), rgba->w - 1);
+            int py = std::min(static_cast<int>(v * rgba->h / height), rgba->h - 1);
+            if (pixels[py * rgba->pitch + px * 4 + 3] < SPRITE_MASK_ALPHA_THRESHOLD) continue;
+            covered[static_cast<size_t>(row) * boxW + column] = 1;
+            firstColumn = std::min(firstColumn, column); lastColumn = std::max(lastColumn, column);
+            firstRow = std::min(firstRow, row); lastRow = std::max(lastRow, row);
+        }
+    }
+    SDL_UnlockSurface(rgba);
+
+    // Trimmed to the opaque pixels, so the bounding-box reject is as tight
+    // as the sprite; a fully transparent sprite keeps an empty mask.
+    offX = left + std::min(firstColumn, lastColumn + 1);
+    offY = top + std::min(firstRow, lastRow + 1);
+    w = std::max(0, lastColumn - firstColumn + 1);
+    h = std::max(0, lastRow - firstRow + 1);
+    wordsPerRow = (w + 63) / 64;
+    words.assign(std::max<size_t>(1, static_cast<size_t>(wordsPerRow) * h), 0);
+    for (int row = 0; row < h; ++row) {
+        for (int column = 0; column < w; ++column) {
+            if (covered[static_cast<size_t>(row + firstRow) * boxW + column + firstColumn]) {
+                words[static_cast<size_t>(row) * wordsPerRow + column / 64] |= uint64_t(1) << (column % 64);
+            }
+        }
+    }
+}
+
+// 64 bits of a row starting at column, zero wherever that runs off the mask.
+uint64_t SpriteMask::bitsAt(int row, int column) const {
+    if (column >= w || column <= -64) return 0;
+    const uint64_t* bits = &words[static_cast<size_t>(row) * wordsPerRow];
+    if (column < 0) return bits[0] << -column;
+    int word = column / 64, shift = column % 64;
+    uint64_t result = bits[word] >> shift;
+    if (shift != 0 && word + 1 < wordsPerRow) result |= bits[word + 1] << (64 - shift);
+    return result;
+}
+
+bool SpriteMask::overlaps(int x, int y, const SpriteMask& other, int otherX, int otherY) const {
+    if (!isLoaded() || !other.isLoaded()) return false;
+    int ax = x + offX, ay = y + offY;
+    int bx = otherX + other.offX, by = otherY + other.offY;
+    int top = std::max(ay, by), bottom = std::min(ay + h, by + other.h);
+    int left = std::max(ax, bx), right = std::min(ax + w, bx + other.w);
+    if (top >= bottom || left >= right) return false;
+
+    int firstWord = (left - ax) / 64, lastWord = (right - ax - 1) / 64;
+    for (int row = top; row < bottom; ++row) {
+        const uint64_t* bits = &words[static_cast<size_t>(row - ay) * wordsPerRow];
+        for (int word = firstWord; word <= lastWord; ++word) {
+            if (bits[word] & other.bitsAt(row - by, ax + word * 64 - bx)) return true;
+        }
+    }
+    return false;
+}
+
+bool RotatedSpriteMask::load(const std::string& path, int width, int height, SDL_Point pivot) {
+    masks.clear();
+    SDL_Surface* rgba = loadRgbaSurface(path);
+    if (!rgba) return false;
+    masks.resize(SPRITE_MASK_ANGLES);
+    for (int i = 0; i < SPRITE_MASK_ANGLES; ++i) {
+        masks[i].build(rgba, width, height, pivot, 2.0f * PI * i / SPRITE_MASK_ANGLES);
+    }
+    SDL_FreeSurface(rgba);
+    if (!masks[0].isLoaded()) masks.clear();
+    return isLoaded();
+}
+
+const SpriteMask& RotatedSpriteMask::at(float angle) const {
+    int index = static_cast<int>(wrapAngle(angle) * SPRITE_MASK_ANGLES / (2.0f * PI) + 0.5f);
+    return masks[index % SPRITE_MASK_ANGLES];
+}
+
+bool loadSpriteMask(const std::string& path, int width, int height, SpriteMask& mask) {
+    SDL_Surface* rgba = loadRgbaSurface(path);
+    if (!rgba) return false;
+    mask.build(rgba, width, height, SDL_Point{0, 0}, 0.0f);
+    SDL_FreeSurface(rgba);
+    return mask.isLoaded();
+}
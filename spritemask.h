@@ -0,0 +1,57 @@
+#ifndef SPRITEMASK_H
+#define SPRITEMASK_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One bit per screen pixel a sprite covers when drawn, set where its alpha
+// reaches SPRITE_MASK_ALPHA_THRESHOLD, packed 64 columns to a word per row.
+// The mask is built for the size and rotation the sprite is drawn at, and
+// offsetX/offsetY place its top-left corner relative to the point the
+// sprite is drawn around.
+class SpriteMask {
+public:
+    // Samples surface as if drawn width x height and rotated clockwise by
+    // angle radians about pivot, the way SDL_RenderCopyEx draws it.
+    void build(SDL_Surface* rgba, int width, int height, SDL_Point pivot, float angle);
+
+    bool isLoaded() const { return !words.empty(); }
+    int width() const { return w; }
+    int height() const { return h; }
+    int offsetX() const { return offX; }
+    int offsetY() const { return offY; }
+    bool isSet(int column, int row) const {
+        return column >= 0 && row >= 0 && column < w && row < h &&
+               ((words[static_cast<size_t>(row) * wordsPerRow + column / 64] >> (column % 64)) & 1) != 0;
+    }
+
+    // Whether any set pixel of this mask with its pivot at (x, y) meets one
+    // of other's with its pivot at (otherX, otherY).
+    bool overlaps(int x, int y, const SpriteMask& other, int otherX, int otherY) const;
+
+private:
+    uint64_t bitsAt(int row, int column) const;
+
+    int w = 0, h = 0;
+    int offX = 0, offY = 0;
+    int wordsPerRow = 0;
+    std::vector<uint64_t> words;
+};
+
+// A sprite that is drawn at any angle, masked at SPRITE_MASK_ANGLES evenly
+// spaced rotations; at() picks the nearest.
+class RotatedSpriteMask {
+public:
+    bool load(const std::string& path, int width, int height, SDL_Point pivot);
+    bool isLoaded() const { return !masks.empty(); }
+    const SpriteMask& at(float angle) const;
+
+private:
+    std::vector<SpriteMask> masks;
+};
+
+bool loadSpriteMask(const std::string& path, int width, int height, SpriteMask& mask);
+
+#endif
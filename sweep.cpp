@@ -0,0 +1,102 @@
+#include "sweep.h"
+#include "config.h"
+#include "fastmath.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+// Narrows [lo, hi] to the t where o + v * t >= 0.
+void clipHalfPlane(float o, float v, float& lo, float& hi) {
+    if (v == 0.0f) {
+        if (o < 0.0f) hi = -1.0f;
+        return;
+    }
+    float root = -o / v;
+    if (v > 0.0f) lo = std::max(lo, root);
+    else hi = std::min(hi, root);
+}
+
+// Where |p + t * d| = radius; a segment that does not move is either
+// inside for every t or never.
+bool circleCrossings(float px, float py, float dx, float dy, float radius, float& enter, float& leave) {
+    float a = dx * dx + dy * dy;
+    float c = px * px + py * py - radius * radius;
+    if (a == 0.0f) {
+        enter = -std::numeric_limits<float>::infinity();
+        leave = std::numeric_limits<float>::infinity();
+        return c <= 0.0f;
+    }
+    float halfB = px * dx + py * dy;
+    float disc = halfB * halfB - a * c;
+    if (disc < 0.0f) return false;
+    float root = std::sqrt(disc);
+    enter = (-halfB - root) / a;
+    leave = (-halfB + root) / a;
+    return true;
+}
+
+}
+
+bool sweepRect(float x0, float y0, float x1, float y1, float left, float top, float right, float bottom, float& t) {
+    float lo = 0.0f, hi = 1.0f;
+    float o[2] = {x0, y0}, v[2] = {x1 - x0, y1 - y0}, minEdge[2] = {left, top}, maxEdge[2] = {right, bottom};
+    for (int axis = 0; axis < 2; ++axis) {
+        if (v[axis] == 0.0f) {
+            if (o[axis] <= minEdge[axis] || o[axis] >= maxEdge[axis]) return false;
+            continue;
+        }
+        float a = (minEdge[axis] - o[axis]) / v[axis], b = (maxEdge[axis] - o[axis]) / v[axis];
+        lo = std::max(lo, std::min(a, b));
+        hi = std::min(hi, std::max(a, b));
+    }
+    if (lo >= hi) return false;
+    t = lo;
+    return true;
+}
+
+// The band is the outer disc minus the inner one; the arc is cut into
+// wedges of at most PI, each the intersection of two half-planes through
+// the centre. Every one of those is an interval of t along the segment.
+bool sweepArcBand(float x0, float y0, float x1, float y1, float cx, float cy, float innerRadius, float outerRadius,
+                  float arcStart, float arcLength, float& t) {
+    float px = x0 - cx, py = y0 - cy, dx = x1 - x0, dy = y1 - y0;
+    float lo = 0.0f, hi = 1.0f, enter, leave;
+    if (!circleCrossings(px, py, dx, dy, outerRadius, enter, leave)) return false;
+    lo = std::max(lo, enter);
+    hi = std::min(hi, leave);
+    if (lo > hi) return false;
+
+    float holeStart = 1.0f, holeEnd = 0.0f;
+    if (innerRadius > 0.0f && circleCrossings(px, py, dx, dy, innerRadius, enter, leave)) {
+        holeStart = enter;
+        holeEnd = leave;
+    }
+
+    bool found = false;
+    auto consider = [&](float first, float last) {
+        if (first > last) return;
+        if (first > holeStart && first < holeEnd) first = holeEnd;
+        if (first > last) return;
+        if (!found || first < t) t = first;
+        found = true;
+    };
+
+    if (arcLength >= 2.0f * PI) {
+        consider(lo, hi);
+        return found;
+    }
+    int wedges = std::max(1, static_cast<int>(std::ceil(arcLength / PI)));
+    float wedge = arcLength / wedges;
+    for (int i = 0; i < wedges; ++i) {
+        float startSin, startCos, endSin, endCos;
+        fastSinCos(arcStart + wedge * i, startSin, startCos);
+        fastSinCos(arcStart + wedge * (i + 1), endSin, endCos);
+        float first = lo, last = hi;
+        clipHalfPlane(startCos * py - startSin * px, startCos * dy - startSin * dx, first, last);
+        clipHalfPlane(px * endSin - py * endCos, dx * endSin - dy * endCos, first, last);
+        consider(first, last);
+    }
+    return found;
+}
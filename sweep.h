@@ -0,0 +1,18 @@
+#ifndef SWEEP_H
+#define SWEEP_H
+
+// Swept tests for a point that moved along the segment (x0, y0) -> (x1, y1)
+// during one tick. Each returns whether the point touched the shape at some
+// t in [0, 1] and, if so, sets t to the earliest such fraction, so a coarse
+// tick cannot step a projectile over a thin target.
+
+// Open rectangle (left, right) x (top, bottom), matching SDL_HasIntersection
+// for rects that must overlap by a pixel.
+bool sweepRect(float x0, float y0, float x1, float y1, float left, float top, float right, float bottom, float& t);
+
+// Band innerRadius <= r <= outerRadius around (cx, cy), limited to the arc
+// from arcStart through arcStart + arcLength (radians, arcLength >= 0).
+bool sweepArcBand(float x0, float y0, float x1, float y1, float cx, float cy, float innerRadius, float outerRadius,
+                  float arcStart, float arcLength, float& t);
+
+#endif
@@ -0,0 +1,120 @@
+#include "timerwheel.h"
+#include <algorithm>
+
+namespace {
+
+bool firesBefore(const TimerEvent& a, const TimerEvent& b) {
+    if (a.due != b.due) return static_cast<int32_t>(a.due - b.due) < 0;
+    return static_cast<int32_t>(a.sequence - b.sequence) < 0;
+}
+
+}
+
+TimerWheel::TimerWheel() : freeList(-1), current(0), sequence(0), count(0) {
+    nodes.reserve(TIMER_POOL_CAPACITY);
+    ready.reserve(TIMER_POOL_CAPACITY);
+    reset(0);
+}
+
+void TimerWheel::reset(uint32_t now) {
+    nodes.clear();
+    freeList = -1;
+    for (auto& level : slots) std::fill(std::begin(level), std::end(level), -1);
+    ready.clear();
+    current = now;
+    sequence = 0;
+    count = 0;
+}
+
+int32_t TimerWheel::allocateNode() {
+    if (freeList >= 0) {
+        int32_t index = freeList;
+        freeList = nodes[index].next;
+        return index;
+    }
+    nodes.push_back(Node{});
+    return static_cast<int32_t>(nodes.size() - 1);
+}
+
+void TimerWheel::schedule(uint32_t due, uint32_t kind, uint32_t target) {
+    TimerEvent event = {due, sequence++, kind, target};
+    if (static_cast<int32_t>(due - current) <= 0) ready.push_back(event);
+    else insert(event);
+}
+
+// Level L holds events less than SLOTS^(L+1) ms away, filed by bits
+// [L*SLOT_BITS, (L+1)*SLOT_BITS) of their due time. Anything further out
+// parks in the last slot of the top level and is filed again on cascade.
+void TimerWheel::insert(const TimerEvent& event) {
+    uint64_t delta = event.due - current;
+    int level = 0;
+    while (level < TIMER_WHEEL_LEVELS - 1 && delta >= (uint64_t(1) << (TIMER_WHEEL_SLOT_BITS * (level + 1)))) level++;
+
+    int shift = TIMER_WHEEL_SLOT_BITS * level;
+    uint32_t slot = event.due >> shift;
+    if (delta >= (uint64_t(1) << (shift + TIMER_WHEEL_SLOT_BITS))) slot = (current >> shift) + TIMER_WHEEL_SLOTS - 1;
+    slot &= TIMER_WHEEL_SLOTS - 1;
+
+    int32_t index = allocateNode();
+    nodes[index].event = event;
+    nodes[index].next = slots[level][slot];
+    slots[level][slot] = index;
+    count++;
+}
+
+void TimerWheel::cascade(int level) {
+    uint32_t slot = (current >> (TIMER_WHEEL_SLOT_BITS * level)) & (TIMER_WHEEL_SLOTS - 1);
+    int32_t index = slots[level][slot];
+    slots[level][slot] = -1;
+    while (index >= 0) {
+        int32_t next = nodes[index].next;
+        TimerEvent event = nodes[index].event;
+        nodes[index].next = freeList;
+        freeList = index;
+        count--;
+        if (event.due == current) ready.push_back(event);
+        else insert(event);
+        index = next;
+    }
+}
+
+void TimerWheel::advance(uint32_t now, std::vector<TimerEvent>& fired) {
+    size_t first = fired.size();
+    fired.insert(fired.end(), ready.begin(), ready.end());
+    ready.clear();
+
+    while (static_cast<int32_t>(now - current) > 0) {
+        if (count == 0) {
+            current = now;
+            break;
+        }
+        current++;
+        for (int level = TIMER_WHEEL_LEVELS - 1; level >= 0; --level) {
+            uint32_t lowBits = current & ((uint32_t(1) << (TIMER_WHEEL_SLOT_BITS * level)) - 1);
+            if (lowBits == 0) cascade(level);
+        }
+        fired.insert(fired.end(), ready.begin(), ready.end());
+        ready.clear();
+    }
+
+    std::sort(fired.begin() + first, fired.end(), firesBefore);
+}
+
+void TimerWheel::collect(std::vector<TimerEvent>& out) const {
+    out.assign(ready.begin(), ready.end());
+    for (const auto& level : slots) {
+        for (int32_t head : level) {
+            for (int32_t index = head; index >= 0; index = nodes[index].next) out.push_back(nodes[index].event);
+        }
+    }
+    std::sort(out.begin(), out.end(), firesBefore);
+}
+
+void TimerWheel::restore(uint32_t now, uint32_t nextSequence, const std::vector<TimerEvent>& events) {
+    reset(now);
+    sequence = nextSequence;
+    for (const TimerEvent& event : events) {
+        if (static_cast<int32_t>(event.due - current) <= 0) ready.push_back(event);
+        else insert(event);
+    }
+}
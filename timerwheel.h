@@ -0,0 +1,62 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstdint>
+#include <vector>
+#include "config.h"
+
+// Plain data so pending timers can go into snapshots and the rewind buffer.
+// kind and target mean whatever the owner wants them to.
+struct TimerEvent {
+    uint32_t due;
+    uint32_t sequence;
+    uint32_t kind;
+    uint32_t target;
+};
+
+// Hierarchical timer wheel over game milliseconds. Level 0 has one slot per
+// millisecond, each level above covers TIMER_WHEEL_SLOTS slots of the one
+// below and is cascaded down as time reaches it. Events due at the same
+// millisecond fire in the order they were scheduled. Nodes are pooled, so
+// nothing is allocated once the pool has grown to the busiest moment.
+class TimerWheel {
+public:
+    TimerWheel();
+
+    void reset(uint32_t now);
+    // Anything due at or before the current time fires on the next advance().
+    void schedule(uint32_t due, uint32_t kind, uint32_t target);
+    // Moves the wheel to now and appends every event due by then to fired.
+    void advance(uint32_t now, std::vector<TimerEvent>& fired);
+
+    uint32_t now() const { return current; }
+    size_t pending() const { return count + ready.size(); }
+
+    // Pending events in firing order, and the inverse for restoring them.
+    void collect(std::vector<TimerEvent>& out) const;
+    uint32_t nextSequence() const { return sequence; }
+    void restore(uint32_t now, uint32_t nextSequence, const std::vector<TimerEvent>& events);
+
+private:
+    static_assert(TIMER_WHEEL_SLOT_BITS * TIMER_WHEEL_LEVELS <= 32, "timer wheel must fit in 32-bit time");
+    static constexpr int TIMER_WHEEL_SLOTS = 1 << TIMER_WHEEL_SLOT_BITS;
+
+    struct Node {
+        TimerEvent event;
+        int32_t next;
+    };
+
+    void insert(const TimerEvent& event);
+    void cascade(int level);
+    int32_t allocateNode();
+
+    std::vector<Node> nodes;
+    int32_t freeList;
+    int32_t slots[TIMER_WHEEL_LEVELS][TIMER_WHEEL_SLOTS];
+    std::vector<TimerEvent> ready;
+    uint32_t current;
+    uint32_t sequence;
+    size_t count;
+};
+
+#endif
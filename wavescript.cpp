@@ -0,0 +1,196 @@
+#include "wavescript.h"
+#include "fixedpoint.h"
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+namespace {
+
+bool readCount(std::istringstream& in, int& value, int minimum) {
+    long v = 0;
+    if (!(in >> v) || v < minimum || v > 1000000) return false;
+    value = static_cast<int>(v);
+    return true;
+}
+
+bool readMs(std::istringstream& in, Uint32& value) {
+    int v = 0;
+    if (!readCount(in, v, 0)) return false;
+    value = static_cast<Uint32>(v);
+    return true;
+}
+
+bool readSwitch(std::istringstream& in, int& value) {
+    std::string word;
+    if (!(in >> word)) return false;
+    if (word == "on") value = 1;
+    else if (word == "off") value = 0;
+    else return false;
+    return true;
+}
+
+}
+
+WaveScript::WaveScript()
+    : startDelay(INITIAL_SPAWN_DELAY),
+      waveDelayMin(BASE_WAVE_DELAY), waveDelayMax(BASE_WAVE_DELAY + RANDOM_WAVE_DELAY - 1),
+      missileInterval(MISSILE_SPAWN_INTERVAL),
+      missilesStart(INITIAL_MISSILE_COUNT), missilesMax(MAX_MISSILE_COUNT),
+      rampMin(BASE_WAVES_UNTIL_INCREASE), rampMax(BASE_WAVES_UNTIL_INCREASE + RANDOM_WAVES_UNTIL_INCREASE - 1),
+      fastMissile{WAVE_START_FAST_MISSILE, WAVE_INTERVAL_FAST_MISSILE},
+      shark{WAVE_START_SHARK, WAVE_INTERVAL_SHARK},
+      missileSpeedMin(static_cast<int>(DEFAULT_MISSILE_SPEED)),
+      missileSpeedMax(static_cast<int>(DEFAULT_MISSILE_SPEED * (1.0f + MAX_MISSILE_SPEED_RANDOM_FACTOR))),
+      sharkLifetime(SHARK_LIFETIME), sharkFireInterval(SHARK_BULLET_INTERVAL) {}
+
+// One directive per line, '#' starts a comment:
+//   start_delay <ms>                  before the first wave's missiles
+//   wave_delay <min ms> <max ms>      between waves, drawn uniformly
+//   missile_interval <ms>             between missiles of a wave
+//   missiles <in first wave> <max>
+//   ramp <min waves> <max waves>      one more missile after that many waves
+//   fast_missile <first wave> <every>
+//   shark <first wave> <every>
+//   missile_speed <min px/s> <max px/s>   drawn uniformly per missile
+//   shark_timing <lifetime ms> <fire every ms>
+//   wave <n> [missiles <k>] [fast_missile on|off] [shark on|off] [delay <ms>]
+// On any error the whole script is rejected and the defaults stay.
+bool WaveScript::load(const std::string& path) {
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "Wave script " << path << " not found, using the built-in waves." << std::endl;
+        return false;
+    }
+
+    WaveScript parsed;
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line)) {
+        lineNumber++;
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream in(line);
+        std::string directive;
+        if (!(in >> directive)) continue;
+
+        bool ok = true;
+        if (directive == "start_delay") ok = readMs(in, parsed.startDelay);
+        else if (directive == "wave_delay") ok = readMs(in, parsed.waveDelayMin) && readMs(in, parsed.waveDelayMax) && parsed.waveDelayMax >= parsed.waveDelayMin;
+        else if (directive == "missile_interval") ok = readMs(in, parsed.missileInterval);
+        else if (directive == "missiles") ok = readCount(in, parsed.missilesStart, 1) && readCount(in, parsed.missilesMax, parsed.missilesStart);
+        else if (directive == "ramp") ok = readCount(in, parsed.rampMin, 1) && readCount(in, parsed.rampMax, parsed.rampMin);
+        else if (directive == "fast_missile") ok = readCount(in, parsed.fastMissile.firstWave, 0) && readCount(in, parsed.fastMissile.every, 1);
+        else if (directive == "shark") ok = readCount(in, parsed.shark.firstWave, 0) && readCount(in, parsed.shark.every, 1);
+        else if (directive == "missile_speed") ok = readCount(in, parsed.missileSpeedMin, 1) && readCount(in, parsed.missileSpeedMax, parsed.missileSpeedMin);
+        else if (directive == "shark_timing") ok = readMs(in, parsed.sharkLifetime) && readMs(in, parsed.sharkFireInterval) && parsed.sharkFireInterval > 0;
+        else if (directive == "wave") {
+            WaveOverride o = {0, -1, -1, -1, -1};
+            ok = readCount(in, o.wave, 0);
+            std::string key;
+            while (ok && in >> key) {
+                if (key == "missiles") ok = readCount(in, o.missiles, 0);
+                else if (key == "fast_missile") ok = readSwitch(in, o.fastMissile);
+                else if (key == "shark") ok = readSwitch(in, o.shark);
+                else if (key == "delay") ok = readCount(in, o.delay, 0);
+                else ok = false;
+            }
+            if (ok) parsed.overrides.push_back(o);
+        } else {
+            ok = false;
+        }
+
+        std::string trailing;
+        if (ok && in >> trailing) ok = false;
+        if (!ok) {
+            std::cerr << path << ":" << lineNumber << ": cannot read \"" << line << "\", using the built-in waves." << std::endl;
+            return false;
+        }
+    }
+
+    std::stable_sort(parsed.overrides.begin(), parsed.overrides.end(),
+                     [](const WaveOverride& a, const WaveOverride& b) { return a.wave < b.wave; });
+    *this = parsed;
+    return true;
+}
+
+WaveTimeline::WaveTimeline()
+    : script(nullptr), seed(0), base(0), cursor(0), nextWave(0), waveStart(0), missiles(0), nextRamp(0), nextOverride(0) {
+    events.reserve(WAVE_TIMELINE_RESERVE_EVENTS);
+}
+
+void WaveTimeline::start(const WaveScript& s, uint32_t runSeed) {
+    script = &s;
+    seed = runSeed;
+    rng.seed(runSeed);
+    events.clear();
+    base = 0;
+    cursor = 0;
+    nextWave = 0;
+    waveStart = 0;
+    missiles = s.missilesStart;
+    nextRamp = s.rampMin + static_cast<int>(randomBelow(rng, static_cast<uint32_t>(s.rampMax - s.rampMin + 1)));
+    nextOverride = 0;
+}
+
+bool WaveTimeline::seek(const WaveScript& s, uint32_t runSeed, uint32_t position) {
+    if (position > WAVE_TIMELINE_MAX_EVENTS) return false;
+    if (script != &s || seed != runSeed || position < base) start(s, runSeed);
+    while (base + events.size() <= position) refill();
+    cursor = position - base;
+    return true;
+}
+
+void WaveTimeline::refill() {
+    base += events.size();
+    events.clear();
+    cursor = 0;
+    compileWaves(WAVE_TIMELINE_BATCH);
+}
+
+bool WaveTimeline::isRuleWave(const WaveRule& rule, int wave) const {
+    return wave >= rule.firstWave && (wave - rule.firstWave) % rule.every == 0;
+}
+
+// A wave begins the moment the previous one has launched its last missile;
+// its specials appear right away and its missiles after the wave delay.
+// Everything is appended in time order, so the array never needs sorting.
+// Draws go through randomBelow so a seed gives the same waves whichever
+// standard library the game was built with.
+void WaveTimeline::compileWaves(int count) {
+    if (!script) return;
+    const WaveScript& s = *script;
+    auto ramp = [&] { return static_cast<int>(randomBelow(rng, static_cast<uint32_t>(s.rampMax - s.rampMin + 1))); };
+    auto waveDelay = [&] { return s.waveDelayMin + randomBelow(rng, s.waveDelayMax - s.waveDelayMin + 1); };
+
+    for (int n = 0; n < count; ++n) {
+        int wave = nextWave++;
+        if (wave > 0 && wave == nextRamp) {
+            missiles = std::min(missiles + 1, s.missilesMax);
+            nextRamp = wave + s.rampMin + ramp();
+        }
+        // Drawn for every wave so an override does not reshuffle the ones after it.
+        Uint32 delay = wave == 0 ? s.startDelay : waveDelay();
+
+        while (nextOverride < s.overrides.size() && s.overrides[nextOverride].wave < wave) nextOverride++;
+        const WaveOverride* o = nullptr;
+        if (nextOverride < s.overrides.size() && s.overrides[nextOverride].wave == wave) o = &s.overrides[nextOverride];
+
+        int waveMissiles = o && o->missiles >= 0 ? o->missiles : missiles;
+        bool fast = o && o->fastMissile >= 0 ? o->fastMissile != 0 : isRuleWave(s.fastMissile, wave);
+        bool shark = o && o->shark >= 0 ? o->shark != 0 : isRuleWave(s.shark, wave);
+        if (o && o->delay >= 0) delay = static_cast<Uint32>(o->delay);
+
+        events.push_back(SpawnEvent{waveStart, wave, waveMissiles, SpawnKind::Wave});
+        if (fast) events.push_back(SpawnEvent{waveStart, wave, 0, SpawnKind::FastMissile});
+        if (shark) events.push_back(SpawnEvent{waveStart, wave, 0, SpawnKind::Shark});
+
+        Uint32 time = waveStart + delay;
+        for (int i = 0; i < waveMissiles; ++i) {
+            events.push_back(SpawnEvent{time, wave, 0, SpawnKind::Missile});
+            if (i + 1 < waveMissiles) time += s.missileInterval;
+        }
+        // Keeps a script of empty, zero-delay waves from stalling the clock.
+        waveStart = std::max(time, waveStart + 1);
+    }
+}
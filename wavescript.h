@@ -0,0 +1,96 @@
+#ifndef WAVESCRIPT_H
+#define WAVESCRIPT_H
+
+#include <SDL2/SDL.h>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+#include "config.h"
+
+enum class SpawnKind : uint8_t {
+    Wave,
+    Missile,
+    FastMissile,
+    Shark
+};
+
+struct SpawnEvent {
+    Uint32 time;
+    int wave;
+    int missiles;
+    SpawnKind kind;
+};
+
+struct WaveRule {
+    int firstWave;
+    int every;
+};
+
+// Per-wave overrides from "wave <n> ..." lines; -1 leaves the rule in charge.
+struct WaveOverride {
+    int wave;
+    int missiles;
+    int fastMissile;
+    int shark;
+    int delay;
+};
+
+// Difficulty curve read from a text script. The defaults are the values in
+// config.h, so a missing script plays exactly like the built-in curve.
+struct WaveScript {
+    Uint32 startDelay;
+    Uint32 waveDelayMin, waveDelayMax;
+    Uint32 missileInterval;
+    int missilesStart, missilesMax;
+    int rampMin, rampMax;
+    WaveRule fastMissile;
+    WaveRule shark;
+    int missileSpeedMin, missileSpeedMax;
+    Uint32 sharkLifetime, sharkFireInterval;
+    std::vector<WaveOverride> overrides;
+
+    WaveScript();
+    bool load(const std::string& path);
+};
+
+// One run's spawns as a flat array sorted by game time, compiled from a
+// script and the run seed. The game walks it with a cursor; once the cursor
+// has consumed the array it is refilled in place with the next batch of
+// waves, so a run of any length reuses one allocation. The same seed always
+// yields the same sequence, which is what lets seek() rebuild any position.
+class WaveTimeline {
+public:
+    WaveTimeline();
+
+    void start(const WaveScript& script, uint32_t seed);
+    const SpawnEvent* next(Uint32 now) {
+        if (cursor == events.size()) refill();
+        if (cursor == events.size()) return nullptr;
+        return events[cursor].time <= now ? &events[cursor++] : nullptr;
+    }
+
+    uint32_t position() const { return static_cast<uint32_t>(base + cursor); }
+    // Stays within the current batch when it can; otherwise recompiles from
+    // the start of the run.
+    bool seek(const WaveScript& script, uint32_t seed, uint32_t position);
+
+private:
+    void refill();
+    void compileWaves(int count);
+    bool isRuleWave(const WaveRule& rule, int wave) const;
+
+    const WaveScript* script;
+    uint32_t seed;
+    std::mt19937 rng;
+    std::vector<SpawnEvent> events;
+    size_t base;
+    size_t cursor;
+    int nextWave;
+    Uint32 waveStart;
+    int missiles;
+    int nextRamp;
+    size_t nextOverride;
+};
+
+#endif